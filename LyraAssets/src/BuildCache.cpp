@@ -0,0 +1,96 @@
+#include "BuildCache.h"
+
+#include <Common/FileSystem.h>
+#include <Common/Logger.h>
+
+#include <LSD/Utility.h>
+
+#include <cstring>
+
+using namespace lsd::enum_operators;
+
+namespace {
+
+struct Header {
+	lyra::uint32 magic;
+	lyra::uint32 version;
+	lyra::uint64 entryCount;
+};
+
+// every entry is stored as the entry itself, followed by the size of the path and the path
+template <class Ty> bool readValue(const char*& it, const char* end, Ty& value) {
+	if (static_cast<lyra::size_type>(end - it) < sizeof(Ty)) return false;
+
+	std::memcpy(&value, it, sizeof(Ty));
+	it += sizeof(Ty);
+
+	return true;
+}
+
+}
+
+void BuildCache::load(const std::filesystem::path& path) {
+	m_entries.clear();
+
+	if (!std::filesystem::exists(path)) return;
+
+	lyra::MappedFile file(path);
+	auto it = file.begin();
+
+	Header header;
+	if (!readValue(it, file.end(), header) || header.magic != magic || header.version != version) {
+		lyra::log::warning("The build cache at path: {} is invalid or outdated, all assets will be rebuilt!", path.string());
+		return;
+	}
+
+	for (lyra::uint64 i = 0; i < header.entryCount; i++) {
+		Entry entry;
+		lyra::uint32 size;
+
+		if (!readValue(it, file.end(), entry) || !readValue(it, file.end(), size) || static_cast<lyra::size_type>(file.end() - it) < size) {
+			lyra::log::warning("The build cache at path: {} is truncated, all assets will be rebuilt!", path.string());
+			m_entries.clear();
+			return;
+		}
+
+		m_entries.emplace(std::string(it, size), entry);
+		it += size;
+	}
+}
+
+void BuildCache::save(const std::filesystem::path& path) const {
+	Header header { magic, version, m_entries.size() };
+
+	lyra::ByteFile file(path, lyra::OpenMode::write | lyra::OpenMode::binary, false);
+	file.write(&header, sizeof(Header), 1);
+
+	for (const auto& [name, entry] : m_entries) {
+		auto size = static_cast<lyra::uint32>(name.size());
+
+		file.write(&entry, sizeof(Entry), 1);
+		file.write(&size, sizeof(lyra::uint32), 1);
+		file.write(name.data(), name.size());
+	}
+
+	file.flush();
+}
+
+const BuildCache::Entry* BuildCache::find(const std::string& path) const {
+	auto it = m_entries.find(path);
+	return (it != m_entries.end()) ? &it->second : nullptr;
+}
+
+void BuildCache::update(const std::string& path, const Entry& entry) {
+	auto it = m_entries.find(path);
+
+	if (it != m_entries.end()) it->second = entry;
+	else m_entries.emplace(path, entry);
+}
+
+void BuildCache::erase(const std::string& path) {
+	m_entries.erase(path);
+}
+
+void BuildCache::clear() {
+	m_entries.clear();
+}
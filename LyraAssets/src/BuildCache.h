@@ -0,0 +1,47 @@
+/*************************
+ * @file BuildCache.h
+ * 
+ * @brief Records the state every asset was last built with, so unchanged assets can be skipped
+ *************************/
+
+#pragma once
+
+#include <Common/Common.h>
+
+#include <LSD/UnorderedSparseMap.h>
+
+#include <filesystem>
+#include <string>
+
+class BuildCache {
+public:
+	static constexpr lyra::uint32 magic = 0x4342594C; // "LYBC"
+	static constexpr lyra::uint32 version = 1;
+	static constexpr const char* extension = ".lycache";
+
+	struct Entry {
+		lyra::uint64 sourceHash;
+		lyra::uint64 settingsHash;
+
+		NODISCARD bool operator==(const Entry&) const noexcept = default;
+	};
+
+	using container_type = lsd::UnorderedSparseMap<std::string, Entry>;
+
+	BuildCache() = default;
+
+	void load(const std::filesystem::path& path);
+	void save(const std::filesystem::path& path) const;
+
+	NODISCARD const Entry* find(const std::string& path) const;
+	void update(const std::string& path, const Entry& entry);
+	void erase(const std::string& path);
+	void clear();
+
+	NODISCARD const container_type& entries() const noexcept {
+		return m_entries;
+	}
+
+private:
+	container_type m_entries;
+};
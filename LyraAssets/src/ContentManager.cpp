@@ -1,15 +1,25 @@
 #include "ContentManager.h"
+#include "TextureEncoder.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
 
+#include <Common/Hash.h>
 #include <Common/Logger.h>
 
+#include <Graphics/Mesh.h>
+
 #include <LSD/Utility.h>
 
 #include <portable-file-dialogs.h>
-#include <lz4.h>
 #include <stb_image.h>
 #include <tiny_gltf.h>
 
 #include <algorithm>
+#include <chrono>
+#include <set>
+#include <string>
+#include <string_view>
 
 #ifdef _WIN32
 #undef min
@@ -18,6 +28,110 @@
 
 using namespace lsd::enum_operators;
 
+namespace {
+
+// converts a single component of an accessor to a float, applying the normalization of integer components
+lyra::float32 readComponent(const unsigned char* data, int componentType, bool normalized) {
+	switch (componentType) {
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
+			auto value = *data;
+			return normalized ? static_cast<lyra::float32>(value) / 255.0f : static_cast<lyra::float32>(value);
+		}
+		case TINYGLTF_COMPONENT_TYPE_BYTE: {
+			auto value = static_cast<lyra::int8>(*data);
+			return normalized ? std::max(static_cast<lyra::float32>(value) / 127.0f, -1.0f) : static_cast<lyra::float32>(value);
+		}
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+			lyra::uint16 value;
+			std::memcpy(&value, data, sizeof(value));
+			return normalized ? static_cast<lyra::float32>(value) / 65535.0f : static_cast<lyra::float32>(value);
+		}
+		case TINYGLTF_COMPONENT_TYPE_SHORT: {
+			lyra::int16 value;
+			std::memcpy(&value, data, sizeof(value));
+			return normalized ? std::max(static_cast<lyra::float32>(value) / 32767.0f, -1.0f) : static_cast<lyra::float32>(value);
+		}
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: {
+			lyra::uint32 value;
+			std::memcpy(&value, data, sizeof(value));
+			return static_cast<lyra::float32>(value);
+		}
+		case TINYGLTF_COMPONENT_TYPE_FLOAT: {
+			lyra::float32 value;
+			std::memcpy(&value, data, sizeof(value));
+			return value;
+		}
+		default:
+			return 0.0f;
+	}
+}
+
+// reads up to four components of every element, components and elements missing in the accessor keep the fallback
+lsd::Vector<glm::vec4> readAccessor(const tinygltf::Model& model, int index, lyra::uint32 count, const glm::vec4& fallback) {
+	lsd::Vector<glm::vec4> elements(count, fallback);
+	if (index < 0) return elements;
+
+	const auto& accessor = model.accessors[index];
+	if (accessor.bufferView < 0) return elements; // accessors consisting only of sparse values are not supported
+
+	const auto& view = model.bufferViews[accessor.bufferView];
+	const auto* data = model.buffers[view.buffer].data.data() + view.byteOffset + accessor.byteOffset;
+
+	auto stride = accessor.ByteStride(view);
+	auto componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+	auto components = std::min(tinygltf::GetNumComponentsInType(accessor.type), 4);
+	if (stride <= 0 || componentSize <= 0 || components <= 0) return elements;
+
+	for (lyra::uint32 i = 0; i < std::min(count, static_cast<lyra::uint32>(accessor.count)); i++) {
+		for (int c = 0; c < components; c++) {
+			elements[i][c] = readComponent(data + i * stride + c * componentSize, accessor.componentType, accessor.normalized);
+		}
+	}
+
+	return elements;
+}
+
+// appends the indices of a primitive, primitives without indices get a sequential list
+void readIndices(const tinygltf::Model& model, int index, lyra::uint32 vertexCount, lsd::Vector<lyra::uint32>& indices) {
+	if (index < 0 || model.accessors[index].bufferView < 0) {
+		for (lyra::uint32 i = 0; i < vertexCount; i++) indices.pushBack(i);
+		return;
+	}
+
+	const auto& accessor = model.accessors[index];
+	const auto& view = model.bufferViews[accessor.bufferView];
+	const auto* data = model.buffers[view.buffer].data.data() + view.byteOffset + accessor.byteOffset;
+
+	auto stride = accessor.ByteStride(view);
+
+	for (lyra::uint32 i = 0; i < accessor.count; i++) {
+		const auto* element = data + i * stride;
+
+		switch (accessor.componentType) {
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+				indices.pushBack(*element);
+
+				break;
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+				lyra::uint16 value;
+				std::memcpy(&value, element, sizeof(value));
+				indices.pushBack(value);
+
+				break;
+			}
+			default: {
+				lyra::uint32 value;
+				std::memcpy(&value, element, sizeof(value));
+				indices.pushBack(value);
+
+				break;
+			}
+		}
+	}
+}
+
+}
+
 ContentManager::ContentManager() : m_recents(lsd::Json::array_type()) {
 	if (lyra::fileExists("data/recents.dat")) {
 		auto ss = lyra::StringStream("data/recents.dat", lyra::OpenMode::read | lyra::OpenMode::extend, false);
@@ -40,6 +154,8 @@ void ContentManager::loadProjectFile() {
 		m_recents.array().emplaceBack(lsd::Json::create(f[0].c_str()));
 		m_projectFilePath = f[0];
 		m_projectFile = lsd::Json::parse(lyra::StringStream(f[0], lyra::OpenMode::read).data());
+		addMissingSettings();
+		m_buildCache.load(cacheFilePath());
 
 		m_validProject = true;
 
@@ -53,6 +169,8 @@ void ContentManager::loadRecent(const std::filesystem::path& p) {
 
 		m_projectFilePath = p;
 		m_projectFile = lsd::Json::parse(lyra::StringStream(p, lyra::OpenMode::read).data());
+		addMissingSettings();
+		m_buildCache.load(cacheFilePath());
 
 		m_validProject = true;
 		unsaved = false;
@@ -90,6 +208,7 @@ void ContentManager::createProjectFile() {
 		s.write("{}", 2);
 		s.flush();
 		m_projectFile = lsd::Json::parse(s.data());
+		m_buildCache.clear();
 
 		m_validProject = true;
 		unsaved = true;
@@ -170,177 +289,528 @@ void ContentManager::loadFolder() {
 }
 
 void ContentManager::build() {
+	using lyra::resource::AssetIndex;
+
+	if (building()) return;
+
 	lyra::log::info("Starting Build...");
 
 	m_buildCancelled = false;
+	m_buildFailed = false;
+	m_buildProgress = 0;
+
+	removeStaleOutputs();
+
+	auto projectDirectory = std::filesystem::path(m_projectFilePath).remove_filename();
+
+	for (const auto& asset : m_projectFile) {
+		auto name = std::string(asset->name().cStr());
+		auto kind = AssetIndex::kind(name);
+		auto filepath = projectDirectory / name;
+
+		if ((kind != AssetIndex::Kind::texture && kind != AssetIndex::Kind::mesh) || !std::filesystem::exists(filepath)) continue;
+
+		// the cache is not modified until all tasks finished, so the entry can safely be referenced
+		m_buildFiles.pushBack(name);
+		m_buildTasks.pushBack(m_workers.enqueue([this, filepath, settings = buildSettings(*asset, kind), cached = m_buildCache.find(name)]() {
+			auto result = buildAsset(filepath, settings, cached);
+			m_buildProgress++;
+			return result;
+		}));
+	}
+
+	if (m_buildTasks.empty()) finishBuild();
+}
+
+void ContentManager::update() {
+	if (!building()) return;
 
-	lyra::uint32 i = 0;
-
-	while (m_buildCancelled == false && i < m_newFiles.size()) {
-		auto ext = m_newFiles[i].extension();
-		auto filepath = std::filesystem::path(m_projectFilePath).remove_filename() /= m_newFiles[i];
-		auto concat = filepath;
-		auto& js = m_projectFile.child(m_newFiles[i].generic_string().c_str());
-		concat.concat(".dat");
-
-		if (ext == ".png" || ext == ".bmp" || ext == ".jpg" || ext == ".jpeg" || ext == ".psd") {
-			lyra::log::debug("\tTexture: {}", filepath.string());
-
-			int width, height, channels;
-			lyra::uint8* data = stbi_load_from_file(
-				lyra::ByteFile(filepath, 
-				lyra::OpenMode::read | lyra::OpenMode::binary).stream(),
-				&width, 
-				&height, 
-				&channels, 
-				4
-			);
-			
-			auto totalSize = width * height * sizeof(lyra::uint8) * 4;
-			
-			js.child("Uncompressed") = static_cast<lyra::uint32>(totalSize);
-			js.child("Width") = static_cast<lyra::uint32>(width);
-			js.child("Height") = static_cast<lyra::uint32>(height);
-			js.child("Mipmap") = static_cast<lyra::uint32>(std::max(static_cast<int>(std::floor(std::log2(std::max(width, height)))) - 3, 1)); 
-
-			lsd::Vector<char> result(LZ4_compressBound(static_cast<int>(totalSize)));
-			result.resize(LZ4_compress_default(reinterpret_cast<char*>(data), result.data(), static_cast<int>(totalSize), static_cast<lyra::uint32>(result.size())));
-
-			lyra::ByteFile buildFile(concat, lyra::OpenMode::write | lyra::OpenMode::binary, false);
-			buildFile.write(
-				result.data(), 
-				sizeof(lyra::uint8), 
-				result.size()
-			);
+	for (const auto& task : m_buildTasks) {
+		if (task.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+	}
+
+	finishBuild();
+}
+
+void ContentManager::wait() {
+	for (const auto& task : m_buildTasks) task.wait();
+
+	update();
+}
+
+ContentManager::BuildResult ContentManager::buildAsset(const std::filesystem::path& filepath, const BuildSettings& settings, const BuildCache::Entry* cached) {
+	BuildResult result;
+
+	if (m_buildCancelled) return result;
+
+	// the source may have been edited since it was last mapped, so it is mapped again and imported from the same mapping it was hashed from
+	lyra::MappedFile source(filepath, false);
+	result.cache = { lyra::hashBytes(source.data(), source.size()), settings.hash };
+
+	if (cached && *cached == result.cache && std::filesystem::exists(std::filesystem::path(filepath).concat(".dat"))) {
+		result.skipped = true;
+		return result;
+	}
+
+	auto ext = filepath.extension();
+	auto concat = filepath;
+	concat.concat(".dat");
 
+	if (ext == ".png" || ext == ".bmp" || ext == ".jpg" || ext == ".jpeg" || ext == ".psd") {
+		lyra::log::debug("\tTexture: {}", filepath.string());
+
+		int width, height, channels;
+		lyra::uint8* data = stbi_load_from_memory(
+			reinterpret_cast<const stbi_uc*>(source.data()),
+			static_cast<int>(source.size()),
+			&width, 
+			&height, 
+			&channels, 
+			4
+		);
+
+		if (!data) {
+			lyra::log::error("Failed to load texture at path: {} with error: {}!", filepath.string(), stbi_failure_reason());
+			return result;
+		}
+		
+		if (m_buildCancelled) {
 			stbi_image_free(data);
-		} else if (ext == ".glb") {
-			/**
-			lyra::log::debug("\tModel: {}", filepath.string());
+			return result;
+		}
 
-			tinygltf::TinyGLTF importer;
+		auto mipmap = static_cast<lyra::uint32>(std::max(static_cast<int>(std::floor(std::log2(std::max(width, height)))) - 3, 1));
+		auto format = texture::selectFormat(static_cast<texture::Encoding>(settings.encoding), settings.type);
 
-			tinygltf::Model model;
+		// the whole mip chain is generated and block compressed here, so the engine only has to copy it into the image
+		auto encoded = texture::encode(data, static_cast<lyra::uint32>(width), static_cast<lyra::uint32>(height), mipmap, settings.type, format, &m_workers);
 
-			lsd::String warn, err;
+		stbi_image_free(data);
 
-			lyra::FileStream<Vector, unsigned char> modelData(filepath, lyra::OpenMode::read | lyra::OpenMode::binary, false);
+		if (m_buildCancelled) return result;
+		
+		result.fields.pushBack({ "Uncompressed", static_cast<lyra::uint32>(encoded.size()) });
+		result.fields.pushBack({ "Width", static_cast<lyra::uint32>(width) });
+		result.fields.pushBack({ "Height", static_cast<lyra::uint32>(height) });
+		result.fields.pushBack({ "Mipmap", mipmap }); 
+		result.fields.pushBack({ "Format", static_cast<lyra::uint32>(format) });
+
+		// large textures are split into blocks compressed on the other workers as well, since high compression levels are slow
+		auto compressed = lyra::resource::compress(encoded.data(), encoded.size(), settings.compression, settings.blockSize, &m_workers);
+
+		if (m_buildCancelled) return result;
+
+		lyra::ByteFile buildFile(concat, lyra::OpenMode::write | lyra::OpenMode::binary, false);
+		buildFile.write(
+			compressed.data(), 
+			sizeof(lyra::uint8), 
+			compressed.size()
+		);
+		buildFile.flush();
+
+		result.built = true;
+	} else if (ext == ".glb") {
+		lyra::log::debug("\tModel: {}", filepath.string());
 
-			ASSERT(importer.LoadBinaryFromMemory(&model, &err, &warn, modelData.data().data(), static_cast<lyra::uint32>(modelData.data().size())), "A fatal error occured whilst importing an mesh!");
+		tinygltf::TinyGLTF importer;
+		tinygltf::Model model;
+		std::string warn, err;
 
-			if (!warn.empty()) lyra::log::warning("A warning occured whilst importing a mesh: {}", warn);
-			if (!err.empty()) lyra::log::error("An error occured whilst importing a mesh: {}", err);
+		if (!importer.LoadBinaryFromMemory(&model, &err, &warn, reinterpret_cast<const unsigned char*>(source.data()), static_cast<unsigned int>(source.size()))) {
+			lyra::log::error("Failed to load model at path: {} with error: {}!", filepath.string(), err);
+			return result;
+		}
 
-			lsd::Vector<lsd::Array<lsd::Array<lyra::float32, 3>, 4>> vertexBlock;
-			lsd::Vector<lyra::uint32> indexBlock;
-			
-			auto loopNodes = [&model](lsd::Json* const js, const tinygltf::Node& node, glm::mat4 transform, auto&& loopNodes) -> void {
-				for (const auto& node : model.nodes) {
-					
-					//loopNodes(transform, loopNodes);
+		if (!warn.empty()) lyra::log::warning("A warning occured whilst importing model at path: {}: {}", filepath.string(), warn);
+
+		// every vertex block is stored with the bounds it was quantized with and the errors of its levels of detail, followed by all index blocks
+		// the levels of detail of a vertex block are consecutive index blocks, starting with the original mesh
+		// the index blocks are as wide as the indices their vertex block needs, 16 bit for vertex blocks which 16 bit indices can address
+		// the meshlets of every index block are stored after all index blocks
+		lsd::Vector<char> data;
+		lsd::Vector<char> indexData;
+		lsd::Vector<lsd::Vector<lyra::Meshlet>> meshletData;
+		lsd::Vector<lyra::uint32> vertexBlocks;
+		lsd::Vector<lyra::uint32> indexBlocks;
+
+		// the transforms of the nodes are not applied, every primitive is built in the space of its mesh
+		for (const auto& gltfMesh : model.meshes) {
+			for (const auto& primitive : gltfMesh.primitives) {
+				if (m_buildCancelled) return result;
+
+				if (primitive.mode != TINYGLTF_MODE_TRIANGLES && primitive.mode != -1) {
+					lyra::log::warning("Skipped primitive of mesh: {} in model at path: {}, since it does not consist of triangles!", gltfMesh.name, filepath.string());
+					continue;
 				}
-			};
-			
-			glm::mat4 transform(1.0f);
-			
-			for (const auto& node : model.nodes) {
-				loopNodes(js, node, transform, loopNodes);
-			}
-			
-			for (const auto& mesh : model.mesh) {
-				lyra::uint32 indices = mesh->mNumFaces * 3;
-				indexBlock.reserve(indices);
-				
-				vertexBlock.reserve(vertexBlock.size() + mesh->mNumVertices);
-				
-				for (lyra::uint32 j = 0; j < mesh->mNumVertices; j++) {
-					vertexBlock.pushBack({{
-						{{
-							mesh->mVertices[j].x,
-							mesh->mVertices[j].y,
-							mesh->mVertices[j].z
-						}},
-						{{
-							(mesh->HasNormals()) ? mesh->mNormals[j].x : 0.0f,
-							(mesh->HasNormals()) ? mesh->mNormals[j].y : 0.0f,
-							(mesh->HasNormals()) ? mesh->mNormals[j].z : 1.0f
-						}},
-						{{
-							(mesh->HasVertexColors(0)) ? mesh->mColors[0][j].r : 0.0f,
-							(mesh->HasVertexColors(0)) ? mesh->mColors[0][j].g : 0.0f,
-							(mesh->HasVertexColors(0)) ? mesh->mColors[0][j].b : 0.0f
-						}},
-						{{
-							(mesh->HasTextureCoords(0)) ? mesh->mTextureCoords[0][j].x : 0.0f,
-							(mesh->HasTextureCoords(0)) ? mesh->mTextureCoords[0][j].y : 0.0f,
-							static_cast<lyra::float32>(mesh->mMaterialIndex)
-						}}
-					}});
+
+				auto attribute = [&primitive](const char* name) {
+					auto it = primitive.attributes.find(name);
+					return (it == primitive.attributes.end()) ? -1 : it->second;
+				};
+
+				auto position = attribute("POSITION");
+				if (position < 0) continue;
+
+				auto count = static_cast<lyra::uint32>(model.accessors[position].count);
+				auto positions = readAccessor(model, position, count, glm::vec4(0.0f));
+				auto normals = readAccessor(model, attribute("NORMAL"), count, glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
+				auto colors = readAccessor(model, attribute("COLOR_0"), count, glm::vec4(1.0f));
+				auto texCoords = readAccessor(model, attribute("TEXCOORD_0"), count, glm::vec4(0.0f));
+
+				auto material = static_cast<lyra::float32>(std::max(primitive.material, 0));
+
+				lsd::Vector<lyra::Mesh::Vertex> vertices;
+				vertices.reserve(count);
+
+				for (lyra::uint32 i = 0; i < count; i++) {
+					vertices.pushBack({
+						glm::vec3(positions[i]),
+						glm::vec3(normals[i]),
+						glm::vec3(colors[i]),
+						glm::vec3(texCoords[i].x, texCoords[i].y, material)
+					});
+				}
+
+				lsd::Vector<lyra::uint32> indices;
+				readIndices(model, primitive.indices, count, indices);
+				indices.resize(indices.size() - indices.size() % 3);
+
+				if (std::any_of(indices.begin(), indices.end(), [count](lyra::uint32 index) { return index >= count; })) {
+					lyra::log::error("Primitive of mesh: {} in model at path: {} references vertices out of range!", gltfMesh.name, filepath.string());
+					return result;
+				}
+
+				// the import order is rarely good for the GPU, so the triangles and vertices are reordered for the post transform cache, overdraw and vertex fetch
+				auto before = mesh::analyzeVertexCache(indices, count);
+				mesh::optimize(vertices, indices);
+				auto after = mesh::analyzeVertexCache(indices, static_cast<lyra::uint32>(vertices.size()));
+
+				lyra::log::debug(
+					"\t\tMesh: {}, vertices: {} -> {}, triangles: {}, ACMR: {:.3f} -> {:.3f}, ATVR: {:.3f} -> {:.3f}",
+					gltfMesh.name,
+					count,
+					vertices.size(),
+					indices.size() / 3,
+					before.acmr,
+					after.acmr,
+					before.atvr,
+					after.atvr
+				);
+
+				// the simplified levels index the same vertices, so they only cost the memory of their indices
+				auto lods = mesh::generateLods(vertices, indices, lyra::config::maxMeshLods);
+				auto lodCount = static_cast<lyra::uint32>(lods.size());
+
+				lyra::log::debug("\t\tMesh: {}, levels of detail: {}, triangles of the last level: {}, error: {:.4f}", gltfMesh.name, lodCount, lods.back().indices.size() / 3, lods.back().error);
+
+				auto bounds = lyra::Mesh::calculateBounds(vertices);
+				auto packed = lyra::Mesh::pack(vertices, bounds);
+
+				auto offset = data.size();
+				data.resize(offset + sizeof(lyra::BoundingVolume) + sizeof(lyra::uint32) + lodCount * sizeof(lyra::float32) + packed.size() * sizeof(lyra::Mesh::PackedVertex));
+
+				std::memcpy(&data[offset], &bounds, sizeof(lyra::BoundingVolume));
+				offset += sizeof(lyra::BoundingVolume);
+				std::memcpy(&data[offset], &lodCount, sizeof(lyra::uint32));
+				offset += sizeof(lyra::uint32);
+
+				for (const auto& lod : lods) {
+					std::memcpy(&data[offset], &lod.error, sizeof(lyra::float32));
+					offset += sizeof(lyra::float32);
 				}
-				
-				for (lyra::uint32 j = 0; j < mesh->mNumFaces; j++) {
-					const auto* face = &mesh->mFaces[j];
-					
-					for (lyra::uint32 i = 0; i < 3; i++) {
-						indexBlock.pushBack(face->mIndices[i]);
+
+				std::memcpy(&data[offset], packed.data(), packed.size() * sizeof(lyra::Mesh::PackedVertex));
+
+				vertexBlocks.pushBack(static_cast<lyra::uint32>(vertices.size()));
+
+				auto indexType = lyra::Mesh::selectIndexType(vertices.size());
+				auto indexSize = lyra::Mesh::indexSize(indexType);
+
+				for (const auto& lod : lods) {
+					auto indexOffset = indexData.size();
+					indexData.resize(indexOffset + lod.indices.size() * indexSize);
+
+					for (auto index : lod.indices) {
+						if (indexType == VK_INDEX_TYPE_UINT16) {
+							auto shortIndex = static_cast<lyra::uint16>(index);
+							std::memcpy(&indexData[indexOffset], &shortIndex, sizeof(lyra::uint16));
+						} else {
+							std::memcpy(&indexData[indexOffset], &index, sizeof(lyra::uint32));
+						}
+
+						indexOffset += indexSize;
 					}
+
+					indexBlocks.pushBack(static_cast<lyra::uint32>(lod.indices.size()));
+
+					meshletData.pushBack(mesh::buildMeshlets(vertices, lod.indices));
 				}
 
-				jsVertexBlocks.pushBack(js->operator[]("VertexBlocks").insert(static_cast<lyra::uint32>(mesh->mNumVertices)));
-				jsIndexBlocks.pushBack(js->operator[]("IndexBlocks").insert(static_cast<lyra::uint32>(indices)));
+				lyra::log::debug(
+					"\t\tMesh: {}, meshlets of the first level: {}, index size: {} bytes",
+					gltfMesh.name,
+					meshletData[meshletData.size() - lodCount].size(),
+					indexSize
+				);
 			}
-			
-			auto vertexBlockSize = vertexBlock.size() * sizeof(lyra::float32) * 3 * 4;
-			auto indexBlockSize = indexBlock.size() * sizeof(lyra::uint32);
-			auto totalSize = vertexBlockSize + indexBlockSize;
-			
-			js->operator[]("Uncompressed").get<lyra::uint32>() = static_cast<lyra::uint32>(totalSize);
-
-			lsd::Vector<char> data(totalSize);
-			std::memcpy(data.data(), vertexBlock.data(), vertexBlockSize);
-			std::memcpy(data.data() + vertexBlockSize, indexBlock.data(), indexBlockSize);
-			
-			lsd::Vector<char> result(LZ4_compressBound(static_cast<lyra::uint32>(data.size())));
-			result.resize(LZ4_compress_default(data.data(), result.data(), static_cast<lyra::uint32>(data.size()), static_cast<lyra::uint32>(result.size())));
-
-			lyra::ByteFile buildFile(concat, lyra::OpenMode::write | lyra::OpenMode::binary, false);
-
-			buildFile.write(
-				result.data(), 
-				sizeof(char),
-				result.size()
-			);
-			*/
-		} else if (ext == ".ttf") {
-			
-		} else if (ext == ".ogg" || ext == ".wav") {
+		}
+
+		if (vertexBlocks.empty()) {
+			lyra::log::error("Model at path: {} does not contain any triangle meshes!", filepath.string());
+			return result;
+		}
 
+		auto offset = data.size();
+		data.resize(offset + indexData.size());
+		std::memcpy(&data[offset], indexData.data(), indexData.size());
+
+		for (const auto& meshlets : meshletData) {
+			auto meshletCount = static_cast<lyra::uint32>(meshlets.size());
+
+			offset = data.size();
+			data.resize(offset + sizeof(lyra::uint32) + meshletCount * sizeof(lyra::Meshlet));
+			std::memcpy(&data[offset], &meshletCount, sizeof(lyra::uint32));
+			std::memcpy(&data[offset + sizeof(lyra::uint32)], meshlets.data(), meshletCount * sizeof(lyra::Meshlet));
 		}
 
-		++i;
+		result.fields.pushBack({ "Uncompressed", static_cast<lyra::uint32>(data.size()) });
+		result.fields.pushBack({ "Type", lyra::Mesh::PackedVertex::layout });
+		result.arrays.pushBack({ "VertexBlocks", std::move(vertexBlocks) });
+		result.arrays.pushBack({ "IndexBlocks", std::move(indexBlocks) });
+
+		auto compressed = lyra::resource::compress(data.data(), data.size(), settings.compression, settings.blockSize, &m_workers);
+
+		if (m_buildCancelled) return result;
+
+		lyra::ByteFile buildFile(concat, lyra::OpenMode::write | lyra::OpenMode::binary, false);
+		buildFile.write(
+			compressed.data(), 
+			sizeof(lyra::uint8), 
+			compressed.size()
+		);
+		buildFile.flush();
+
+		result.built = true;
+	} else if (ext == ".ttf") {
+		
+	} else if (ext == ".ogg" || ext == ".wav") {
+
+	}
+
+	return result;
+}
+
+void ContentManager::finishBuild() {
+	// merge the results in the order the files were queued, so the project file is identical regardless of which task finished first
+	lyra::uint32 built = 0, skipped = 0, failed = 0;
+
+	for (lyra::uint32 i = 0; i < m_buildFiles.size(); i++) {
+		auto result = m_buildTasks[i].get();
+
+		if (result.skipped) {
+			skipped++;
+		} else if (result.built) {
+			auto& js = m_projectFile.child(m_buildFiles[i].c_str());
+			for (const auto& field : result.fields) js.child(field.first) = field.second;
+
+			for (const auto& [name, values] : result.arrays) {
+				auto& array = js.child(name);
+				array = lsd::Json::array_type();
+
+				for (auto value : values) array.array().emplaceBack(lsd::Json::create(value));
+			}
+
+			m_buildCache.update(m_buildFiles[i], result.cache);
+			built++;
+		} else {
+			// never keep a stale entry around for an asset whose output may be incomplete
+			m_buildCache.erase(m_buildFiles[i]);
+			if (!m_buildCancelled) failed++;
+		}
 	}
 
-	m_newFiles.clear();
+	m_buildTasks.clear();
+	m_buildFiles.clear();
+	m_buildFailed = failed != 0;
+
 	unsaved = true;
 	save();
 
-	lyra::log::info("Build successful!");
+	m_buildCache.save(cacheFilePath());
+	writeIndex();
+	writeArchive();
+
+	if (m_buildCancelled) lyra::log::warning("Build cancelled after building {} assets!", built);
+	else if (m_buildFailed) lyra::log::error("Build finished, but {} assets failed to build!", failed);
+	else lyra::log::info("Build successful! Built {} assets, {} were already up to date.", built, skipped);
 }
 
-void ContentManager::rebuild() {
-	m_buildCancelled = false;
+void ContentManager::removeStaleOutputs() {
+	using lyra::resource::AssetIndex;
 
-	clean();
+	auto projectDirectory = std::filesystem::path(m_projectFilePath).remove_filename();
+
+	auto removeOutputs = [&](const std::string& name) {
+		auto output = projectDirectory / name;
+		output.concat(".dat");
+
+		if (std::filesystem::remove(output)) lyra::log::info("\tRemoved outputs of asset: {}", name);
+		m_buildCache.erase(name);
+	};
+
+	std::set<std::string> assets;
 
-	m_newFiles.clear();
-	for (const auto& path : m_projectFile) {
-		m_newFiles.pushBack(path->name().cStr());
+	for (const auto& asset : m_projectFile) {
+		auto name = std::string(asset->name().cStr());
+		assets.insert(name);
+
+		auto kind = AssetIndex::kind(name);
+		if ((kind == AssetIndex::Kind::texture || kind == AssetIndex::Kind::mesh) && !std::filesystem::exists(projectDirectory / name)) {
+			lyra::log::warning("The source file of asset: {} was deleted!", name);
+			removeOutputs(name);
+		}
 	}
-	
+
+	// assets which were removed from the project since the last build
+	lsd::Vector<std::string> removed;
+	for (const auto& entry : m_buildCache.entries()) {
+		if (!assets.contains(entry.first)) removed.pushBack(entry.first);
+	}
+
+	for (const auto& name : removed) removeOutputs(name);
+}
+
+ContentManager::BuildSettings ContentManager::buildSettings(const lsd::Json& js, lyra::resource::AssetIndex::Kind kind) {
+	using lyra::resource::AssetIndex;
+
+	static constexpr lsd::Array<const char*, 2> compressionSettings { "Compression", "BlockSize" };
+	static constexpr lsd::Array<const char*, 5> textureSettings { "Type", "Alpha", "Dimension", "Wrap", "Encoding" };
+
+	BuildSettings settings {
+		js.child("Compression").get<lyra::uint32>(),
+		js.child("BlockSize").get<lyra::uint32>(),
+		0,
+		0,
+		lyra::hashCombine(lyra::fnvOffsetBasis, builderVersion)
+	};
+
+	auto addSettings = [&](const auto& names) {
+		for (const auto& name : names) settings.hash = lyra::hashCombine(lyra::hashBytes(name, settings.hash), js.child(name).get<lyra::uint32>());
+	};
+
+	addSettings(compressionSettings);
+
+	switch (kind) {
+		case AssetIndex::Kind::texture:
+			settings.type = js.child("Type").get<lyra::uint32>();
+			settings.encoding = js.child("Encoding").get<lyra::uint32>();
+
+			addSettings(textureSettings);
+			break;
+
+		case AssetIndex::Kind::mesh:
+			// meshes are packed with the vertex formats selected in the engine config
+			settings.hash = lyra::hashCombine(settings.hash, lyra::Mesh::PackedVertex::layout);
+			break;
+
+		default:
+			break;
+	}
+
+	return settings;
+}
+
+void ContentManager::writeIndex() {
+	lyra::log::info("Writing asset index...");
+
+	auto index = lyra::resource::AssetIndex::build(m_projectFile);
+
+	lyra::ByteFile indexFile(indexFilePath(), lyra::OpenMode::write | lyra::OpenMode::binary, false);
+	indexFile.write(index.data(), index.size());
+	indexFile.flush();
+}
+
+void ContentManager::writeArchive() {
+	using lyra::resource::AssetArchive;
+
+	lyra::log::info("Packing built assets...");
+
+	// the size and data of an entry come from the same mapping, so a file rebuilt in the meantime cannot make them disagree
+	struct PackedFile {
+		std::string path;
+		lyra::MappedFile data;
+	};
+
+	auto projectDirectory = std::filesystem::path(m_projectFilePath).remove_filename();
+
+	lsd::Vector<PackedFile> files;
+	for (const auto& asset : m_projectFile) {
+		auto file = projectDirectory / asset->name().cStr();
+		file.concat(".dat");
+
+		if (std::filesystem::exists(file)) files.pushBack({ asset->name().cStr(), lyra::MappedFile(file, false) });
+	}
+
+	AssetArchive::Header header { 
+		AssetArchive::magic, 
+		AssetArchive::version, 
+		static_cast<lyra::uint32>(files.size()), 
+		AssetArchive::alignment, 
+		sizeof(AssetArchive::Header), 
+		sizeof(AssetArchive::Header) + files.size() * sizeof(AssetArchive::Entry), 
+		0, 
+		0 
+	};
+
+	// the data is laid out in project order, so assets loaded together are read sequentially
+	lsd::Vector<AssetArchive::Entry> entries;
+	std::string strings;
+
+	for (const auto& file : files) {
+		entries.pushBack({ lyra::hashBytes(file.path), 0, file.data.size(), static_cast<lyra::uint32>(strings.size()), static_cast<lyra::uint32>(file.path.size()) });
+		strings.append(file.path);
+	}
+
+	header.stringsSize = strings.size();
+	header.dataOffset = AssetArchive::alignUp(header.stringsOffset + header.stringsSize);
+
+	auto offset = header.dataOffset;
+	for (auto& entry : entries) {
+		entry.offset = offset;
+		offset = AssetArchive::alignUp(offset + entry.size);
+	}
+
+	auto toc = entries;
+	std::stable_sort(toc.begin(), toc.end(), [](const auto& a, const auto& b) { return a.hash < b.hash; });
+
+	static constexpr lsd::Array<char, AssetArchive::alignment> padding { };
+
+	lyra::ByteFile archiveFile(archiveFilePath(), lyra::OpenMode::write | lyra::OpenMode::binary, false);
+	archiveFile.write(&header, sizeof(header), 1);
+	archiveFile.write(toc.data(), sizeof(AssetArchive::Entry), toc.size());
+	archiveFile.write(strings.data(), strings.size());
+	archiveFile.write(padding.data(), header.dataOffset - header.stringsOffset - header.stringsSize);
+
+	for (lyra::uint32 i = 0; i < files.size(); i++) {
+		archiveFile.write(files[i].data.data(), files[i].data.size());
+		archiveFile.write(padding.data(), AssetArchive::alignUp(entries[i].size) - entries[i].size);
+	}
+
+	archiveFile.flush();
+
+	lyra::log::info("Packed {} assets into archive at path: {}!", files.size(), archiveFilePath().string());
+}
+
+void ContentManager::rebuild() {
+	if (building()) return;
+
+	clean();
 	build();
 }
 
 void ContentManager::clean() {
+	if (building()) return;
+
 	auto loopF = [&](const std::filesystem::path& p, auto&& loopF) -> void {
 		for (const auto& f : std::filesystem::directory_iterator(p)) {
 			if (f.is_directory()) {
@@ -356,6 +826,12 @@ void ContentManager::clean() {
 
 	auto projectDirectory = m_projectFilePath;
 	loopF(lyra::absolutePath(projectDirectory.remove_filename()), loopF);
+
+	std::filesystem::remove(lyra::absolutePath(indexFilePath()));
+	std::filesystem::remove(lyra::absolutePath(archiveFilePath()));
+	std::filesystem::remove(lyra::absolutePath(cacheFilePath()));
+
+	m_buildCache.clear();
 }
 
 void ContentManager::cancel() {
@@ -363,6 +839,11 @@ void ContentManager::cancel() {
 }
 
 bool ContentManager::close() {
+	if (building()) {
+		cancel();
+		wait();
+	}
+
 	if (unsaved) {
 		auto r = pfd::message("Unsaved Changes!", "You still have unsaved changes, do you still want to proceed?", pfd::choice::ok_cancel, pfd::icon::warning).result();
 		if (r == pfd::button::cancel) return false;
@@ -376,6 +857,38 @@ bool ContentManager::close() {
 	return true;
 }
 
+void ContentManager::addMissingSettings() {
+	using lyra::resource::AssetIndex;
+
+	for (auto& asset : m_projectFile) {
+		auto kind = AssetIndex::kind(asset->name().cStr());
+		if (kind != AssetIndex::Kind::texture && kind != AssetIndex::Kind::mesh) continue;
+
+		bool compression = false, blockSize = false, encoding = false, type = false, vertexBlocks = false, indexBlocks = false;
+
+		for (const auto& setting : *asset) {
+			std::string_view name = setting->name().cStr();
+
+			if (name == "Compression") compression = true;
+			else if (name == "BlockSize") blockSize = true;
+			else if (name == "Encoding") encoding = true;
+			else if (name == "Type") type = true;
+			else if (name == "VertexBlocks") vertexBlocks = true;
+			else if (name == "IndexBlocks") indexBlocks = true;
+		}
+
+		if (!compression) asset->emplace("Compression", 0U);
+		if (!blockSize) asset->emplace("BlockSize", lyra::resource::defaultBlockSize);
+		if (!encoding && kind == AssetIndex::Kind::texture) asset->emplace("Encoding", 0U);
+
+		if (kind == AssetIndex::Kind::mesh) {
+			if (!type) asset->emplace("Type", 0U);
+			if (!vertexBlocks) asset->emplace("VertexBlocks", lsd::Json::array_type());
+			if (!indexBlocks) asset->emplace("IndexBlocks", lsd::Json::array_type());
+		}
+	}
+}
+
 void ContentManager::loadItem(const std::filesystem::path& path) {
 	auto rel = std::filesystem::relative(path, std::filesystem::path(m_projectFilePath).remove_filename());
 	auto ext = path.extension();
@@ -395,8 +908,17 @@ void ContentManager::loadItem(const std::filesystem::path& path) {
 		js.emplace("Mipmap", 0U);
 		js.emplace("Dimension", 1U);
 		js.emplace("Wrap", 0U);
+		js.emplace("Encoding", 0U);
+		js.emplace("Format", 0U);
+		js.emplace("Compression", 0U);
+		js.emplace("BlockSize", lyra::resource::defaultBlockSize);
 	} else if (ext == ".glb") {
 		js.emplace("Uncompressed", 0U);
+		js.emplace("Type", 0U);
+		js.emplace("VertexBlocks", lsd::Json::array_type());
+		js.emplace("IndexBlocks", lsd::Json::array_type());
+		js.emplace("Compression", 0U);
+		js.emplace("BlockSize", lyra::resource::defaultBlockSize);
 	} else if (ext == ".ttf") {
 
 	} else if (ext == ".ogg" || ext == ".wav") {
@@ -406,6 +928,4 @@ void ContentManager::loadItem(const std::filesystem::path& path) {
 	} else if (ext == ".lua" || ext == ".txt" || ext == ".json") {
 
 	} 
-
-	m_newFiles.pushBack(rel);
 }
@@ -12,16 +12,27 @@
 #pragma once
 
 #include "IconsCodicons.h"
+#include "BuildCache.h"
 
 #include <Lyra/Lyra.h>
 
 #include <Common/FileSystem.h>
+#include <Common/ThreadPool.h>
+#include <Resource/AssetArchive.h>
+#include <Resource/Compression.h>
+#include <Resource/AssetIndex.h>
 #include <LSD/JSON.h>
 
+#include <atomic>
 #include <filesystem>
+#include <future>
+#include <utility>
 
 class ContentManager {
 public:
+	// increment whenever the format of the built files changes, so every cached asset is rebuilt
+	static constexpr lyra::uint32 builderVersion = 8;
+
 	ContentManager();
 
 	void loadProjectFile();
@@ -34,10 +45,15 @@ public:
 	void loadItem();
 	void loadFolder();
 
+	// builds run on worker threads, update() has to be called regularly to merge the results once all assets finished building
+	// only assets whose source or import settings changed since the last build are built again
 	void build();
 	void rebuild();
 	void clean();
 	void cancel();
+	void update();
+	// block until the current build finished and merge its results
+	void wait();
 
 	bool close();
 
@@ -53,22 +69,80 @@ public:
 	NODISCARD std::filesystem::path projectFilePath() const noexcept {
 		return m_projectFilePath;
 	}
+	NODISCARD std::filesystem::path indexFilePath() const {
+		return std::filesystem::path(m_projectFilePath).replace_extension(lyra::resource::AssetIndex::extension);
+	}
+	NODISCARD std::filesystem::path cacheFilePath() const {
+		return std::filesystem::path(m_projectFilePath).replace_extension(BuildCache::extension);
+	}
+	NODISCARD std::filesystem::path archiveFilePath() const {
+		return std::filesystem::path(m_projectFilePath).replace_extension(lyra::resource::AssetArchive::extension);
+	}
 	bool validProject() const noexcept {
 		return m_validProject;
 	}
+	NODISCARD bool building() const noexcept {
+		return !m_buildTasks.empty();
+	}
+	NODISCARD bool buildFailed() const noexcept {
+		return m_buildFailed;
+	}
+	NODISCARD float buildProgress() const noexcept {
+		return m_buildTasks.empty() ? 1.0f : static_cast<float>(m_buildProgress) / static_cast<float>(m_buildTasks.size());
+	}
 	
 	bool unsaved = false;
 
 private:
+	struct BuildResult {
+		bool built = false;
+		bool skipped = false;
+
+		BuildCache::Entry cache;
+
+		// metadata to write back into the project file
+		lsd::Vector<std::pair<const char*, lyra::uint32>> fields;
+		lsd::Vector<std::pair<const char*, lsd::Vector<lyra::uint32>>> arrays;
+	};
+
+	struct BuildSettings {
+		lyra::uint32 compression;
+		lyra::uint32 blockSize;
+
+		// texture settings
+		lyra::uint32 type;
+		lyra::uint32 encoding;
+
+		// hash over all settings affecting the built file
+		lyra::uint64 hash;
+	};
+
 	lsd::Json m_projectFile;
 	lsd::Json m_recents;
 
 	std::filesystem::path m_projectFilePath;
 
-	lsd::Vector<std::filesystem::path> m_newFiles;
+	BuildCache m_buildCache;
+
+	lsd::Vector<std::string> m_buildFiles;
+	lsd::Vector<std::future<BuildResult>> m_buildTasks;
+	std::atomic<lyra::uint32> m_buildProgress = 0;
 	
-	bool m_buildCancelled = false;
+	std::atomic<bool> m_buildCancelled = false;
+	bool m_buildFailed = false;
 	bool m_validProject = false;
 
+	// declared last, so the workers are joined before any state they may still access is destroyed
+	lyra::ThreadPool m_workers;
+
 	void loadItem(const std::filesystem::path& path);
+	// adds settings introduced after the project file was created
+	void addMissingSettings();
+	NODISCARD BuildResult buildAsset(const std::filesystem::path& filepath, const BuildSettings& settings, const BuildCache::Entry* cached);
+	void finishBuild();
+	// removes the outputs of assets whose source was deleted or which were removed from the project
+	void removeStaleOutputs();
+	NODISCARD static BuildSettings buildSettings(const lsd::Json& js, lyra::resource::AssetIndex::Kind kind);
+	void writeIndex();
+	void writeArchive();
 };
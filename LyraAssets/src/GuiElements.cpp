@@ -204,6 +204,8 @@ void Window::draw() {
 	if (m_state->showConsole) {
 		ImGui::Begin("Build Console", NULL, ImGuiWindowFlags_NoCollapse);
 
+		if (m_state->building) ImGui::ProgressBar(m_state->buildProgress);
+
 		// since we know that there will be only one file anyways
 		auto* f = lyra::log::defaultLogger()->outStream();
 		auto s = std::ftell(f);
@@ -294,6 +296,19 @@ void Window::draw() {
 						ImGui::EndCombo();
 					} 
 
+					static constexpr lsd::Array<const char*, 7> textureEncodingComboPreview {"Automatic", "RGBA8", "BC1", "BC3", "BC4", "BC5", "BC7"};
+
+					if (ImGui::BeginCombo("Encoding", textureEncodingComboPreview[js.child("Encoding").get<lyra::uint32>()])) {	
+						for (lyra::uint32 i = 0; i < textureEncodingComboPreview.size(); i++) {
+							if (ImGui::Selectable(textureEncodingComboPreview[i], js.child("Encoding").get<lyra::uint32>() == i)) {
+								js.child("Encoding") = i;
+								m_state->contentManager->unsaved = true;
+							}
+						}
+
+						ImGui::EndCombo();
+					} 
+
 					static constexpr lsd::Array<const char*, 3> textureAlphaComboPreview {"Transparent", "Opaque Black", "Opaque White"};
 					
 					if (ImGui::BeginCombo("Alpha", textureAlphaComboPreview[js.child("Alpha").get<lyra::uint32>()])) {	
@@ -392,6 +407,21 @@ void Window::draw() {
 					
 				}
 			}
+
+			auto kind = lyra::resource::AssetIndex::kind(m_state->nameBuffer);
+
+			if ((kind == lyra::resource::AssetIndex::Kind::texture || kind == lyra::resource::AssetIndex::Kind::mesh) && ImGui::CollapsingHeader("Compression", ImGuiTreeNodeFlags_DefaultOpen)) {
+				// level 0 uses the fast compressor, higher levels trade build time for smaller files and don't slow down loading
+				if (ImGui::SliderInt("Level", reinterpret_cast<int*>(&js.child("Compression").uInt()), 0, lyra::resource::maxCompressionLevel, js.child("Compression").get<lyra::uint32>() == 0 ? "Fast" : "HC %d")) {
+					m_state->contentManager->unsaved = true;
+				}
+
+				int blockSize = static_cast<int>(js.child("BlockSize").get<lyra::uint32>() / 1024);
+				if (ImGui::InputInt("Block Size (KiB)", &blockSize, 16, 256)) {
+					js.child("BlockSize") = std::max(static_cast<lyra::uint32>(std::max(blockSize, 0)) * 1024, lyra::resource::minBlockSize);
+					m_state->contentManager->unsaved = true;
+				}
+			}
 		}
 
 		ImGui::End();
@@ -30,6 +30,8 @@ struct ProgramState {
 	bool building = false;
 	bool cleaning = false;
 
+	float buildProgress = 1.0f;
+
 	bool rename = false;
 
 	bool showProject = true;
@@ -0,0 +1,336 @@
+#include "MeshOptimizer.h"
+
+#include <LSD/Array.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+namespace mesh {
+
+namespace {
+
+inline constexpr lyra::uint32 invalidIndex = std::numeric_limits<lyra::uint32>::max();
+
+// FIFO cache simulated with the time every vertex was last transformed, a vertex is in the cache if it was transformed in the last cacheSize misses
+class CacheSimulation {
+public:
+	CacheSimulation(lyra::uint32 vertexCount) : m_timestamps(vertexCount, 0) { }
+
+	// returns if the vertex had to be transformed
+	bool access(lyra::uint32 index) noexcept {
+		if (m_time - m_timestamps[index] <= cacheSize) return false;
+
+		m_timestamps[index] = m_time++;
+		return true;
+	}
+
+	lyra::uint32 access(const lyra::uint32* triangle) noexcept {
+		return static_cast<lyra::uint32>(access(triangle[0])) + access(triangle[1]) + access(triangle[2]);
+	}
+
+	void reset() noexcept {
+		m_time += cacheSize + 1;
+	}
+
+private:
+	lsd::Vector<lyra::uint32> m_timestamps;
+	lyra::uint32 m_time = cacheSize + 1;
+};
+
+
+// scoring of the vertex cache optimization, see https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+
+inline constexpr lyra::float32 cacheDecayPower = 1.5f;
+inline constexpr lyra::float32 lastTriangleScore = 0.75f;
+inline constexpr lyra::float32 valenceBoostScale = 2.0f;
+inline constexpr lyra::float32 valenceBoostPower = 0.5f;
+
+lyra::float32 vertexScore(lyra::int32 cachePosition, lyra::uint32 remainingTriangles) noexcept {
+	// vertices without triangles left are never looked at again
+	if (remainingTriangles == 0) return -1.0f;
+
+	lyra::float32 score = 0.0f;
+
+	if (cachePosition >= 0) {
+		if (cachePosition < 3) { // the vertices of the last triangle get a fixed score, so the strip does not turn back onto itself
+			score = lastTriangleScore;
+		} else {
+			score = std::pow(1.0f - static_cast<lyra::float32>(cachePosition - 3) / static_cast<lyra::float32>(cacheSize - 3), cacheDecayPower);
+		}
+	}
+
+	// vertices with few triangles left are preferred, so they are finished and do not have to be transformed again later
+	return score + valenceBoostScale * std::pow(static_cast<lyra::float32>(remainingTriangles), -valenceBoostPower);
+}
+
+}
+
+Statistics analyzeVertexCache(const lsd::Vector<lyra::uint32>& indices, lyra::uint32 vertexCount) {
+	Statistics statistics;
+	if (indices.size() < 3 || vertexCount == 0) return statistics;
+
+	CacheSimulation cache(vertexCount);
+	lyra::uint32 misses = 0;
+
+	for (auto index : indices) misses += cache.access(index);
+
+	statistics.acmr = static_cast<lyra::float32>(misses) / static_cast<lyra::float32>(indices.size() / 3);
+	statistics.atvr = static_cast<lyra::float32>(misses) / static_cast<lyra::float32>(vertexCount);
+
+	return statistics;
+}
+
+void deduplicate(lsd::Vector<lyra::Mesh::Vertex>& vertices, lsd::Vector<lyra::uint32>& indices) {
+	if (vertices.empty()) return;
+
+	auto compare = [&vertices](lyra::uint32 first, lyra::uint32 second) {
+		return std::memcmp(&vertices[first], &vertices[second], sizeof(lyra::Mesh::Vertex));
+	};
+
+	// identical vertices end up next to each other after sorting
+	lsd::Vector<lyra::uint32> order(vertices.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&compare](lyra::uint32 first, lyra::uint32 second) { return compare(first, second) < 0; });
+
+	lsd::Vector<lyra::uint32> remap(vertices.size());
+	lsd::Vector<lyra::Mesh::Vertex> unique;
+
+	for (lyra::uint32 i = 0; i < order.size(); i++) {
+		if (i == 0 || compare(order[i], order[i - 1]) != 0) unique.pushBack(vertices[order[i]]);
+		remap[order[i]] = static_cast<lyra::uint32>(unique.size() - 1);
+	}
+
+	for (auto& index : indices) index = remap[index];
+	vertices = std::move(unique);
+}
+
+void optimizeVertexCache(lsd::Vector<lyra::uint32>& indices, lyra::uint32 vertexCount) {
+	auto triangleCount = static_cast<lyra::uint32>(indices.size() / 3);
+	if (triangleCount == 0) return;
+
+	// the triangles using every vertex, in a single array indexed by offsets
+	lsd::Vector<lyra::uint32> remaining(vertexCount, 0);
+	for (lyra::uint32 i = 0; i < triangleCount * 3; i++) remaining[indices[i]]++;
+
+	lsd::Vector<lyra::uint32> offsets(vertexCount, 0);
+	for (lyra::uint32 i = 1; i < vertexCount; i++) offsets[i] = offsets[i - 1] + remaining[i - 1];
+
+	lsd::Vector<lyra::uint32> adjacency(triangleCount * 3);
+	{
+		auto cursors = offsets;
+		for (lyra::uint32 i = 0; i < triangleCount * 3; i++) adjacency[cursors[indices[i]]++] = i / 3;
+	}
+
+	lsd::Vector<lyra::int32> cachePositions(vertexCount, -1);
+	lsd::Vector<lyra::float32> vertexScores(vertexCount);
+	for (lyra::uint32 i = 0; i < vertexCount; i++) vertexScores[i] = vertexScore(-1, remaining[i]);
+
+	lsd::Vector<lyra::uint8> emitted(triangleCount, 0);
+	lsd::Vector<lyra::uint32> result;
+	result.reserve(triangleCount * 3);
+
+	// the vertices of the new triangle are put in front, so the cache may temporarily grow by three
+	lsd::Array<lyra::uint32, cacheSize + 3> cache;
+	lsd::Array<lyra::uint32, cacheSize + 3> newCache;
+	lyra::uint32 cacheCount = 0;
+
+	lyra::uint32 cursor = 0;
+	auto best = invalidIndex;
+
+	for (lyra::uint32 i = 0; i < triangleCount; i++) {
+		// none of the vertices in the cache have triangles left, so continue with the next triangle in the original order
+		if (best == invalidIndex) {
+			while (emitted[cursor]) cursor++;
+			best = cursor;
+		}
+
+		const auto* triangle = &indices[best * 3];
+		emitted[best] = 1;
+
+		for (lyra::uint32 j = 0; j < 3; j++) result.pushBack(triangle[j]);
+
+		lyra::uint32 newCacheCount = 0;
+
+		for (lyra::uint32 j = 0; j < 3; j++) {
+			if (std::find(newCache.begin(), newCache.begin() + newCacheCount, triangle[j]) == newCache.begin() + newCacheCount) newCache[newCacheCount++] = triangle[j];
+		}
+
+		for (lyra::uint32 j = 0; j < cacheCount; j++) {
+			if (cache[j] != triangle[0] && cache[j] != triangle[1] && cache[j] != triangle[2]) newCache[newCacheCount++] = cache[j];
+		}
+
+		// remove the triangle from the triangles of its vertices
+		for (lyra::uint32 j = 0; j < 3; j++) {
+			auto vertex = triangle[j];
+			auto* triangles = &adjacency[offsets[vertex]];
+
+			for (lyra::uint32 k = 0; k < remaining[vertex]; k++) {
+				if (triangles[k] == best) {
+					std::swap(triangles[k], triangles[remaining[vertex] - 1]);
+					remaining[vertex]--;
+
+					break;
+				}
+			}
+		}
+
+		// vertices pushed past the end of the cache fell out of it
+		for (lyra::uint32 j = 0; j < newCacheCount; j++) {
+			auto vertex = newCache[j];
+
+			cachePositions[vertex] = (j < cacheSize) ? static_cast<lyra::int32>(j) : -1;
+			vertexScores[vertex] = vertexScore(cachePositions[vertex], remaining[vertex]);
+		}
+
+		cacheCount = std::min(newCacheCount, cacheSize);
+		std::copy(newCache.begin(), newCache.begin() + cacheCount, cache.begin());
+
+		// only the triangles of the vertices whose score changed have to be considered
+		best = invalidIndex;
+		lyra::float32 bestScore = -1.0f;
+
+		for (lyra::uint32 j = 0; j < cacheCount; j++) {
+			auto vertex = cache[j];
+			const auto* triangles = &adjacency[offsets[vertex]];
+
+			for (lyra::uint32 k = 0; k < remaining[vertex]; k++) {
+				const auto* candidate = &indices[triangles[k] * 3];
+				auto score = vertexScores[candidate[0]] + vertexScores[candidate[1]] + vertexScores[candidate[2]];
+
+				if (score > bestScore) {
+					bestScore = score;
+					best = triangles[k];
+				}
+			}
+		}
+	}
+
+	indices = std::move(result);
+}
+
+void optimizeOverdraw(lsd::Vector<lyra::uint32>& indices, const lsd::Vector<lyra::Mesh::Vertex>& vertices, lyra::float32 threshold) {
+	auto triangleCount = static_cast<lyra::uint32>(indices.size() / 3);
+	if (triangleCount < 2) return;
+
+	auto vertexCount = static_cast<lyra::uint32>(vertices.size());
+
+	// triangles missing every vertex in the cache start a new strip, these are the hard boundaries which can be reordered without any cost
+	lsd::Vector<lyra::uint32> hardClusters;
+	{
+		CacheSimulation cache(vertexCount);
+
+		for (lyra::uint32 i = 0; i < triangleCount; i++) {
+			if (cache.access(&indices[i * 3]) == 3) hardClusters.pushBack(i);
+		}
+	}
+
+	hardClusters.pushBack(triangleCount);
+
+	// the hard clusters are split further, as long as every part is nearly as cache efficient as the whole cluster
+	lsd::Vector<lyra::uint32> clusters;
+	{
+		CacheSimulation cache(vertexCount);
+
+		for (lyra::uint32 i = 0; i + 1 < hardClusters.size(); i++) {
+			auto begin = hardClusters[i], end = hardClusters[i + 1];
+
+			cache.reset();
+			lyra::uint32 misses = 0;
+			for (auto t = begin; t < end; t++) misses += cache.access(&indices[t * 3]);
+
+			auto clusterAcmr = static_cast<lyra::float32>(misses) / static_cast<lyra::float32>(end - begin);
+
+			cache.reset();
+			misses = 0;
+			clusters.pushBack(begin);
+
+			for (auto t = begin, start = begin; t + 1 < end; t++) {
+				misses += cache.access(&indices[t * 3]);
+
+				if (static_cast<lyra::float32>(misses) / static_cast<lyra::float32>(t + 1 - start) <= clusterAcmr * threshold) {
+					start = t + 1;
+					clusters.pushBack(start);
+
+					cache.reset();
+					misses = 0;
+				}
+			}
+		}
+	}
+
+	clusters.pushBack(triangleCount);
+
+	// clusters facing away from the center occlude the rest of the mesh more often, so they are drawn first
+	glm::vec3 meshCenter(0.0f);
+	for (const auto& vertex : vertices) meshCenter += vertex.pos;
+	meshCenter /= static_cast<lyra::float32>(std::max(vertexCount, 1u));
+
+	auto clusterCount = static_cast<lyra::uint32>(clusters.size() - 1);
+	lsd::Vector<lyra::float32> sortKeys(clusterCount);
+
+	for (lyra::uint32 i = 0; i < clusterCount; i++) {
+		glm::vec3 center(0.0f), normal(0.0f);
+		lyra::float32 area = 0.0f;
+
+		for (auto t = clusters[i]; t < clusters[i + 1]; t++) {
+			const auto& p0 = vertices[indices[t * 3]].pos;
+			const auto& p1 = vertices[indices[t * 3 + 1]].pos;
+			const auto& p2 = vertices[indices[t * 3 + 2]].pos;
+
+			// the length of the cross product is twice the area of the triangle
+			auto cross = glm::cross(p1 - p0, p2 - p0);
+			auto triangleArea = glm::length(cross);
+
+			center += (p0 + p1 + p2) * (triangleArea / 3.0f);
+			normal += cross;
+			area += triangleArea;
+		}
+
+		if (area > 0.0f) center /= area;
+		auto normalLength = glm::length(normal);
+
+		sortKeys[i] = (normalLength > 0.0f) ? glm::dot(center - meshCenter, normal / normalLength) : -std::numeric_limits<lyra::float32>::max();
+	}
+
+	lsd::Vector<lyra::uint32> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](lyra::uint32 first, lyra::uint32 second) { return sortKeys[first] > sortKeys[second]; });
+
+	lsd::Vector<lyra::uint32> result;
+	result.reserve(indices.size());
+
+	for (auto cluster : order) {
+		for (auto i = clusters[cluster] * 3; i < clusters[cluster + 1] * 3; i++) result.pushBack(indices[i]);
+	}
+
+	indices = std::move(result);
+}
+
+void optimizeVertexFetch(lsd::Vector<lyra::Mesh::Vertex>& vertices, lsd::Vector<lyra::uint32>& indices) {
+	lsd::Vector<lyra::uint32> remap(vertices.size(), invalidIndex);
+	lsd::Vector<lyra::Mesh::Vertex> result;
+	result.reserve(vertices.size());
+
+	for (auto& index : indices) {
+		if (remap[index] == invalidIndex) {
+			remap[index] = static_cast<lyra::uint32>(result.size());
+			result.pushBack(vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	vertices = std::move(result);
+}
+
+void optimize(lsd::Vector<lyra::Mesh::Vertex>& vertices, lsd::Vector<lyra::uint32>& indices) {
+	deduplicate(vertices, indices);
+	optimizeVertexCache(indices, static_cast<lyra::uint32>(vertices.size()));
+	optimizeOverdraw(indices, vertices);
+	optimizeVertexFetch(vertices, indices);
+}
+
+} // namespace mesh
@@ -0,0 +1,46 @@
+/*************************
+ * @file MeshOptimizer.h
+ *
+ * @brief Reorders the vertices and indices of imported meshes, so they are cheaper to draw on the GPU
+ *************************/
+
+#pragma once
+
+#include <Common/Common.h>
+
+#include <Graphics/Mesh.h>
+
+#include <LSD/Vector.h>
+
+namespace mesh {
+
+// size of the simulated FIFO post transform cache, the optimizations and statistics are tuned for it
+inline constexpr lyra::uint32 cacheSize = 16;
+
+struct Statistics {
+	lyra::float32 acmr = 0.0f; // average cache miss ratio, transformed vertices per triangle, 0.5 is the best possible
+	lyra::float32 atvr = 0.0f; // average transform to vertex ratio, transformed vertices per vertex, 1.0 is the best possible
+};
+
+NODISCARD Statistics analyzeVertexCache(const lsd::Vector<lyra::uint32>& indices, lyra::uint32 vertexCount);
+
+// merges vertices which are identical bit by bit
+void deduplicate(lsd::Vector<lyra::Mesh::Vertex>& vertices, lsd::Vector<lyra::uint32>& indices);
+// reorders the triangles for locality in the post transform cache, with the linear speed algorithm by Tom Forsyth
+void optimizeVertexCache(lsd::Vector<lyra::uint32>& indices, lyra::uint32 vertexCount);
+/**
+ * @brief sorts clusters of the cache optimized triangles, so triangles facing away from the center of the mesh are drawn first
+ * @brief the clusters are split as long as their cache efficiency is within the threshold of the whole cluster
+ *
+ * @param indices indices of the triangles, already optimized for the vertex cache
+ * @param vertices vertices the indices reference
+ * @param threshold how much the cache miss ratio of a split cluster may be worse than the original one
+ */
+void optimizeOverdraw(lsd::Vector<lyra::uint32>& indices, const lsd::Vector<lyra::Mesh::Vertex>& vertices, lyra::float32 threshold = 1.05f);
+// orders the vertices by their first use in the indices and removes unreferenced ones
+void optimizeVertexFetch(lsd::Vector<lyra::Mesh::Vertex>& vertices, lsd::Vector<lyra::uint32>& indices);
+
+// runs every stage above in order
+void optimize(lsd::Vector<lyra::Mesh::Vertex>& vertices, lsd::Vector<lyra::uint32>& indices);
+
+} // namespace mesh
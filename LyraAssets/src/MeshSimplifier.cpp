@@ -0,0 +1,292 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <LSD/Array.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <utility>
+
+namespace mesh {
+
+namespace {
+
+// sum of the squared distances to a set of planes, see Garland and Heckbert, Surface Simplification Using Quadric Error Metrics
+struct Quadric {
+	// the upper half of the symmetric 4x4 matrix
+	lyra::float64 a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+	lyra::float64 b2 = 0.0, bc = 0.0, bd = 0.0;
+	lyra::float64 c2 = 0.0, cd = 0.0;
+	lyra::float64 d2 = 0.0;
+
+	// sum of the areas of the planes, dividing by it turns the error into a mean squared distance
+	lyra::float64 weight = 0.0;
+
+	Quadric() = default;
+	Quadric(const glm::vec3& normal, lyra::float32 distance, lyra::float32 area) :
+		a2(normal.x * normal.x * area), ab(normal.x * normal.y * area), ac(normal.x * normal.z * area), ad(normal.x * distance * area),
+		b2(normal.y * normal.y * area), bc(normal.y * normal.z * area), bd(normal.y * distance * area),
+		c2(normal.z * normal.z * area), cd(normal.z * distance * area),
+		d2(distance * distance * area),
+		weight(area) { }
+
+	Quadric& operator+=(const Quadric& other) noexcept {
+		a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+		b2 += other.b2; bc += other.bc; bd += other.bd;
+		c2 += other.c2; cd += other.cd;
+		d2 += other.d2;
+		weight += other.weight;
+
+		return *this;
+	}
+
+	NODISCARD lyra::float32 error(const glm::vec3& point) const noexcept {
+		if (weight == 0.0) return 0.0f;
+
+		lyra::float64 x = point.x, y = point.y, z = point.z;
+		auto result =
+			a2 * x * x + b2 * y * y + c2 * z * z +
+			2.0 * (ab * x * y + ac * x * z + bc * y * z) +
+			2.0 * (ad * x + bd * y + cd * z) +
+			d2;
+
+		return static_cast<lyra::float32>(std::sqrt(std::abs(result) / weight));
+	}
+};
+
+struct Collapse {
+	lyra::uint32 from;
+	lyra::uint32 to;
+	lyra::float32 error;
+};
+
+// vertices which may not be moved, since it would open holes in the mesh or shrink its borders
+lsd::Vector<lyra::uint8> lockedVertices(const lsd::Vector<lyra::Mesh::Vertex>& vertices, const lsd::Vector<lyra::uint32>& indices) {
+	lsd::Vector<lyra::uint8> locked(vertices.size(), 0);
+
+	// vertices sharing a position with other vertices, mostly on seams of the texture coordinates or normals
+	lsd::Vector<lyra::uint32> order(vertices.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&vertices](lyra::uint32 first, lyra::uint32 second) {
+		return std::memcmp(&vertices[first].pos, &vertices[second].pos, sizeof(glm::vec3)) < 0;
+	});
+
+	for (lyra::uint32 i = 1; i < order.size(); i++) {
+		if (std::memcmp(&vertices[order[i]].pos, &vertices[order[i - 1]].pos, sizeof(glm::vec3)) == 0) {
+			locked[order[i]] = 1;
+			locked[order[i - 1]] = 1;
+		}
+	}
+
+	// edges which are not shared by exactly two triangles lie on a border or are non manifold
+	lsd::Vector<std::pair<lyra::uint32, lyra::uint32>> edges;
+	edges.reserve(indices.size());
+
+	for (lyra::uint32 i = 0; i < indices.size(); i += 3) {
+		for (lyra::uint32 j = 0; j < 3; j++) {
+			auto a = indices[i + j], b = indices[i + (j + 1) % 3];
+			edges.pushBack({ std::min(a, b), std::max(a, b) });
+		}
+	}
+
+	std::sort(edges.begin(), edges.end());
+
+	for (lyra::uint32 i = 0; i < edges.size();) {
+		auto j = i + 1;
+		while (j < edges.size() && edges[j] == edges[i]) j++;
+
+		if (j - i != 2) {
+			locked[edges[i].first] = 1;
+			locked[edges[i].second] = 1;
+		}
+
+		i = j;
+	}
+
+	return locked;
+}
+
+}
+
+lsd::Vector<lyra::uint32> simplify(
+	const lsd::Vector<lyra::Mesh::Vertex>& vertices,
+	const lsd::Vector<lyra::uint32>& indices,
+	lyra::uint32 targetIndexCount,
+	lyra::float32 targetError,
+	lyra::float32& error
+) {
+	auto vertexCount = static_cast<lyra::uint32>(vertices.size());
+
+	lsd::Vector<lyra::uint32> result = indices;
+	error = 0.0f;
+
+	if (result.size() <= targetIndexCount || vertexCount == 0) return result;
+
+	auto radius = lyra::Mesh::calculateBounds(vertices).radius;
+	if (radius <= 0.0f) radius = 1.0f;
+
+	auto locked = lockedVertices(vertices, result);
+
+	lsd::Vector<Quadric> quadrics(vertexCount);
+
+	for (lyra::uint32 i = 0; i < result.size(); i += 3) {
+		const auto& p0 = vertices[result[i]].pos;
+		const auto& p1 = vertices[result[i + 1]].pos;
+		const auto& p2 = vertices[result[i + 2]].pos;
+
+		auto normal = glm::cross(p1 - p0, p2 - p0);
+		auto length = glm::length(normal);
+		if (length == 0.0f) continue;
+
+		normal /= length;
+		Quadric quadric(normal, -glm::dot(normal, p0), length * 0.5f);
+
+		quadrics[result[i]] += quadric;
+		quadrics[result[i + 1]] += quadric;
+		quadrics[result[i + 2]] += quadric;
+	}
+
+	lsd::Vector<Collapse> collapses;
+	lsd::Vector<lyra::uint32> remap(vertexCount);
+	lsd::Vector<lyra::uint8> touched(vertexCount);
+	lsd::Vector<lyra::uint32> offsets(vertexCount);
+	lsd::Vector<lyra::uint32> counts(vertexCount);
+	lsd::Vector<lyra::uint32> adjacency;
+
+	// every pass collapses as many independent edges as possible in the order of their error, then rebuilds the triangles
+	while (result.size() > targetIndexCount) {
+		auto triangleCount = static_cast<lyra::uint32>(result.size() / 3);
+
+		collapses.clear();
+
+		for (lyra::uint32 i = 0; i < result.size(); i += 3) {
+			for (lyra::uint32 j = 0; j < 3; j++) {
+				auto a = result[i + j], b = result[i + (j + 1) % 3];
+
+				if (!locked[a]) collapses.pushBack({ a, b, quadrics[a].error(vertices[b].pos) / radius });
+				if (!locked[b]) collapses.pushBack({ b, a, quadrics[b].error(vertices[a].pos) / radius });
+			}
+		}
+
+		if (collapses.empty()) break;
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& first, const Collapse& second) { return first.error < second.error; });
+
+		// the triangles using every vertex, to check collapses for triangles flipping over
+		std::fill(counts.begin(), counts.end(), 0);
+		for (auto index : result) counts[index]++;
+
+		offsets[0] = 0;
+		for (lyra::uint32 i = 1; i < vertexCount; i++) offsets[i] = offsets[i - 1] + counts[i - 1];
+
+		adjacency.resize(result.size());
+		{
+			auto cursors = offsets;
+			for (lyra::uint32 i = 0; i < result.size(); i++) adjacency[cursors[result[i]]++] = i / 3;
+		}
+
+		std::iota(remap.begin(), remap.end(), 0);
+		std::fill(touched.begin(), touched.end(), 0);
+
+		auto trianglesToRemove = triangleCount - targetIndexCount / 3;
+		lyra::uint32 removed = 0;
+		lyra::uint32 collapsed = 0;
+
+		for (const auto& collapse : collapses) {
+			if (collapse.error > targetError || removed >= trianglesToRemove) break;
+
+			// the triangles around a collapsed vertex may not change again in the same pass, so the flip test stays exact
+			if (touched[collapse.from] || touched[collapse.to]) continue;
+
+			const auto& target = vertices[collapse.to].pos;
+			lyra::uint32 degenerate = 0;
+			bool flipped = false;
+
+			for (lyra::uint32 i = offsets[collapse.from]; i < offsets[collapse.from] + counts[collapse.from]; i++) {
+				const auto* triangle = &result[adjacency[i] * 3];
+
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+					degenerate++;
+					continue;
+				}
+
+				lsd::Array<glm::vec3, 3> before { vertices[triangle[0]].pos, vertices[triangle[1]].pos, vertices[triangle[2]].pos };
+				auto after = before;
+				for (lyra::uint32 j = 0; j < 3; j++) if (triangle[j] == collapse.from) after[j] = target;
+
+				auto normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+				auto normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+
+				if (glm::dot(normalBefore, normalAfter) <= 0.0f) {
+					flipped = true;
+					break;
+				}
+			}
+
+			if (flipped) continue;
+
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to] += quadrics[collapse.from];
+
+			for (lyra::uint32 i = offsets[collapse.from]; i < offsets[collapse.from] + counts[collapse.from]; i++) {
+				const auto* triangle = &result[adjacency[i] * 3];
+				for (lyra::uint32 j = 0; j < 3; j++) touched[triangle[j]] = 1;
+			}
+
+			error = std::max(error, collapse.error);
+			removed += degenerate;
+			collapsed++;
+		}
+
+		if (collapsed == 0) break;
+
+		lyra::uint32 written = 0;
+
+		for (lyra::uint32 i = 0; i < result.size(); i += 3) {
+			auto a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+			if (a == b || b == c || a == c) continue;
+
+			result[written++] = a;
+			result[written++] = b;
+			result[written++] = c;
+		}
+
+		result.resize(written);
+	}
+
+	return result;
+}
+
+lsd::Vector<Lod> generateLods(const lsd::Vector<lyra::Mesh::Vertex>& vertices, const lsd::Vector<lyra::uint32>& indices, lyra::uint32 maxLods) {
+	lsd::Vector<Lod> lods;
+	lods.pushBack({ indices, 0.0f });
+
+	auto vertexCount = static_cast<lyra::uint32>(vertices.size());
+	auto triangleCount = static_cast<lyra::float32>(indices.size() / 3);
+
+	while (lods.size() < maxLods) {
+		auto previousCount = static_cast<lyra::uint32>(lods.back().indices.size());
+		if (previousCount / 3 <= minLodTriangles) break;
+
+		// every level is simplified from the original mesh, so the errors do not accumulate
+		triangleCount *= lodReduction;
+
+		lyra::float32 error;
+		auto simplified = simplify(vertices, indices, static_cast<lyra::uint32>(triangleCount) * 3, maxLodError, error);
+
+		// levels barely reducing the triangles are not worth the memory, the error limit was most likely reached
+		if (simplified.empty() || simplified.size() > previousCount * 0.9f) break;
+
+		optimizeVertexCache(simplified, vertexCount);
+
+		// the selection expects the errors to increase with the level
+		error = std::max(error, lods.back().error);
+		lods.pushBack({ std::move(simplified), error });
+	}
+
+	return lods;
+}
+
+} // namespace mesh
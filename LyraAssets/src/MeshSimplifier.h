@@ -0,0 +1,54 @@
+/*************************
+ * @file MeshSimplifier.h
+ *
+ * @brief Generates levels of detail of imported meshes with quadric error edge collapses
+ *************************/
+
+#pragma once
+
+#include <Common/Common.h>
+
+#include <Graphics/Mesh.h>
+
+#include <LSD/Vector.h>
+
+namespace mesh {
+
+inline constexpr lyra::float32 lodReduction = 0.5f; // ratio of triangles every level of detail aims for compared to the previous one
+inline constexpr lyra::float32 maxLodError = 0.1f; // largest error a level of detail may have, relative to the radius of the mesh
+inline constexpr lyra::uint32 minLodTriangles = 16; // meshes with fewer triangles are not simplified any further
+
+struct Lod {
+	lsd::Vector<lyra::uint32> indices;
+	lyra::float32 error; // largest distance of the simplified surface to the original one, relative to the radius of the mesh
+};
+
+/**
+ * @brief collapses edges in the order of their quadric error, until the target index count or error is reached
+ * @brief vertices are only ever collapsed onto other existing vertices, so the result indexes the same vertices as the original
+ * @brief vertices on borders or sharing their position with other vertices, like on texture seams, are never moved
+ *
+ * @param vertices vertices the indices reference
+ * @param indices indices of the triangles to simplify
+ * @param targetIndexCount index count at which the simplification stops
+ * @param targetError largest error relative to the radius of the mesh a collapse may introduce
+ * @param error largest error of all performed collapses, relative to the radius of the mesh
+ *
+ * @return the indices of the simplified triangles
+ */
+NODISCARD lsd::Vector<lyra::uint32> simplify(
+	const lsd::Vector<lyra::Mesh::Vertex>& vertices,
+	const lsd::Vector<lyra::uint32>& indices,
+	lyra::uint32 targetIndexCount,
+	lyra::float32 targetError,
+	lyra::float32& error
+);
+
+// generates at most maxLods levels with lodReduction times the triangles of the previous level each, the first level are the original indices
+NODISCARD lsd::Vector<Lod> generateLods(
+	const lsd::Vector<lyra::Mesh::Vertex>& vertices,
+	const lsd::Vector<lyra::uint32>& indices,
+	lyra::uint32 maxLods
+);
+
+} // namespace mesh
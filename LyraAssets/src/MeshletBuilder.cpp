@@ -0,0 +1,111 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace mesh {
+
+namespace {
+
+// computes the bounding sphere and normal cone of the triangles in the index range of the meshlet
+void computeBounds(lyra::Meshlet& meshlet, const lsd::Vector<lyra::Mesh::Vertex>& vertices, const lsd::Vector<lyra::uint32>& indices, lsd::Vector<glm::vec3>& positions) {
+	positions.clear();
+	for (auto i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i++) positions.pushBack(vertices[indices[i]].pos);
+
+	auto bounds = lyra::BoundingVolume::fromPoints(positions.data(), positions.size());
+	meshlet.center = bounds.center;
+	meshlet.radius = bounds.radius;
+
+	// every triangle contributes equally to the axis, so small triangles cannot be ignored by the cone
+	glm::vec3 axis(0.0f);
+
+	for (lyra::uint32 i = 0; i < positions.size(); i += 3) {
+		auto normal = glm::cross(positions[i + 1] - positions[i], positions[i + 2] - positions[i]);
+		auto length = glm::length(normal);
+
+		if (length > 0.0f) axis += normal / length;
+	}
+
+	auto axisLength = glm::length(axis);
+	if (axisLength == 0.0f) return;
+
+	axis /= axisLength;
+
+	auto minDot = 1.0f;
+
+	for (lyra::uint32 i = 0; i < positions.size(); i += 3) {
+		auto normal = glm::cross(positions[i + 1] - positions[i], positions[i + 2] - positions[i]);
+		auto length = glm::length(normal);
+
+		if (length > 0.0f) minDot = std::min(minDot, glm::dot(axis, normal / length));
+	}
+
+	meshlet.coneAxis = axis;
+
+	// a cone of at least 90 degrees always contains a normal facing the camera
+	meshlet.coneCutoff = (minDot <= 0.0f) ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+}
+
+}
+
+lsd::Vector<lyra::Meshlet> buildMeshlets(
+	const lsd::Vector<lyra::Mesh::Vertex>& vertices,
+	const lsd::Vector<lyra::uint32>& indices,
+	lyra::uint32 maxVertices,
+	lyra::uint32 maxTriangles
+) {
+	lsd::Vector<lyra::Meshlet> meshlets;
+	if (indices.size() < 3) return meshlets;
+
+	// the meshlet a vertex was last counted for, so vertices shared by triangles of the same meshlet are only counted once
+	lsd::Vector<lyra::uint32> owners(vertices.size(), std::numeric_limits<lyra::uint32>::max());
+	lsd::Vector<glm::vec3> positions;
+
+	lyra::Meshlet current;
+	lyra::uint32 vertexCount = 0;
+
+	auto finish = [&]() {
+		computeBounds(current, vertices, indices, positions);
+		meshlets.pushBack(current);
+	};
+
+	// vertices used twice by a degenerate triangle are only counted once as well
+	auto newVertices = [&](lyra::uint32 triangle, lyra::uint32 meshlet) {
+		lyra::uint32 count = 0;
+
+		for (lyra::uint32 j = 0; j < 3; j++) {
+			auto index = indices[triangle + j];
+			bool duplicate = (j > 0 && index == indices[triangle]) || (j == 2 && index == indices[triangle + 1]);
+
+			if (!duplicate && owners[index] != meshlet) count++;
+		}
+
+		return count;
+	};
+
+	for (lyra::uint32 i = 0; i + 2 < indices.size(); i += 3) {
+		auto meshlet = static_cast<lyra::uint32>(meshlets.size());
+
+		if (vertexCount + newVertices(i, meshlet) > maxVertices || current.indexCount / 3 == maxTriangles) {
+			finish();
+
+			current = lyra::Meshlet { };
+			current.firstIndex = i;
+			vertexCount = 0;
+
+			meshlet++;
+		}
+
+		vertexCount += newVertices(i, meshlet);
+		for (lyra::uint32 j = 0; j < 3; j++) owners[indices[i + j]] = meshlet;
+
+		current.indexCount += 3;
+	}
+
+	finish();
+
+	return meshlets;
+}
+
+} // namespace mesh
@@ -0,0 +1,38 @@
+/*************************
+ * @file MeshletBuilder.h
+ *
+ * @brief Splits the index blocks of imported meshes into meshlets with bounding spheres and normal cones
+ *************************/
+
+#pragma once
+
+#include <Common/Common.h>
+#include <Common/Config.h>
+
+#include <Graphics/Mesh.h>
+
+#include <Math/Culling.h>
+
+#include <LSD/Vector.h>
+
+namespace mesh {
+
+/**
+ * @brief splits the triangles into meshlets in their current order, so the triangles of every meshlet are consecutive in the indices
+ * @brief the indices should be optimized for the vertex cache already, since meshlets are only closed once one of the limits is reached
+ *
+ * @param vertices vertices the indices reference
+ * @param indices indices of the triangles to split
+ * @param maxVertices largest number of unique vertices of a meshlet
+ * @param maxTriangles largest number of triangles of a meshlet
+ *
+ * @return the meshlets, with index ranges relative to the start of the indices
+ */
+NODISCARD lsd::Vector<lyra::Meshlet> buildMeshlets(
+	const lsd::Vector<lyra::Mesh::Vertex>& vertices,
+	const lsd::Vector<lyra::uint32>& indices,
+	lyra::uint32 maxVertices = lyra::config::maxMeshletVertices,
+	lyra::uint32 maxTriangles = lyra::config::maxMeshletTriangles
+);
+
+} // namespace mesh
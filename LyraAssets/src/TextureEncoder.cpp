@@ -0,0 +1,467 @@
+#include "TextureEncoder.h"
+
+#include <LSD/Array.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace texture {
+
+namespace {
+
+// matches lyra::Texture::Type
+enum class Type : lyra::uint32 {
+	texture,
+	normalMap,
+	lightMap,
+	lightMapDirectional,
+	shadowMask
+};
+
+using Texel = lsd::Array<lyra::float32, 4>;
+using Block = lsd::Array<lsd::Array<lyra::uint8, 4>, 16>;
+
+struct Level {
+	lyra::uint32 width;
+	lyra::uint32 height;
+
+	lsd::Vector<Texel> texels;
+};
+
+// writes values into a zero initialized block, starting from the least significant bit
+class BitWriter {
+public:
+	BitWriter(lyra::uint8* data) : m_data(data) { }
+
+	void write(lyra::uint32 value, lyra::uint32 count) noexcept {
+		for (lyra::uint32 i = 0; i < count; i++, m_bit++) {
+			if ((value >> i) & 1) m_data[m_bit / 8] |= static_cast<lyra::uint8>(1 << (m_bit % 8));
+		}
+	}
+
+private:
+	lyra::uint8* m_data;
+	lyra::uint32 m_bit = 0;
+};
+
+
+// conversion between the stored and the filtered representation of the texels
+
+lyra::float32 srgbToLinear(lyra::float32 value) noexcept {
+	return (value <= 0.04045f) ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+lyra::float32 linearToSrgb(lyra::float32 value) noexcept {
+	return (value <= 0.0031308f) ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+lyra::uint8 toUNorm8(lyra::float32 value) noexcept {
+	return static_cast<lyra::uint8>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+Level decodeBaseLevel(const lyra::uint8* pixels, lyra::uint32 width, lyra::uint32 height, Type type) {
+	Level level { width, height, lsd::Vector<Texel>(static_cast<lyra::size_type>(width) * height) };
+
+	for (lyra::size_type i = 0; i < level.texels.size(); i++) {
+		auto& texel = level.texels[i];
+		for (lyra::uint32 c = 0; c < 4; c++) texel[c] = pixels[i * 4 + c] / 255.0f;
+
+		if (type == Type::texture) {
+			for (lyra::uint32 c = 0; c < 3; c++) texel[c] = srgbToLinear(texel[c]);
+		} else if (type == Type::normalMap) {
+			for (lyra::uint32 c = 0; c < 3; c++) texel[c] = texel[c] * 2.0f - 1.0f;
+		}
+	}
+
+	return level;
+}
+
+// box filter, odd dimensions repeat the last row or column
+Level downsample(const Level& source, Type type) {
+	Level level { std::max(source.width / 2, 1U), std::max(source.height / 2, 1U), { } };
+	level.texels.resize(static_cast<lyra::size_type>(level.width) * level.height);
+
+	for (lyra::uint32 y = 0; y < level.height; y++) {
+		auto y0 = std::min(y * 2, source.height - 1), y1 = std::min(y * 2 + 1, source.height - 1);
+
+		for (lyra::uint32 x = 0; x < level.width; x++) {
+			auto x0 = std::min(x * 2, source.width - 1), x1 = std::min(x * 2 + 1, source.width - 1);
+
+			const auto& a = source.texels[y0 * source.width + x0];
+			const auto& b = source.texels[y0 * source.width + x1];
+			const auto& c = source.texels[y1 * source.width + x0];
+			const auto& d = source.texels[y1 * source.width + x1];
+
+			auto& texel = level.texels[y * level.width + x];
+			for (lyra::uint32 i = 0; i < 4; i++) texel[i] = (a[i] + b[i] + c[i] + d[i]) * 0.25f;
+
+			if (type == Type::normalMap) { // averaged normals become shorter and have to be normalized again
+				auto length = std::sqrt(texel[0] * texel[0] + texel[1] * texel[1] + texel[2] * texel[2]);
+				if (length > 0.0f) for (lyra::uint32 i = 0; i < 3; i++) texel[i] /= length;
+			}
+		}
+	}
+
+	return level;
+}
+
+lsd::Vector<lyra::uint8> encodeLevel(const Level& level, Type type) {
+	lsd::Vector<lyra::uint8> pixels(level.texels.size() * 4);
+
+	for (lyra::size_type i = 0; i < level.texels.size(); i++) {
+		const auto& texel = level.texels[i];
+
+		for (lyra::uint32 c = 0; c < 4; c++) {
+			auto value = texel[c];
+
+			if (c < 3 && type == Type::texture) value = linearToSrgb(value);
+			else if (c < 3 && type == Type::normalMap) value = value * 0.5f + 0.5f;
+
+			pixels[i * 4 + c] = toUNorm8(value);
+		}
+	}
+
+	return pixels;
+}
+
+
+// block encoders
+
+lyra::uint32 distance(const lsd::Array<lyra::uint8, 4>& a, const lsd::Array<lyra::int32, 4>& b, lyra::uint32 channels) noexcept {
+	lyra::uint32 result = 0;
+
+	for (lyra::uint32 c = 0; c < channels; c++) {
+		auto d = static_cast<lyra::int32>(a[c]) - b[c];
+		result += static_cast<lyra::uint32>(d * d);
+	}
+
+	return result;
+}
+
+// endpoints of the line through the texels along their axis of largest variance
+template <lyra::uint32 Channels> void principalEndpoints(const Block& block, lsd::Array<lyra::float32, 4>& begin, lsd::Array<lyra::float32, 4>& end) noexcept {
+	lsd::Array<lyra::float32, 4> mean { }, axis { }, low { 255.0f, 255.0f, 255.0f, 255.0f }, high { };
+
+	for (const auto& texel : block) {
+		for (lyra::uint32 c = 0; c < Channels; c++) {
+			mean[c] += texel[c] / 16.0f;
+			low[c] = std::min(low[c], static_cast<lyra::float32>(texel[c]));
+			high[c] = std::max(high[c], static_cast<lyra::float32>(texel[c]));
+		}
+	}
+
+	lyra::float32 covariance[Channels][Channels] { };
+
+	for (const auto& texel : block) {
+		for (lyra::uint32 i = 0; i < Channels; i++) {
+			for (lyra::uint32 j = 0; j < Channels; j++) covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+		}
+	}
+
+	// power iteration, starting from the diagonal of the bounding box
+	for (lyra::uint32 c = 0; c < Channels; c++) axis[c] = high[c] - low[c];
+
+	for (lyra::uint32 iteration = 0; iteration < 8; iteration++) {
+		lsd::Array<lyra::float32, 4> next { };
+		lyra::float32 length = 0.0f;
+
+		for (lyra::uint32 i = 0; i < Channels; i++) {
+			for (lyra::uint32 j = 0; j < Channels; j++) next[i] += covariance[i][j] * axis[j];
+			length = std::max(length, std::abs(next[i]));
+		}
+
+		if (length == 0.0f) break;
+		for (lyra::uint32 c = 0; c < Channels; c++) axis[c] = next[c] / length;
+	}
+
+	lyra::float32 axisLength = 0.0f;
+	for (lyra::uint32 c = 0; c < Channels; c++) axisLength += axis[c] * axis[c];
+
+	if (axisLength == 0.0f) { // all texels are identical
+		begin = mean;
+		end = mean;
+		return;
+	}
+
+	lyra::float32 minT = std::numeric_limits<lyra::float32>::max(), maxT = std::numeric_limits<lyra::float32>::lowest();
+
+	for (const auto& texel : block) {
+		lyra::float32 t = 0.0f;
+		for (lyra::uint32 c = 0; c < Channels; c++) t += (texel[c] - mean[c]) * axis[c];
+
+		minT = std::min(minT, t / axisLength);
+		maxT = std::max(maxT, t / axisLength);
+	}
+
+	for (lyra::uint32 c = 0; c < Channels; c++) {
+		begin[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+		end[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+	}
+}
+
+lyra::uint16 packRGB565(const lsd::Array<lyra::float32, 4>& color) noexcept {
+	return static_cast<lyra::uint16>(
+		(static_cast<lyra::uint32>(color[0] * 31.0f / 255.0f + 0.5f) << 11) |
+		(static_cast<lyra::uint32>(color[1] * 63.0f / 255.0f + 0.5f) << 5) |
+		static_cast<lyra::uint32>(color[2] * 31.0f / 255.0f + 0.5f)
+	);
+}
+lsd::Array<lyra::int32, 4> unpackRGB565(lyra::uint16 color) noexcept {
+	lyra::int32 r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+	return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255 };
+}
+
+// opaque four color block
+void encodeBC1(const Block& block, lyra::uint8* dst) noexcept {
+	lsd::Array<lyra::float32, 4> begin { }, end { };
+	principalEndpoints<3>(block, begin, end);
+
+	auto color0 = packRGB565(end), color1 = packRGB565(begin);
+	if (color0 < color1) std::swap(color0, color1);
+
+	lyra::uint32 indices = 0;
+
+	if (color0 != color1) {
+		auto c0 = unpackRGB565(color0), c1 = unpackRGB565(color1);
+
+		lsd::Array<lsd::Array<lyra::int32, 4>, 4> palette {{ c0, c1, { }, { } }};
+		for (lyra::uint32 c = 0; c < 3; c++) {
+			palette[2][c] = (2 * c0[c] + c1[c]) / 3;
+			palette[3][c] = (c0[c] + 2 * c1[c]) / 3;
+		}
+
+		for (lyra::uint32 i = 0; i < 16; i++) {
+			lyra::uint32 best = 0, bestDistance = std::numeric_limits<lyra::uint32>::max();
+
+			for (lyra::uint32 j = 0; j < 4; j++) {
+				if (auto d = distance(block[i], palette[j], 3); d < bestDistance) {
+					best = j;
+					bestDistance = d;
+				}
+			}
+
+			indices |= best << (i * 2);
+		}
+	}
+
+	std::memcpy(dst, &color0, sizeof(lyra::uint16));
+	std::memcpy(dst + 2, &color1, sizeof(lyra::uint16));
+	std::memcpy(dst + 4, &indices, sizeof(lyra::uint32));
+}
+
+// single channel block using the eight value mode
+void encodeBC4(const Block& block, lyra::uint32 channel, lyra::uint8* dst) noexcept {
+	lyra::uint8 low = 255, high = 0;
+
+	for (const auto& texel : block) {
+		low = std::min(low, texel[channel]);
+		high = std::max(high, texel[channel]);
+	}
+
+	std::memset(dst, 0, 8);
+	dst[0] = high;
+	dst[1] = low;
+
+	if (high == low) return;
+
+	lsd::Array<lyra::int32, 8> palette { high, low };
+	for (lyra::int32 i = 2; i < 8; i++) palette[i] = ((8 - i) * high + (i - 1) * low + 3) / 7;
+
+	BitWriter writer(dst + 2);
+
+	for (const auto& texel : block) {
+		lyra::uint32 best = 0;
+		lyra::int32 bestDistance = std::numeric_limits<lyra::int32>::max();
+
+		for (lyra::uint32 j = 0; j < 8; j++) {
+			if (auto d = std::abs(texel[channel] - palette[j]); d < bestDistance) {
+				best = j;
+				bestDistance = d;
+			}
+		}
+
+		writer.write(best, 3);
+	}
+}
+
+// mode 6, a single subset with 7 bit RGBA endpoints, a p-bit per endpoint and 4 bit indices
+void encodeBC7(const Block& block, lyra::uint8* dst) noexcept {
+	static constexpr lsd::Array<lyra::int32, 16> weights { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	lsd::Array<lyra::float32, 4> begin { }, end { };
+	principalEndpoints<4>(block, begin, end);
+
+	lsd::Array<lyra::uint32, 4> bestEndpoints[2];
+	lyra::uint32 bestPBits[2] { };
+	lsd::Array<lyra::uint32, 16> bestIndices { };
+	lyra::uint32 bestError = std::numeric_limits<lyra::uint32>::max();
+
+	// try every combination of p-bits, since they shift the quantized endpoints differently
+	for (lyra::uint32 pBits = 0; pBits < 4; pBits++) {
+		lyra::uint32 p[2] { pBits & 1, pBits >> 1 };
+		lsd::Array<lyra::uint32, 4> endpoints[2];
+		lsd::Array<lyra::int32, 4> decoded[2];
+
+		for (lyra::uint32 e = 0; e < 2; e++) {
+			const auto& color = (e == 0) ? begin : end;
+
+			for (lyra::uint32 c = 0; c < 4; c++) {
+				endpoints[e][c] = static_cast<lyra::uint32>(std::clamp((color[c] - p[e]) / 2.0f + 0.5f, 0.0f, 127.0f));
+				decoded[e][c] = static_cast<lyra::int32>((endpoints[e][c] << 1) | p[e]);
+			}
+		}
+
+		lsd::Array<lsd::Array<lyra::int32, 4>, 16> palette;
+		for (lyra::uint32 i = 0; i < 16; i++) {
+			for (lyra::uint32 c = 0; c < 4; c++) palette[i][c] = ((64 - weights[i]) * decoded[0][c] + weights[i] * decoded[1][c] + 32) >> 6;
+		}
+
+		lsd::Array<lyra::uint32, 16> indices;
+		lyra::uint32 error = 0;
+
+		for (lyra::uint32 i = 0; i < 16; i++) {
+			lyra::uint32 bestDistance = std::numeric_limits<lyra::uint32>::max();
+
+			for (lyra::uint32 j = 0; j < 16; j++) {
+				if (auto d = distance(block[i], palette[j], 4); d < bestDistance) {
+					indices[i] = j;
+					bestDistance = d;
+				}
+			}
+
+			error += bestDistance;
+		}
+
+		if (error < bestError) {
+			bestError = error;
+			bestEndpoints[0] = endpoints[0];
+			bestEndpoints[1] = endpoints[1];
+			bestPBits[0] = p[0];
+			bestPBits[1] = p[1];
+			bestIndices = indices;
+		}
+	}
+
+	// the most significant bit of the first index is implicitly zero, swap the endpoints if it would be set
+	if (bestIndices[0] & 8) {
+		std::swap(bestEndpoints[0], bestEndpoints[1]);
+		std::swap(bestPBits[0], bestPBits[1]);
+		for (auto& index : bestIndices) index = 15 - index;
+	}
+
+	std::memset(dst, 0, 16);
+	BitWriter writer(dst);
+
+	writer.write(1 << 6, 7);
+	for (lyra::uint32 c = 0; c < 4; c++) {
+		writer.write(bestEndpoints[0][c], 7);
+		writer.write(bestEndpoints[1][c], 7);
+	}
+	writer.write(bestPBits[0], 1);
+	writer.write(bestPBits[1], 1);
+
+	writer.write(bestIndices[0], 3);
+	for (lyra::uint32 i = 1; i < 16; i++) writer.write(bestIndices[i], 4);
+}
+
+void encodeBlock(const Block& block, lyra::resource::TextureFormat format, lyra::uint8* dst) noexcept {
+	using lyra::resource::TextureFormat;
+
+	switch (format) {
+		case TextureFormat::bc1:
+			encodeBC1(block, dst);
+			break;
+		case TextureFormat::bc3:
+			encodeBC4(block, 3, dst);
+			encodeBC1(block, dst + 8);
+			break;
+		case TextureFormat::bc4:
+			encodeBC4(block, 0, dst);
+			break;
+		case TextureFormat::bc5:
+			encodeBC4(block, 0, dst);
+			encodeBC4(block, 1, dst + 8);
+			break;
+		case TextureFormat::bc7:
+			encodeBC7(block, dst);
+			break;
+		default:
+			break;
+	}
+}
+
+} // namespace
+
+
+lyra::resource::TextureFormat selectFormat(Encoding encoding, lyra::uint32 type) {
+	using lyra::resource::TextureFormat;
+
+	if (encoding != Encoding::automatic) return static_cast<TextureFormat>(static_cast<lyra::uint32>(encoding) - 1);
+
+	switch (static_cast<Type>(type)) {
+		case Type::normalMap:
+			return TextureFormat::bc5;
+		case Type::shadowMask:
+			return TextureFormat::bc4;
+		default:
+			return TextureFormat::bc7;
+	}
+}
+
+lsd::Vector<char> encode(
+	const lyra::uint8* pixels,
+	lyra::uint32 width,
+	lyra::uint32 height,
+	lyra::uint32 levels,
+	lyra::uint32 type,
+	lyra::resource::TextureFormat format,
+	lyra::ThreadPool* workers
+) {
+	levels = std::max(levels, 1U);
+
+	lsd::Vector<char> result(lyra::resource::textureSize(format, width, height, levels));
+	auto dst = reinterpret_cast<lyra::uint8*>(result.data());
+
+	Level level = decodeBaseLevel(pixels, width, height, static_cast<Type>(type));
+
+	for (lyra::uint32 i = 0; i < levels; i++) {
+		if (i != 0) level = downsample(level, static_cast<Type>(type));
+
+		auto levelPixels = encodeLevel(level, static_cast<Type>(type));
+		auto levelSize = lyra::resource::textureLevelSize(format, level.width, level.height);
+
+		if (!lyra::resource::blockCompressed(format)) {
+			std::memcpy(dst, levelPixels.data(), levelSize);
+		} else {
+			auto blocksX = (level.width + 3) / 4, blocksY = (level.height + 3) / 4;
+			auto blockSize = lyra::resource::textureBlockSize(format);
+
+			auto encodeRow = [&](lyra::size_type blockY) {
+				Block block;
+
+				for (lyra::uint32 blockX = 0; blockX < blocksX; blockX++) {
+					// texels outside of the level repeat the closest edge texel
+					for (lyra::uint32 y = 0; y < 4; y++) {
+						auto sourceY = std::min(static_cast<lyra::uint32>(blockY) * 4 + y, level.height - 1);
+
+						for (lyra::uint32 x = 0; x < 4; x++) {
+							auto sourceX = std::min(blockX * 4 + x, level.width - 1);
+							std::memcpy(block[y * 4 + x].data(), &levelPixels[(sourceY * level.width + sourceX) * 4], 4);
+						}
+					}
+
+					encodeBlock(block, format, dst + (blockY * blocksX + blockX) * blockSize);
+				}
+			};
+
+			if (workers) workers->parallelFor(blocksY, encodeRow);
+			else for (lyra::uint32 y = 0; y < blocksY; y++) encodeRow(y);
+		}
+
+		dst += levelSize;
+	}
+
+	return result;
+}
+
+} // namespace texture
@@ -0,0 +1,42 @@
+/*************************
+ * @file TextureEncoder.h
+ *
+ * @brief Generates the mip chain of textures and encodes it into GPU block compressed formats
+ *************************/
+
+#pragma once
+
+#include <Common/Common.h>
+#include <Common/ThreadPool.h>
+
+#include <Resource/LoadTextureFile.h>
+
+#include <LSD/Vector.h>
+
+namespace texture {
+
+// encodings selectable in the project file, automatic picks the format by the type of the texture
+enum class Encoding : lyra::uint32 {
+	automatic,
+	rgba8,
+	bc1,
+	bc3,
+	bc4,
+	bc5,
+	bc7
+};
+
+NODISCARD lyra::resource::TextureFormat selectFormat(Encoding encoding, lyra::uint32 type);
+
+// generates levels mip levels from RGBA8 pixels and encodes all of them, starting with the largest one
+NODISCARD lsd::Vector<char> encode(
+	const lyra::uint8* pixels,
+	lyra::uint32 width,
+	lyra::uint32 height,
+	lyra::uint32 levels,
+	lyra::uint32 type,
+	lyra::resource::TextureFormat format,
+	lyra::ThreadPool* workers = nullptr
+);
+
+} // namespace texture
@@ -30,9 +30,47 @@
 #include <imgui.h>
 #include <imgui_internal.h>
 
+#include <string_view>
+
 using namespace lsd::enum_operators;
 
+namespace {
+
+// builds a project without creating a window or a render system, so builds can run on headless machines
+int buildHeadless(char* argv[], const std::filesystem::path& projectFilePath, bool rebuild) {
+	lyra::initLoggingSystem();
+	lyra::initFileSystem(argv);
+
+	ContentManager contentManager;
+	contentManager.loadRecent(projectFilePath);
+
+	if (!contentManager.validProject()) {
+		lyra::log::error("No project file was found at path: {}!", projectFilePath.string());
+		return 1;
+	}
+
+	if (rebuild) contentManager.rebuild();
+	else contentManager.build();
+
+	contentManager.wait();
+
+	return contentManager.buildFailed() ? 1 : 0;
+}
+
+}
+
 int main(int argc, char* argv[]) {
+	if (argc >= 2 && std::string_view(argv[1]).starts_with("--")) {
+		std::string_view command(argv[1]);
+
+		if (argc == 3 && (command == "--build" || command == "--rebuild")) {
+			return buildHeadless(argv, argv[2], command == "--rebuild");
+		} else {
+			std::fprintf(stderr, "Usage: %s [--build | --rebuild] <path to project file>\n", argv[0]);
+			return 1;
+		}
+	}
+
 	lyra::init(lyra::InitFlags::allExtended, { 
 		.argc = argc, 
 		.argv = argv,
@@ -72,6 +110,10 @@ int main(int argc, char* argv[]) {
 			if (contentManager.close()) break;
 		}
 
+		contentManager.update();
+		state.building = contentManager.building();
+		state.buildProgress = contentManager.buildProgress();
+
 
 		lyra::renderer::beginFrame();
 
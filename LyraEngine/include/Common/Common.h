@@ -107,11 +107,13 @@ class Swapchain;
 class RenderTarget;
 class Shader;
 class DescriptorSets;
+class Program;
 class GraphicsProgram;
 class GraphicsPipeline;
 class ComputeProgram;
 class ComputePipeline;
 class DescriptorPools;
+class TransientDescriptorPools;
 class ImGuiRenderer;
 
 } // namespace vulkan
@@ -45,13 +45,47 @@ inline constexpr lsd::Array<const char*, 1> requestedValidationLayers({ "VK_LAYE
 inline constexpr size_type maxFramesInFlight = 2;
 inline constexpr size_type maxSwapchainImages = 8;
 inline constexpr size_type maxConcurrentRenderers = 16;
-inline constexpr size_type maxDescriptorPoolSets = 512;
+inline constexpr size_type maxDescriptorPoolSets = 64; // sets of one size class per descriptor pool
+inline constexpr size_type maxDescriptorPoolDescriptors = 4096; // pools of size classes with large sets contain fewer sets
+inline constexpr size_type transientDescriptorPoolSets = 256; // sets per pool of the per frame descriptor allocator
 inline constexpr size_type maxShaderSets = 4;
-inline constexpr size_type descriptorPoolAllocCount = 16;
-inline constexpr uint32 maxDynamicBindings = 64;
+inline constexpr uint32 bindlessTextureCapacity = 4096; // size of the texture array shared by all materials, clamped to the limits of the device
 inline constexpr bool enableAnistropy = true;
 inline constexpr float32 anistropyStrength = 1.0f;
 inline constexpr float32 resolution = 100;
+inline constexpr lsd::StringView pipelineCachePath = "data/pipeline.cache"; // relative to the executable
+inline constexpr bool parallelRecording = true; // record draw calls on worker threads into secondary command buffers
+inline constexpr size_type drawsPerCommandBuffer = 256; // draws recorded into one secondary command buffer, render targets with fewer draws are recorded inline
+// formats the vertex attributes of meshes are stored in on the GPU, normals are always octahedral encoded into two 16 bit normalized integers
+// meshes built by LyraAssets are packed with these formats and have to be rebuilt after changing them
+enum class VertexPositionFormat {
+	float32,
+	float16,
+	snorm16 // relative to the bounds of the mesh, the dequantization is part of the instance transform
+};
+
+enum class VertexColorFormat {
+	float32,
+	unorm8
+};
+
+enum class VertexTexCoordFormat {
+	float32,
+	float16
+};
+
+inline constexpr VertexPositionFormat vertexPositionFormat = VertexPositionFormat::snorm16;
+inline constexpr VertexColorFormat vertexColorFormat = VertexColorFormat::unorm8;
+inline constexpr VertexTexCoordFormat vertexTexCoordFormat = VertexTexCoordFormat::float16;
+inline constexpr uint32 geometryVertexCapacity = 1024 * 1024; // initial size of the vertex and index buffers shared by all meshes, they grow if they run out of space
+inline constexpr uint32 geometryIndexCapacity = 4 * 1024 * 1024;
+inline constexpr uint32 maxMeshLods = 8; // levels of detail LyraAssets generates at most per mesh, including the original
+inline constexpr float32 lodPixelError = 1.0f; // largest simplification error in pixels a level of detail may have on screen to be selected
+inline constexpr float32 lodHysteresis = 0.25f; // fraction the error has to pass the threshold by before the level changes, so it does not flicker at the boundary
+inline constexpr uint32 maxMeshletVertices = 64; // limits of the clusters LyraAssets splits the index blocks of meshes into
+inline constexpr uint32 maxMeshletTriangles = 124;
+inline constexpr uint32 instanceCapacity = 4096; // initial number of instances and indirect draws per frame
+inline constexpr uint32 materialCapacity = 256; // initial number of materials in the material buffer, it grows if it runs out of space
 
 inline constexpr lsd::StringView title = "Lyra Engine";
 inline constexpr lsd::StringView iconPath = "";
@@ -206,6 +206,78 @@ using ByteFile = File<char>;
 using WideFile = File<wchar>;
 
 
+// Read only view into a file mapped directly into memory
+// Reads straight from the page cache without copying into an intermediate buffer
+// All views of a file share the same mapping, which stays alive for as long as any view still references it
+// Files written to after they were mapped are mapped again for new views, existing views should be closed before a file is truncated
+class MappedFile {
+public:
+	struct Mapping {
+		Mapping() = default;
+		Mapping(const std::filesystem::path& path);
+		Mapping(const Mapping&) = delete;
+		~Mapping();
+
+		Mapping& operator=(const Mapping&) = delete;
+
+		const char* data = nullptr; // points to an empty string if the file is empty
+		size_type size = 0;
+		std::filesystem::file_time_type writeTime { }; // the mapping is replaced once the file was written to
+	};
+
+	using mapping_type = lsd::SharedPointer<Mapping>;
+
+	MappedFile() = default;
+	// unshared views bypass the cached mappings and always see the current contents of the file, f.e. for files rebuilt while the program is running
+	MappedFile(const std::filesystem::path& path, bool shared = true);
+	// create a view into a section of an already mapped file, sharing its mapping
+	MappedFile(const MappedFile& file, size_type offset, size_type size);
+
+	void close();
+
+	NODISCARD const char* data() const noexcept {
+		return m_data;
+	}
+	NODISCARD size_type size() const noexcept {
+		return m_size;
+	}
+	NODISCARD const char* begin() const noexcept {
+		return m_data;
+	}
+	NODISCARD const char* end() const noexcept {
+		return m_data + m_size;
+	}
+	NODISCARD bool empty() const noexcept {
+		return m_size == 0;
+	}
+
+	NODISCARD bool good() const noexcept {
+		return m_data != nullptr;
+	}
+	bool operator!() const noexcept {
+		return !good();
+	}
+	operator bool() const noexcept {
+		return good();
+	}
+
+	NODISCARD std::filesystem::path path() const noexcept {
+		return m_path;
+	}
+	NODISCARD const mapping_type& mapping() const noexcept {
+		return m_mapping;
+	}
+
+private:
+	mapping_type m_mapping = nullptr;
+
+	const char* m_data = nullptr;
+	size_type m_size = 0;
+
+	std::filesystem::path m_path;
+};
+
+
 // Higher level class to read from and write to file loaded into a standard-style container
 // Implements most functions found in the standard IO library, therefore slower than Byte- / WideFile
 // Does not call internal file functions whilst reading, but may do so with most other functions
@@ -513,6 +585,7 @@ inline bool fileExists(const std::filesystem::path& path) {
 }
 
 bool fileLoaded(const std::filesystem::path& path);
+bool fileMapped(const std::filesystem::path& path);
 
 NODISCARD ByteFile tmpFile();
 
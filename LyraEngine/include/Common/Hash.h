@@ -0,0 +1,44 @@
+/*************************
+ * @file Hash.h
+ *
+ * @brief Small, stable 64 bit hashing utility
+ * @brief Unlike std::hash, the results are identical across platforms and runs, so they are safe to write to disk
+ *************************/
+
+#pragma once
+
+#include <Common/Common.h>
+
+#include <string_view>
+
+namespace lyra {
+
+inline constexpr uint64 fnvOffsetBasis = 14695981039346656037ULL;
+inline constexpr uint64 fnvPrime = 1099511628211ULL;
+
+// FNV-1a hash of a range of bytes
+NODISCARD constexpr uint64 hashBytes(std::string_view data, uint64 seed = fnvOffsetBasis) noexcept {
+	for (auto c : data) {
+		seed ^= static_cast<uint8>(c);
+		seed *= fnvPrime;
+	}
+
+	return seed;
+}
+NODISCARD inline uint64 hashBytes(const void* data, size_type size, uint64 seed = fnvOffsetBasis) noexcept {
+	return hashBytes(std::string_view(static_cast<const char*>(data), size), seed);
+}
+
+// mixes an additional value into an existing hash
+NODISCARD constexpr uint64 hashCombine(uint64 seed, uint64 value) noexcept {
+	value *= 0x9E3779B97F4A7C15ULL;
+	value ^= value >> 32;
+	return (seed ^ value) * fnvPrime;
+}
+// mixes several integral or enum values into an existing hash, in order
+template <class... Values> NODISCARD constexpr uint64 hashCombine(uint64 seed, Values... values) noexcept {
+	((seed = hashCombine(seed, static_cast<uint64>(values))), ...);
+	return seed;
+}
+
+} // namespace lyra
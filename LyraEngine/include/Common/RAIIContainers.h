@@ -106,7 +106,7 @@ public:
 			} else if constexpr (std::same_as<handle_type, VkShaderModule>) {
 				VULKAN_ASSERT(vkCreateShaderModule(this->m_owner, &createInfo, nullptr, &this->m_handle), "create shader module");
 			} else if constexpr (std::same_as<handle_type, VkPipelineCache>) {
-				VULKAN_ASSERT(vkCreatePipelineCache(&createInfo, nullptr, &this->m_handle), "create pipeline cache");
+				VULKAN_ASSERT(vkCreatePipelineCache(this->m_owner, &createInfo, nullptr, &this->m_handle), "create pipeline cache");
 			} else if constexpr (std::same_as<handle_type, VkSwapchainKHR>) {
 				VULKAN_ASSERT(vkCreateSwapchainKHR(this->m_owner, &createInfo, nullptr, &this->m_handle), "create swapchain");
 			} else if constexpr (std::same_as<handle_type, VmaAllocator>) {
@@ -0,0 +1,83 @@
+/*************************
+ * @file ThreadPool.h
+ *
+ * @brief A simple pool of worker threads executing queued tasks
+ *************************/
+
+#pragma once
+
+#include <Common/Common.h>
+
+#include <LSD/Vector.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace lyra {
+
+class ThreadPool {
+public:
+	using task_type = std::function<void()>;
+
+	// defaults to one worker less than the hardware supports, since the thread owning the pool is usually busy as well
+	ThreadPool(uint32 threadCount = defaultThreadCount());
+	ThreadPool(const ThreadPool&) = delete;
+	~ThreadPool();
+
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	template <class Func, class... Args> NODISCARD auto enqueue(Func&& func, Args&&... args) -> std::future<std::invoke_result_t<Func, Args...>> {
+		using result_type = std::invoke_result_t<Func, Args...>;
+
+		// std::function requires a copyable target, so the task has to be shared
+		auto task = std::make_shared<std::packaged_task<result_type()>>(
+			std::bind(std::forward<Func>(func), std::forward<Args>(args)...)
+		);
+		auto future = task->get_future();
+
+		push([task]() { (*task)(); });
+
+		return future;
+	}
+	void push(task_type&& task);
+
+	// calls func for every index in [0, count), the calling thread takes part in the work as well
+	// since the caller never idles, this may safely be called from inside another task of this pool
+	void parallelFor(size_type count, const std::function<void(size_type)>& func);
+	// the slot is in [0, size()] and unique among the threads working on this call, 0 is the calling thread
+	// unlike an index of the thread, it stays in range no matter which thread or pool the call comes from
+	void parallelFor(size_type count, const std::function<void(size_type index, uint32 slot)>& func);
+
+	// blocks until the queue is empty and no task is executing anymore
+	void wait();
+
+	NODISCARD uint32 size() const noexcept {
+		return static_cast<uint32>(m_threads.size());
+	}
+
+	NODISCARD static uint32 defaultThreadCount() noexcept {
+		return std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	}
+
+private:
+	lsd::Vector<std::thread> m_threads;
+
+	std::deque<task_type> m_tasks;
+	size_type m_activeTasks = 0;
+	bool m_stop = false;
+
+	std::mutex m_mutex;
+	std::condition_variable m_taskCondition;
+	std::condition_variable m_idleCondition;
+
+	void work();
+};
+
+} // namespace lyra
@@ -24,6 +24,8 @@
 #include <Graphics/Renderer.h>
 #include <Graphics/VulkanRenderSystem.h>
 
+#include <Math/Culling.h>
+
 #include <glm/glm.hpp>
 
 #include <LSD/Vector.h>
@@ -43,10 +45,10 @@ public:
 		none
 	};
 
+	// the transform of the meshes is stored per instance, so this fits into the guaranteed 128 bytes of push constants
 	struct TransformData {
-		alignas(16) glm::mat4 model;
+		alignas(16) glm::mat4 view;
 		alignas(16) glm::mat4 proj;
-		alignas(16) glm::mat4 mesh;
 	};
 
 	Camera(float32 fov = 45.0f, float32 near = 0.1f, float32 far = 100.0f) {
@@ -65,7 +67,8 @@ public:
 	NODISCARD constexpr float32 near() const noexcept { return m_near; }
 	NODISCARD constexpr float32 far() const noexcept { return m_far; }
 	NODISCARD constexpr float32 aspect() const noexcept { return m_aspect; }
-	NODISCARD TransformData data(const glm::mat4& meshTransform) const noexcept;
+	NODISCARD TransformData data() const noexcept;
+	NODISCARD Frustum frustum() const;
 
 	glm::vec2 viewportSize = { 1.0f, 1.0f };
 	glm::vec2 viewportPosition = { 0.0f, 0.0f };
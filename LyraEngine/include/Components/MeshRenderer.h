@@ -23,6 +23,7 @@
 #include <Graphics/Material.h>
 
 #include <LSD/Vector.h>
+#include <LSD/UnorderedSparseMap.h>
 
 namespace lyra {
 
@@ -40,19 +41,20 @@ public:
 	NODISCARD constexpr const Mesh* mesh() const noexcept {
 		return m_mesh;
 	}
-	NODISCARD constexpr const vulkan::GPUBuffer& vertexBuffer() const noexcept {
-		return m_vertexBuffer;
-	}
-	NODISCARD constexpr const vulkan::GPUBuffer& indexBuffer() const noexcept {
-		return m_indexBuffer;
+	// location of the mesh in the geometry buffer shared by all meshes
+	NODISCARD constexpr const vulkan::GeometryBuffer::Range& geometry() const noexcept {
+		return m_geometry;
 	}
 
 private:
 	const Mesh* m_mesh;
 	Material* m_material;
 
-	vulkan::GPUBuffer m_vertexBuffer;
-	vulkan::GPUBuffer m_indexBuffer;
+	vulkan::GeometryBuffer::Range m_geometry;
+
+	// level of detail selected for every camera in the previous frame, the selection depends on it to avoid flickering
+	// keyed by the camera, since the position of a camera in the render system changes when other cameras are added or removed
+	lsd::UnorderedSparseMap<const Camera*, uint32> m_lods;
 
 	void update() { };
 
@@ -0,0 +1,163 @@
+/*************************
+ * @file CullingPass.h
+ *
+ * @brief GPU frustum and occlusion culling with compute shaders
+ * @brief the pass writes the visible instances and a compacted list of indirect draws for every batch, which can be drawn with drawIndexedIndirectCount
+ * @brief the pass is standalone, renderer::draw() still culls on the CPU, since the swapchain depth is multisampled and cannot be the source of a depth pyramid
+ *************************/
+
+#pragma once
+
+#include <Common/Common.h>
+
+#include <LSD/Vector.h>
+
+#include <Graphics/VulkanRenderSystem.h>
+
+#include <glm/glm.hpp>
+
+namespace lyra {
+
+namespace vulkan {
+
+/**
+ * @brief a mip chain of the depth buffer, in which every texel stores the farthest depth of the texels it covers
+ * @brief the levels are sized to powers of two, so every texel of a level covers exactly four texels of the level below
+ */
+class DepthPyramid {
+public:
+	static constexpr uint32 localSize = 8;
+
+	DepthPyramid() = default;
+	// the size of the first level is the largest power of two which is not bigger than the extent of the depth source
+	DepthPyramid(const glm::uvec2& sourceExtent);
+
+	// sets the depth view the first level is reduced from, it has to be single sampled and in the shader read only layout when building
+	void setSource(const VkImageView& sourceView, const glm::uvec2& sourceExtent);
+	// reduces the source into every level, the pyramid is in the general layout afterwards and may be read by compute shaders
+	void build(const CommandQueue::CommandBuffer& commandBuffer) const;
+
+	NODISCARD constexpr uint32 levelCount() const noexcept { return static_cast<uint32>(levels.size()); }
+
+	Image image;
+	GPUMemory memory;
+
+	// view of the entire mip chain, used for sampling
+	Image::Resource resource;
+	// views of the single levels, used as storage images while reducing
+	lsd::Vector<Image::Resource> levels;
+
+	vk::Sampler sampler;
+
+	glm::uvec2 extent;
+	glm::uvec2 sourceExtent;
+
+	ComputeProgram program;
+	ComputePipeline pipeline;
+
+	// the set at index i reduces the previous level, or the source at index 0, into level i
+	lsd::Vector<vk::DescriptorSet> descriptorSets;
+};
+
+/**
+ * @brief culls instances against a frustum and optionally a depth pyramid of the previous frame
+ * @brief the buffers are not duplicated for frames in flight, so a pass should be created for every frame which is culled concurrently
+ */
+class CullingPass {
+public:
+	static constexpr uint32 localSize = 64;
+
+	// world space bounding sphere of a single instance
+	struct Candidate {
+		glm::vec4 sphere; // center in xyz, radius in w
+		uint32 instance; // index of the instance data
+		uint32 draw; // index of the draw the instance belongs to
+		uint32 padding[2];
+	};
+
+	// all instances of a draw have to be in the same range of the instance data, starting at the first instance of the command
+	struct Draw {
+		VkDrawIndexedIndirectCommand command;
+		uint32 batch; // draws of a batch are compacted into the same range of the output
+		uint32 firstOutput; // first output draw of the batch
+		uint32 padding;
+	};
+
+	struct PushConstants {
+		glm::mat4 viewProjection;
+		glm::vec2 pyramidExtent;
+		uint32 candidateCount;
+		uint32 drawCount;
+		uint32 occlusion;
+	};
+
+	CullingPass(uint32 candidateCapacity = config::instanceCapacity, uint32 drawCapacity = config::instanceCapacity, uint32 batchCapacity = 64);
+	~CullingPass();
+
+	// makes sure the buffers fit the counts, the GPU has to be finished executing the pass
+	void reserve(uint32 candidateCount, uint32 drawCount, uint32 batchCount);
+	// makes the first candidates, draws and instances written by the CPU visible to the GPU, called by record
+	void flush(uint32 candidateCount, uint32 drawCount) const;
+	// the depth pyramid has to stay alive as long as the pass uses it
+	void setDepthPyramid(const DepthPyramid& depthPyramid);
+
+	/**
+	 * @brief records the culling of the first candidateCount candidates into the command buffer
+	 *
+	 * @param commandBuffer command buffer to record into
+	 * @param viewProjection matrix the frustum is extracted from, with a zero to one depth range
+	 * @param candidateCount number of candidates written to candidates
+	 * @param drawCount number of draws written to draws
+	 * @param batchCount number of batches the draws reference
+	 * @param occlusion test the candidates against the depth pyramid as well, which has to be built already
+	 */
+	void record(
+		const CommandQueue::CommandBuffer& commandBuffer,
+		const glm::mat4& viewProjection,
+		uint32 candidateCount,
+		uint32 drawCount,
+		uint32 batchCount,
+		bool occlusion = false
+	) const;
+
+	// draws the visible draws of a batch, the index and vertex buffers have to be bound already
+	void draw(const CommandQueue::CommandBuffer& commandBuffer, uint32 batch, uint32 firstOutput, uint32 maxDrawCount) const;
+
+private:
+	void create(uint32 candidateCapacity, uint32 drawCapacity, uint32 batchCapacity);
+	void destroy();
+	void updateDescriptorSet() const;
+
+public:
+	ComputeProgram cullProgram;
+	ComputePipeline cullPipeline;
+	ComputeProgram compactProgram;
+	ComputePipeline compactPipeline;
+
+	// written by the CPU, stay mapped for their entire lifetime
+	GPUBuffer candidateBuffer;
+	GPUBuffer drawBuffer;
+	GPUBuffer instanceBuffer;
+
+	// written by the GPU
+	GPUBuffer visibleInstanceBuffer;
+	GPUBuffer visibleCountBuffer;
+	GPUBuffer outputDrawBuffer;
+	GPUBuffer drawCountBuffer;
+
+	Candidate* candidates = nullptr;
+	Draw* draws = nullptr;
+	InstanceBuffer::InstanceData* instances = nullptr;
+
+	vk::DescriptorSet descriptorSet;
+
+	const DepthPyramid* depthPyramid = nullptr;
+
+	uint32 candidateCapacity = 0;
+	uint32 drawCapacity = 0;
+	uint32 batchCapacity = 0;
+};
+
+} // namespace vulkan
+
+} // namespace lyra
@@ -23,15 +23,6 @@ namespace lyra {
 
 class Material {
 public:
-	struct FragmentShaderData {
-		alignas(16) Color albedoColor;
-		alignas(16) Color emissionColor;
-		alignas(16) Color specularColor;
-		alignas(16) Color occlusionColor;
-		alignas(8) float32 metallic;
-		alignas(8) float32 roughness;
-	};
-
 	Material(
 		const Color& albedoColor = Color(),
 		const lsd::Vector<const Texture*>& albedoTextures = { },
@@ -49,34 +40,40 @@ public:
 		const vulkan::GraphicsPipeline::Builder& pipelineBuilder = { },
 		const vulkan::GraphicsProgram::Builder& programBuilder = { }
 	);
+	Material(const Material&) = delete;
+	// releases the slots of the material and its textures in the material table
+	~Material();
 
-private:
-	lsd::Array<vulkan::GPUBuffer, config::maxFramesInFlight> m_fragShaderBuffers;
+	Material& operator=(const Material&) = delete;
+
+	// changing a parameter only rewrites the data of the material in the material table
+	void setAlbedoColor(const Color& color);
+	void setEmissionColor(const Color& color);
+	void setSpecularColor(const Color& color);
+	void setOcclusionColor(const Color& color);
+	void setMetallic(float32 metallic);
+	void setRoughness(float32 roughness);
 
+	NODISCARD constexpr const vulkan::MaterialTable::MaterialData& data() const noexcept { return m_data; }
+	// index of the material in the material table, which is passed to the shaders with the instance data
+	NODISCARD constexpr uint32 index() const noexcept { return m_index; }
+
+private:
 	vulkan::GraphicsPipeline* m_graphicsPipeline = nullptr;
 
-	vulkan::DescriptorSets m_descriptorSets;
+	vulkan::MaterialTable::MaterialData m_data;
+	uint32 m_index;
 
-	Color m_albedoColor;
 	lsd::Vector<const Texture*> m_albedoTextures;
-
-	float32 m_metallic;
-	float32 m_roughness;
 	const Texture* m_metallicTexture;
-
-	Color m_specularColor;
 	const Texture* m_specularTexture;
-
-	Color m_emissionColor;
 	const Texture* m_emissionTexture;
-	
 	const Texture* m_normalMapTexture;
-
 	const Texture* m_displacementMapTexture;
-
-	Color m_occlusionColor;
 	const Texture* m_occlusionMapTexture;
 
+	void update();
+
 	friend void renderer::draw();
 	friend void renderer::setScene(etcs::Entity&);
 };
@@ -13,20 +13,29 @@
 #pragma once
 
 #include <Common/Common.h>
+#include <Common/Config.h>
 #include <LSD/Array.h>
 
 #include <Resource/LoadMeshFile.h>
 
+#include <Math/Culling.h>
+
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
 
 #include <vulkan/vulkan.h>
 
 #include <LSD/Vector.h>
 
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
 namespace lyra {
 
 class Mesh {
 public:
+	// a vertex in full precision, which is packed into the layout selected in the config when the mesh is created
 	struct Vertex {
 		glm::vec3 pos = glm::vec3(1.0f);
 		glm::vec3 normal = glm::vec3(1.0f);
@@ -35,68 +44,197 @@ public:
 
 		constexpr Vertex() = default;
 		constexpr Vertex(const glm::vec3& pos, const glm::vec3& normal, const glm::vec3& color, const glm::vec3& uvw) : pos(pos), normal(normal), color(color), uvw(uvw) { }
+	};
+
+	// a vertex in the layout it is stored in on the GPU, the vertex input converts every attribute back to floats
+	struct PackedVertex {
+		using Position = std::conditional_t<
+			config::vertexPositionFormat == config::VertexPositionFormat::float32,
+			glm::vec3,
+			std::conditional_t<config::vertexPositionFormat == config::VertexPositionFormat::float16, glm::u16vec4, glm::i16vec4>
+		>;
+		using Color = std::conditional_t<config::vertexColorFormat == config::VertexColorFormat::float32, glm::vec3, glm::u8vec4>;
+		using TexCoord = std::conditional_t<config::vertexTexCoordFormat == config::VertexTexCoordFormat::float32, glm::vec3, glm::u16vec4>;
+
+		// identifies the layout in built mesh files, the highest byte is the version of the mesh file format itself
+		static constexpr uint32 layout =
+			static_cast<uint32>(config::vertexPositionFormat) |
+			(static_cast<uint32>(config::vertexColorFormat) << 8) |
+			(static_cast<uint32>(config::vertexTexCoordFormat) << 16) |
+			(4u << 24);
+
+		Position pos;
+		glm::i16vec2 normal; // octahedral encoded
+		Color color;
+		TexCoord uvw;
 
 		NODISCARD static constexpr VkVertexInputBindingDescription bindingDescription() noexcept {
 			return {
 				0,
-				sizeof(Vertex),
+				sizeof(PackedVertex),
 				VK_VERTEX_INPUT_RATE_VERTEX
 			};
 		}
 
 		NODISCARD static constexpr lsd::Array<VkVertexInputAttributeDescription, 4> attributeDescriptions() noexcept {
+			constexpr VkFormat positionFormat =
+				(config::vertexPositionFormat == config::VertexPositionFormat::float32) ? VK_FORMAT_R32G32B32_SFLOAT :
+				(config::vertexPositionFormat == config::VertexPositionFormat::float16) ? VK_FORMAT_R16G16B16A16_SFLOAT :
+				VK_FORMAT_R16G16B16A16_SNORM;
+			constexpr VkFormat colorFormat = (config::vertexColorFormat == config::VertexColorFormat::float32) ? VK_FORMAT_R32G32B32_SFLOAT : VK_FORMAT_R8G8B8A8_UNORM;
+			constexpr VkFormat texCoordFormat = (config::vertexTexCoordFormat == config::VertexTexCoordFormat::float32) ? VK_FORMAT_R32G32B32_SFLOAT : VK_FORMAT_R16G16B16A16_SFLOAT;
+
 			return {
 				{{
 					0,
 					0,
-					VK_FORMAT_R32G32B32_SFLOAT,
-					offsetof(Vertex, pos)
+					positionFormat,
+					offsetof(PackedVertex, pos)
 				},
 				{
 					1,
 					0,
-					VK_FORMAT_R32G32B32_SFLOAT,
-					offsetof(Vertex, normal)
+					VK_FORMAT_R16G16_SNORM,
+					offsetof(PackedVertex, normal)
 				},
 				{
 					2,
 					0,
-					VK_FORMAT_R32G32B32_SFLOAT,
-					offsetof(Vertex, color)
+					colorFormat,
+					offsetof(PackedVertex, color)
 				},
 				{
 					3,
 					0,
-					VK_FORMAT_R32G32B32_SFLOAT,
-					offsetof(Vertex, uvw)
+					texCoordFormat,
+					offsetof(PackedVertex, uvw)
 				}}
 			};
 		}
 	};
 
+	// a range of the indices, all levels of detail index the same vertices
+	struct Lod {
+		uint32 firstIndex;
+		uint32 indexCount;
+		float32 error; // largest distance to the original surface, relative to the radius of the bounds
+
+		// the meshlets of the level cover its indices in order, meshes which were not built by LyraAssets have none
+		uint32 firstMeshlet = 0;
+		uint32 meshletCount = 0;
+	};
+
 	constexpr Mesh() = default;
 
-	WIN32_CONSTEXPR Mesh(const resource::MeshFile& mesh, uint32 index) : 
-		m_vertices(mesh.vertexBlocks[index]), 
-		m_indices(mesh.indexData[index]) { 
+	// the vertices in the file are already packed, the levels of detail are stored as consecutive index blocks
+	// the index blocks are 16 bit if the vertex block has few enough vertices for them
+	WIN32_CONSTEXPR Mesh(const resource::MeshFile& mesh, uint32 index) :
+		m_bounds(mesh.bounds[index]),
+		m_vertices(mesh.vertexBlocks[index]),
+		m_indexType(selectIndexType(mesh.vertexBlocks[index])) {
 		std::memcpy(
 			m_vertices.data(),
-			mesh.vertexData[index].data(), 
+			mesh.vertexData[index].data(),
 			mesh.vertexData[index].size()
 		);
+
+		const auto& lods = mesh.lods[index];
+
+		for (uint32 i = 0; i < lods.errors.size(); i++) {
+			const auto& indices = mesh.indexData[lods.firstIndexBlock + i];
+			const auto& meshlets = mesh.meshletData[lods.firstIndexBlock + i];
+
+			auto firstIndex = indexCount();
+			auto lodIndexCount = static_cast<uint32>(indices.size() / indexSize(m_indexType));
+
+			m_lods.pushBack({ firstIndex, lodIndexCount, lods.errors[i], static_cast<uint32>(m_meshlets.size()), static_cast<uint32>(meshlets.size()) });
+
+			if (m_indexType == VK_INDEX_TYPE_UINT16) {
+				m_shortIndices.resize(firstIndex + lodIndexCount);
+				std::memcpy(m_shortIndices.data() + firstIndex, indices.data(), indices.size());
+			} else {
+				m_indices.resize(firstIndex + lodIndexCount);
+				std::memcpy(m_indices.data() + firstIndex, indices.data(), indices.size());
+			}
+
+			// the meshlets in the file are relative to their index block
+			for (auto meshlet : meshlets) {
+				meshlet.firstIndex += firstIndex;
+				m_meshlets.pushBack(meshlet);
+			}
+		}
 	}
 
 	Mesh(
-		const lsd::Vector<Vertex>& vertices, 
+		const lsd::Vector<Vertex>& vertices,
 		const lsd::Vector<uint32>& indices
-	) : m_vertices(vertices), m_indices(indices) { }
+	) : m_bounds(calculateBounds(vertices)),
+		m_vertices(pack(vertices, m_bounds)),
+		m_indexType(selectIndexType(vertices.size())),
+		m_lods({ { 0, static_cast<uint32>(indices.size()), 0.0f } }) {
+		if (m_indexType == VK_INDEX_TYPE_UINT16) {
+			m_shortIndices.resize(indices.size());
+			std::transform(indices.begin(), indices.end(), m_shortIndices.begin(), [](uint32 index) { return static_cast<uint16>(index); });
+		} else {
+			m_indices = indices;
+		}
+	}
+
+	Mesh(const Mesh&) = default;
+	Mesh(Mesh&&) = default;
+	// the geometry buffer may not return the range of this mesh for a new mesh at the same address
+	~Mesh();
+
+	Mesh& operator=(const Mesh&) = default;
+	Mesh& operator=(Mesh&&) = default;
+
+	// 16 bit indices are used if they can address every vertex, the largest value is left out since it restarts primitives if primitive restart is enabled
+	NODISCARD static constexpr VkIndexType selectIndexType(size_type vertexCount) noexcept {
+		return (vertexCount <= std::numeric_limits<uint16>::max()) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+	}
+	NODISCARD static constexpr uint32 indexSize(VkIndexType indexType) noexcept {
+		return (indexType == VK_INDEX_TYPE_UINT16) ? sizeof(uint16) : sizeof(uint32);
+	}
 
-	NODISCARD const lsd::Vector<Vertex>& vertices() const noexcept { return m_vertices; }
+	// snorm16 positions are quantized relative to the center and extent of the bounds
+	NODISCARD static PackedVertex pack(const Vertex& vertex, const BoundingVolume& bounds);
+	NODISCARD static lsd::Vector<PackedVertex> pack(const lsd::Vector<Vertex>& vertices, const BoundingVolume& bounds);
+	NODISCARD static Vertex unpack(const PackedVertex& vertex, const BoundingVolume& bounds);
+
+	NODISCARD static BoundingVolume calculateBounds(const lsd::Vector<Vertex>& vertices) {
+		if (vertices.empty()) return { };
+		return BoundingVolume::fromPoints(&vertices[0].pos, vertices.size(), sizeof(Vertex));
+	}
+
+	// transforms the positions the vertex input reads into the space of the mesh, has to be applied before the model transform
+	NODISCARD glm::mat4 dequantization() const noexcept;
+
+	NODISCARD const lsd::Vector<PackedVertex>& vertices() const noexcept { return m_vertices; }
+	// the indices of every level of detail, only one of the two is filled depending on the index type
 	NODISCARD const lsd::Vector<uint32>& indices() const noexcept { return m_indices; }
+	NODISCARD const lsd::Vector<uint16>& shortIndices() const noexcept { return m_shortIndices; }
+	NODISCARD VkIndexType indexType() const noexcept { return m_indexType; }
+	NODISCARD uint32 indexCount() const noexcept {
+		return static_cast<uint32>((m_indexType == VK_INDEX_TYPE_UINT16) ? m_shortIndices.size() : m_indices.size());
+	}
+	NODISCARD const void* indexData() const noexcept {
+		return (m_indexType == VK_INDEX_TYPE_UINT16) ? static_cast<const void*>(m_shortIndices.data()) : static_cast<const void*>(m_indices.data());
+	}
+	// ordered from the original mesh to the coarsest level, the errors are ascending
+	NODISCARD const lsd::Vector<Lod>& lods() const noexcept { return m_lods; }
+	// the clusters of all levels of detail, with index ranges relative to the indices of the mesh
+	NODISCARD const lsd::Vector<Meshlet>& meshlets() const noexcept { return m_meshlets; }
+	NODISCARD const BoundingVolume& bounds() const noexcept { return m_bounds; }
 
 private:
-	lsd::Vector<Vertex> m_vertices;
+	BoundingVolume m_bounds;
+
+	lsd::Vector<PackedVertex> m_vertices;
+	VkIndexType m_indexType = VK_INDEX_TYPE_UINT32;
+	lsd::Vector<uint16> m_shortIndices;
 	lsd::Vector<uint32> m_indices;
+	lsd::Vector<Lod> m_lods;
+	lsd::Vector<Meshlet> m_meshlets;
 };
 
 } // namespace lyra
@@ -17,6 +17,7 @@
 #include <Graphics/VulkanRenderSystem.h>
 
 #include <LSD/Array.h>
+#include <LSD/Vector.h>
 #include <LSD/UniquePointer.h>
 #include <LSD/UnorderedSparseMap.h>
 
@@ -43,10 +44,20 @@ uint32 currentFrameIndex();
 float32 framesPerSecond();
 float32 deltaTime();
 
+struct PipelineVariant {
+	vulkan::GraphicsPipeline::Builder pipelineBuilder;
+	vulkan::GraphicsProgram::Builder programBuilder;
+};
+
+// returns immediately, pipelines seen for the first time are compiled in the background
 vulkan::GraphicsPipeline& graphicsPipeline(
 	const vulkan::GraphicsPipeline::Builder& pipelineBuilder = { },
 	const vulkan::GraphicsProgram::Builder& programBuilder = { }
 );
+// starts compiling every variant in the manifest, meant to be called before a loading screen
+void prewarmGraphicsPipelines(const lsd::Vector<PipelineVariant>& manifest);
+// number of pipelines still being compiled, f.e. to display the progress of the loading screen
+uint32 compilingGraphicsPipelines();
 
 void setScene(etcs::Entity& sceneRoot);
 etcs::Entity& scene();
@@ -31,7 +31,10 @@ public:
 	};
 
 	Texture() = default;
-	Texture(const resource::TextureFile& imageData, vulkan::Image::Format format = vulkan::Image::Format::r8g8b8a8SRGB);
+	// the default format is picked from the format of the texture data and its type
+	Texture(const resource::TextureFile& imageData, vulkan::Image::Format format = vulkan::Image::Format::max);
+	// the material table may not share the slots of this texture with a new texture at the same address
+	~Texture();
 
 	NODISCARD constexpr VkDescriptorImageInfo getDescriptorImageInfo(vulkan::Image::Layout layout = vulkan::Image::Layout::shaderReadOnly) const noexcept {
 		return {
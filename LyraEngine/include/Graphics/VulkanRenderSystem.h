@@ -14,6 +14,8 @@
 #include <Common/Common.h>
 #include <Common/RAIIContainers.h>
 #include <Common/Config.h>
+#include <Common/Hash.h>
+#include <Common/ThreadPool.h>
 
 #include <Graphics/ImGuiRenderer.h>
 
@@ -42,6 +44,8 @@
 #include <LSD/Dynarray.h>
 
 #include <variant>
+#include <bit>
+#include <utility>
 
 namespace lyra {
 
@@ -384,6 +388,22 @@ public:
 		d16UNormS8UInt,
 		d24UNormS8UInt,
 		d32SFloatS8UInt,
+		bc1RGBUNormBlock,
+		bc1RGBSRGBBlock,
+		bc1RGBAUNormBlock,
+		bc1RGBASRGBBlock,
+		bc2UNormBlock,
+		bc2SRGBBlock,
+		bc3UNormBlock,
+		bc3SRGBBlock,
+		bc4UNormBlock,
+		bc4SNormBlock,
+		bc5UNormBlock,
+		bc5SNormBlock,
+		bc6hUFloatBlock,
+		bc6hSFloatBlock,
+		bc7UNormBlock,
+		bc7SRGBBlock,
 		max = 0x7FFFFFFF
 	};
 
@@ -479,6 +499,7 @@ public:
 	void transitionLayout(Layout oldLayout, Layout newLayout, const VkImageSubresourceRange& subresourceRange) const;
 
 	void copyFromBuffer(const vulkan::GPUBuffer& stagingBuffer, const VkExtent3D& extent, uint32 layerCount = 1);
+	void copyFromBuffer(const vulkan::GPUBuffer& stagingBuffer, const lsd::Vector<VkBufferImageCopy>& regions);
 
 	vk::Image image;
 
@@ -494,6 +515,7 @@ public:
 	class CommandPool {
 	public:
 		CommandPool();
+		CommandPool(uint32 queueFamilyIndex);
 
 		void reset();
 
@@ -529,6 +551,8 @@ public:
 		 */
 
 		void begin(const Usage& usage = Usage::renderingDefault) const;
+		// begin a secondary command buffer, which inherits the render pass state from the info
+		void begin(const Usage& usage, const VkCommandBufferInheritanceInfo& inheritanceInfo) const;
 		void end() const {
 			VULKAN_ASSERT(vkEndCommandBuffer(commandBuffer), "stop recording command buffer");
 		}
@@ -706,6 +730,22 @@ public:
 		void dispatchIndirect(const vk::Buffer& buffer, VkDeviceSize offset) const {
 			vkCmdDispatchIndirect(commandBuffer, buffer, offset);
 		}
+		// dispatches enough work groups to cover the invocation counts with the local sizes of the shader
+		void dispatchInvocations(
+			uint32 countX, 
+			uint32 localSizeX, 
+			uint32 countY = 1, 
+			uint32 localSizeY = 1, 
+			uint32 countZ = 1, 
+			uint32 localSizeZ = 1
+		) const {
+			vkCmdDispatch(
+				commandBuffer, 
+				(countX + localSizeX - 1) / localSizeX, 
+				(countY + localSizeY - 1) / localSizeY, 
+				(countZ + localSizeZ - 1) / localSizeZ
+			);
+		}
 		void draw(uint32 vertexCount, uint32 instanceCount, uint32 firstVertex, uint32 firstInstance) const {
 			vkCmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
 		}
@@ -715,6 +755,16 @@ public:
 		void drawIndexedIndirect(const vk::Buffer& buffer, VkDeviceSize offset, uint32 drawCount, uint32 stride) const {
 			vkCmdDrawIndexedIndirect(commandBuffer, buffer, offset, drawCount, stride);
 		}
+		void drawIndexedIndirectCount(
+			const vk::Buffer& buffer, 
+			VkDeviceSize offset, 
+			const vk::Buffer& countBuffer, 
+			VkDeviceSize countOffset, 
+			uint32 maxDrawCount, 
+			uint32 stride
+		) const {
+			vkCmdDrawIndexedIndirectCount(commandBuffer, buffer, offset, countBuffer, countOffset, maxDrawCount, stride);
+		}
 		void drawIndirect(const vk::Buffer& buffer, VkDeviceSize offset, uint32 drawCount, uint32 stride) const {
 			vkCmdDrawIndirect(commandBuffer, buffer, offset, drawCount, stride);
 		}
@@ -921,6 +971,229 @@ public:
 	uint32 currentFrame = 0;
 };
 
+/**
+ * @brief batches uploads of CPU data into GPU only buffers and images
+ * @brief the data is copied into a persistently mapped staging buffer used as a ring, the copy commands are recorded into one command buffer
+ * @brief recorded copies are submitted together once per frame by flush(), completion is tracked with one fence per submitted batch
+ * @brief if the device has a dedicated transfer queue family, the copies run on it and the resources are handed over to the graphics queue with ownership transfers
+ */
+class UploadQueue {
+public:
+	static constexpr VkDeviceSize defaultStagingSize = 32 * 1024 * 1024;
+	static constexpr VkDeviceSize alignment = 16; // satisfies the offset requirements of all texel block sizes
+
+	UploadQueue(VkDeviceSize stagingSize = defaultStagingSize);
+	~UploadQueue();
+
+	// copies size bytes from src into the buffer, src may be freed as soon as this returns
+	// only uploads of the entire buffer are done on the transfer queue, partial updates keep the rest of the buffer on the graphics queue
+	void copy(const GPUBuffer& dstBuffer, const void* src, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+	// buffer offsets of the regions are relative to src, the subresource range is transitioned from undefined to finalLayout
+	void copy(
+		const Image& dstImage,
+		const void* src,
+		VkDeviceSize size,
+		const lsd::Vector<VkBufferImageCopy>& regions,
+		const VkImageSubresourceRange& subresourceRange,
+		Image::Layout finalLayout = Image::Layout::shaderReadOnly
+	);
+
+	// graphics queue command buffer of the current batch, for recording additional commands after the copies, f.e. generating mipmaps
+	const CommandQueue::CommandBuffer& commandBuffer();
+
+	// submits the current batch and retires all batches the GPU has finished
+	void flush();
+	// submits the current batch and waits for all batches to finish
+	void wait();
+
+private:
+	struct Batch {
+		Batch(const CommandQueue::CommandPool& commandPool, const CommandQueue::CommandPool& transferCommandPool);
+
+		CommandQueue::CommandBuffer commandBuffer;
+		CommandQueue::CommandBuffer transferCommandBuffer; // only recorded into if the transfer queue is dedicated
+		vk::Semaphore transferFinished;
+		vk::Fence fence;
+
+		VkDeviceSize stagingEnd = 0;
+		lsd::Vector<GPUBuffer> overflowBuffers; // temporary staging buffers for uploads larger than the ring
+	};
+
+	// returns the offset into the staging buffer, or the maximum value if the size exceeds the staging buffer
+	VkDeviceSize allocate(VkDeviceSize size);
+	// copies the data into staging memory owned by the recording batch and returns the buffer containing it
+	const vk::Buffer& stage(const void* src, VkDeviceSize size, VkDeviceSize& offset);
+	Batch& record();
+	void retire(bool wait);
+
+public:
+	uint32 graphicsFamilyIndex;
+	uint32 transferFamilyIndex;
+	bool dedicatedTransfer;
+
+	CommandQueue::CommandPool commandPool;
+	CommandQueue::CommandPool transferCommandPool;
+
+	GPUBuffer stagingBuffer;
+	char* stagingData = nullptr;
+
+	// offsets into the ring only ever grow, the position in the staging buffer is the offset modulo its size
+	VkDeviceSize stagingHead = 0;
+	VkDeviceSize stagingTail = 0;
+
+	lsd::Vector<lsd::UniquePointer<Batch>> batches;
+
+	Batch* recording = nullptr;
+	lsd::Vector<Batch*> submitted; // in order of submission
+	lsd::Vector<Batch*> retired;
+};
+
+/**
+ * @brief records commands on worker threads into secondary command buffers, which are then executed by the primary command buffer
+ * @brief command pools may only be used by one thread at a time, so every thread owns a command pool for every frame in flight
+ * @brief the pools of a frame are reset as a whole once the frame begins again, instead of freeing or resetting every command buffer on its own
+ */
+class CommandRecorder {
+public:
+	// records the commands for the indices in [first, last) into the command buffer
+	using record_func = std::function<void(const CommandQueue::CommandBuffer&, size_type, size_type)>;
+
+	CommandRecorder(uint32 threadCount = ThreadPool::defaultThreadCount());
+
+	// resets the command pools of the frame, the GPU has to be finished executing the frame
+	void reset(uint32 frame);
+
+	// splits [0, count) into chunks of chunkSize and records every chunk into its own secondary command buffer on the workers
+	// the command buffers continue the render pass in the inheritance info and are executed in the order of their chunks
+	void record(const VkCommandBufferInheritanceInfo& inheritanceInfo, size_type count, size_type chunkSize, const record_func& func);
+	// executes all command buffers recorded since the last call in the primary command buffer
+	void execute(const CommandQueue::CommandBuffer& commandBuffer);
+
+private:
+	struct ThreadCommands {
+		CommandQueue::CommandPool commandPool;
+		lsd::Vector<CommandQueue::CommandBuffer> commandBuffers; // reused after the pool was reset
+		uint32 used = 0;
+	};
+
+public:
+	ThreadPool workers;
+
+	// one per frame in flight for the recording thread and every worker, indexed by the slot of the parallelFor() call * config::maxFramesInFlight + frame
+	lsd::Vector<ThreadCommands> threadCommands;
+	lsd::Vector<VkCommandBuffer> recorded;
+
+	uint32 currentFrame = 0;
+};
+
+/**
+ * @brief vertices and indices of all rendered meshes in two shared buffers, so every draw uses the same bindings and can be issued indirectly
+ * @brief 16 and 32 bit indices share the index buffer, which is bound with the index type of the meshes drawn, so the first index of a range counts in its own index type
+ * @brief meshes are uploaded the first time they are added, the space of destroyed meshes is reused once the frames in flight which could still read it have retired
+ */
+class GeometryBuffer {
+public:
+	// location of a mesh in the shared buffers, in the layout of an indexed draw
+	struct Range {
+		uint32 firstIndex;
+		uint32 indexCount;
+		int32 vertexOffset;
+		VkIndexType indexType;
+	};
+
+	// a range of free space as its offset and size, in vertices or in bytes of indices
+	using FreeRange = std::pair<uint32, uint32>;
+
+	// the space released while recording a frame, it may still be read until the frame has retired
+	struct Released {
+		lsd::Vector<FreeRange> vertices;
+		lsd::Vector<FreeRange> indices;
+	};
+
+	GeometryBuffer(uint32 vertexCapacity = config::geometryVertexCapacity, uint32 indexCapacity = config::geometryIndexCapacity);
+
+	// uploads the mesh if it was not added yet, into the first free range it fits into before appending it
+	Range add(const Mesh& mesh);
+	// forgets the range of a destroyed mesh, so a new mesh at the same address is uploaded again
+	// its space is released with the current frame and only reused once the frame has retired
+	void remove(const Mesh& mesh);
+	// makes the space released during the previous use of the frame available again, the GPU has to be finished executing the frame
+	void retire(uint32 frame);
+
+	void bind(const CommandQueue::CommandBuffer& commandBuffer, VkIndexType indexType) const;
+
+private:
+	// waits for the device to be idle, since the old buffers may still be in use, so this should only happen while loading
+	void grow(uint32 vertexCapacity, uint32 indexCapacity);
+
+	// takes size units from the first free range they fit into at the alignment, the rest of the range stays free
+	static bool takeFreeRange(lsd::Vector<FreeRange>& freeRanges, uint32 size, uint32 alignment, uint32& offset);
+	// keeps the free ranges sorted and merges adjacent ones
+	static void releaseRange(lsd::Vector<FreeRange>& freeRanges, uint32 offset, uint32 size);
+
+public:
+	GPUBuffer vertexBuffer;
+	GPUBuffer indexBuffer;
+
+	uint32 vertexCapacity;
+	uint32 indexCapacity; // in bytes, since the index sizes are mixed
+	uint32 vertexCount = 0; // end of the used vertices, the free ranges lie before it
+	uint32 indexSize = 0; // end of the used bytes of indices
+
+	lsd::UnorderedSparseMap<const Mesh*, Range> ranges;
+
+	lsd::Vector<FreeRange> freeVertices;
+	lsd::Vector<FreeRange> freeIndices;
+	lsd::Array<Released, config::maxFramesInFlight> released;
+};
+
+/**
+ * @brief per frame buffers for indirect rendering, which are filled by the CPU every frame
+ * @brief the instance data is read by the vertex shader with gl_InstanceIndex, the draw commands are consumed by the indirect draws
+ * @brief the descriptor set of the instance data is bound to the set after the material set in the engine standard layout
+ */
+class InstanceBuffer {
+public:
+	static constexpr uint32 descriptorSetIndex = 1;
+
+	struct InstanceData {
+		glm::mat4 transform;
+		uint32 material; // index of the material in the material table
+		uint32 padding[3];
+	};
+
+	struct Frame {
+		GPUBuffer instanceBuffer;
+		GPUBuffer drawBuffer;
+
+		InstanceData* instances = nullptr;
+		VkDrawIndexedIndirectCommand* draws = nullptr;
+
+		vk::DescriptorSet descriptorSet; // allocated from the transient pools, only valid during the frame it was allocated in
+
+		uint32 capacity = 0;
+	};
+
+	InstanceBuffer(uint32 capacity = config::instanceCapacity);
+	~InstanceBuffer();
+
+	// makes sure the buffers of the frame fit count instances, every draw has at least one instance, so the draws always fit as well
+	// also allocates the descriptor set of the frame from the transient pools, so it has to be called every frame after they were reset
+	// the GPU has to be finished executing the frame
+	void reserve(uint32 frame, uint32 count);
+	// makes the first count instances and at most count draws visible to the GPU
+	void flush(uint32 frame, uint32 count) const;
+
+	void bind(uint32 frame, const CommandQueue::CommandBuffer& commandBuffer, const GraphicsProgram& program) const;
+
+private:
+	void create(Frame& frame, uint32 capacity);
+	void destroy(Frame& frame);
+
+public:
+	lsd::Array<Frame, config::maxFramesInFlight> frames;
+};
+
 class Pipeline {
 public:
 	enum class BindPoint {
@@ -950,7 +1223,7 @@ public:
 	};
 
 	Pipeline() = default;
-	Pipeline(const RenderTarget* const renderTarget, const lsd::String& hash) : renderTarget(renderTarget), hash(hash) { }
+	Pipeline(const RenderTarget* const renderTarget, uint64 hash) : renderTarget(renderTarget), hash(hash) { }
 
 	virtual void bind() const = 0;
 
@@ -958,7 +1231,7 @@ public:
 
 	const RenderTarget* renderTarget;
 
-	lsd::String hash;
+	uint64 hash;
 };
 
 class Swapchain {
@@ -1075,9 +1348,13 @@ public:
 
 	void createFramebuffers(const glm::u32vec2& size = { std::numeric_limits<uint32>::max(), std::numeric_limits<uint32>::max() });
 
-	void begin() const;
+	// commands of the render pass have to be recorded into secondary command buffers if contents is VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+	void begin(VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE) const;
 	void end() const;
 
+	// inheritance info for secondary command buffers continuing the render pass on the current framebuffer
+	NODISCARD VkCommandBufferInheritanceInfo inheritanceInfo(uint32 subpass = 0) const;
+
 	lsd::Vector<Attachment> attachments;
 	
 	vk::RenderPass renderPass;
@@ -1114,10 +1391,11 @@ public:
 	
 	DescriptorSets() = default;
 	DescriptorSets(
-		const GraphicsProgram& graphicsProgram, 
+		const Program& program, 
 		uint32 layoutIndex,
-		bool variableCount = false
-	) : variableCount(variableCount), layoutIndex(layoutIndex), graphicsProgram(&graphicsProgram) { }
+		bool variableCount = false,
+		Pipeline::BindPoint bindPoint = Pipeline::BindPoint::graphics
+	) : variableCount(variableCount), layoutIndex(layoutIndex), bindPoint(bindPoint), program(&program) { }
 	~DescriptorSets();
 
 	constexpr void addWrites(const lsd::Vector<ImageWrite>& newWrites) noexcept {
@@ -1136,8 +1414,12 @@ public:
 	void update(uint32 index = std::numeric_limits<uint32>::max());
 
 	void addDescriptorSets(uint32 count);
+	// allocates descriptor sets until the set at index exists
+	void allocate(uint32 index);
 
 	void bind(uint32 index);
+	// does not allocate, so the set has to exist already, f.e. when binding from a worker thread
+	void bind(uint32 index, const CommandQueue::CommandBuffer& commandBuffer) const;
 
 	lsd::Vector<vk::DescriptorSet> descriptorSets;
 
@@ -1150,37 +1432,177 @@ public:
 	bool dirty = false;
 
 	uint32 layoutIndex;
+	Pipeline::BindPoint bindPoint;
 
-	const GraphicsProgram* graphicsProgram;
+	const Program* program;
 };
 
+/**
+ * @brief allocator of long lived descriptor sets, in which every pool only contains sets of a single size class
+ * @brief a size class contains all set layouts with the same number of descriptors of each type after rounding them up to powers of two
+ * @brief since every set of a class fits into every pool of the class, freed sets can always be reused and full pools never have to be probed
+ */
 class DescriptorPools {
 public:
-	struct Size {
-		DescriptorSets::Type type;
-		uint32 multiplier = 1;
-	};
-
 	enum class Flags {
 		freeDescriptorSet = 0x00000001,
 		updateAfterBind = 0x00000002,
 		hostOnly = 0x00000004
 	};
 
-	DescriptorPools() = default;
-	DescriptorPools(const lsd::Vector<Size>& sizes, Flags flags = Flags::freeDescriptorSet);
+	// the descriptors a set of a layout consists of
+	struct SetSize {
+		lsd::Vector<VkDescriptorPoolSize> sizes;
+		bool updateAfterBind = false;
+	};
 
-	void reset();
-	vk::DescriptorSet allocate(const GraphicsProgram& program, uint32 layoutIndex, bool variableCount);
+	struct SizeClass {
+		lsd::Vector<VkDescriptorPoolSize> sizes; // descriptors of a single set
+		Flags flags;
+		uint32 setsPerPool;
+
+		lsd::Vector<vk::DescriptorPool> pools;
+		lsd::Vector<uint32> setCounts; // number of sets allocated from each pool
+		lsd::Vector<uint32> availablePools; // pools with space for at least one more set
+	};
+
+	struct PoolLocation {
+		uint64 sizeClass;
+		uint32 pool;
+	};
+
+	NODISCARD static SetSize setSize(const VkDescriptorSetLayoutCreateInfo& createInfo);
+
+	vk::DescriptorSet allocate(const Program& program, uint32 layoutIndex, bool variableCount);
+	// returns the set to the pool it was allocated from
+	void free(const vk::DescriptorSet& descriptorSet);
+
+	lsd::UnorderedSparseMap<uint64, SizeClass> sizeClasses;
+	lsd::UnorderedSparseMap<VkDescriptorPool, PoolLocation> poolLocations;
+};
 
-	lsd::Vector<vk::DescriptorPool> descriptorPools;
+/**
+ * @brief allocator of descriptor sets which are only used during a single frame
+ * @brief the sets are allocated linearly from the pools of their frame, which are reset as a whole once the fence of the frame has signaled
+ * @brief the instance buffer allocates the set of its frame from them every frame, since the set points to a buffer which is recreated when it grows
+ */
+class TransientDescriptorPools {
+public:
+	struct Size {
+		DescriptorSets::Type type;
+		uint32 multiplier = 1; // descriptors of the type per set in the pool
+	};
+
+	struct Frame {
+		lsd::Vector<vk::DescriptorPool> pools;
+		uint32 poolIndex = 0;
+	};
 
-	uint32 allocationIndex = 0;
+	TransientDescriptorPools(const lsd::Vector<Size>& sizes);
+
+	// frees all sets of the frame at once, the GPU has to be finished executing the frame
+	void reset(uint32 frame);
+	// the set is only valid until the frame is reset again
+	vk::DescriptorSet allocate(uint32 frame, const Program& program, uint32 layoutIndex, bool variableCount = false);
+
+	lsd::Array<Frame, config::maxFramesInFlight> frames;
 
 	VkDescriptorPoolCreateInfo createInfo;
 	lsd::Vector<VkDescriptorPoolSize> sizes;
 };
 
+/**
+ * @brief the parameters of all materials in one storage buffer and all of their textures in one bindless texture array
+ * @brief both are in the material set of the engine standard layout, which is only bound once per pipeline, the instances select their material by its index
+ * @brief changing a material only changes its data, which is copied into the buffer of a frame before the frame is drawn
+ */
+class MaterialTable {
+public:
+	static constexpr uint32 descriptorSetIndex = 0;
+	static constexpr uint32 materialBinding = 0;
+	static constexpr uint32 textureBinding = 1;
+
+	// the texture members are indices into the texture array
+	struct MaterialData {
+		alignas(16) Color albedoColor;
+		alignas(16) Color emissionColor;
+		alignas(16) Color specularColor;
+		alignas(16) Color occlusionColor;
+		float32 metallic;
+		float32 roughness;
+		uint32 albedoTexture; // first of albedoTextureCount consecutive textures
+		uint32 albedoTextureCount;
+		uint32 normalMapTexture;
+		uint32 displacementMapTexture;
+		uint32 metallicTexture;
+		uint32 specularTexture;
+		uint32 emissionTexture;
+		uint32 occlusionMapTexture;
+		uint32 padding[2];
+	};
+
+	struct Frame {
+		GPUBuffer materialBuffer;
+		MaterialData* materials = nullptr;
+
+		vk::DescriptorSet descriptorSet;
+
+		uint32 capacity = 0;
+		uint64 version = 0; // version of the materials the buffer was last written with
+	};
+
+	// consecutive slots of the texture array holding the same textures in the same order, shared by all materials using them
+	struct TextureRange {
+		lsd::Vector<const Texture*> textures; // empty once one of the textures was destroyed, so the range is not shared anymore
+		uint32 count;
+		uint32 references = 0;
+	};
+
+	MaterialTable(uint32 capacity = config::materialCapacity);
+	~MaterialTable();
+
+	// every call adds a reference to the returned range, which has to be released again with releaseTextures()
+	uint32 addTexture(const Texture& texture);
+	// the textures are placed next to each other, so that a shader can index them relative to the first one
+	uint32 addTextures(const lsd::Vector<const Texture*>& newTextures);
+	// the slots of the range are reused once all references are released
+	void releaseTextures(uint32 first);
+	// stops sharing the ranges containing the texture, since a new texture may be created at the same address
+	void removeTexture(const Texture& texture);
+
+	// returns the index of the new material, the indices of removed materials are reused
+	uint32 add(const MaterialData& data);
+	void set(uint32 index, const MaterialData& data);
+	void remove(uint32 index);
+
+	// copies the current materials into the buffer of the frame if they changed, the GPU has to be finished executing the frame
+	void update(uint32 frame);
+
+	void bind(uint32 frame, const CommandQueue::CommandBuffer& commandBuffer, const GraphicsProgram& program) const;
+
+private:
+	void create(Frame& frame, uint32 capacity);
+	void destroy(Frame& frame);
+	// writes the textures in the range to the sets of all frames, the texture binding may be updated while the sets are in use
+	void writeTextures(uint32 first, uint32 count);
+	// first fit in the released slots, the array only grows if none of them are large enough
+	uint32 allocateTextures(uint32 count);
+
+public:
+	lsd::Array<Frame, config::maxFramesInFlight> frames;
+
+	lsd::Vector<MaterialData> materials;
+	lsd::Vector<uint32> freeMaterials;
+
+	lsd::Vector<VkDescriptorImageInfo> textures;
+	lsd::UnorderedSparseMap<uint32, TextureRange> textureRanges; // keyed by their first slot
+	lsd::UnorderedSparseMap<const Texture*, lsd::Vector<uint32>> textureUses; // first slots of the shared ranges containing a texture
+	lsd::Vector<std::pair<uint32, uint32>> freeTextures; // first slot and count of the released slots, sorted and merged
+
+	uint32 textureCapacity;
+	uint64 version = 0; // incremented whenever a material is added or changed
+};
+
 class Shader {
 public:
 	static constexpr const char* const entry = "main"; // entry will always be main
@@ -1226,7 +1648,8 @@ public:
 	Type type;
 };
 
-class GraphicsProgram {
+// descriptor set and push constant layout shared by the graphics and compute programs
+class Program {
 public:
 	class Builder {
 	public:
@@ -1247,9 +1670,9 @@ public:
 			// array size
 			uint32 arraySize = 1;
 			// flags
-			Flags flags;
-			// immutable samplers
-			const lsd::Vector<VkSampler>& immutableSamplers = { };
+			Flags flags = static_cast<Flags>(0);
+			// immutable samplers, either null or an array with arraySize samplers
+			const VkSampler* immutableSamplers = nullptr;
 		};
 		
 		struct PushConstant {
@@ -1260,12 +1683,9 @@ public:
 		};
 
 		constexpr void addBinding(const Binding& binding) {
-			using namespace lsd::enum_operators;
-
-			if (m_bindings.size() <= binding.set) {
+			while (m_bindings.size() <= binding.set) {
 				m_bindings.pushBack({});
 				m_bindingFlags.pushBack({});
-				m_bindingFlagsCreateInfo.pushBack({});
 			}
 
 			// add the new binding
@@ -1274,30 +1694,21 @@ public:
 				static_cast<VkDescriptorType>(binding.type),
 				binding.arraySize,
 				static_cast<VkShaderStageFlags>(binding.shaderType),
-				binding.immutableSamplers.data()
+				binding.immutableSamplers
 				});
 
+			// the flags create info is only assembled when the layout is created, since the builder may be copied
 			m_bindingFlags[binding.set].pushBack(static_cast<VkDescriptorBindingFlags>(binding.flags));
-			
-			if ((binding.flags & Flags::variableCount) == Flags::variableCount) {
-				if (m_bindingFlagsCreateInfo.size() <= binding.set) m_bindingFlagsCreateInfo.resize(binding.set);
-
-				m_bindingFlagsCreateInfo[binding.set] = {
-					VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
-					nullptr,
-					static_cast<uint32>(m_bindingFlags[binding.set].size()),
-					m_bindingFlags[binding.set].data()
-				}; // not very efficient, a lot of reassigning, though all types here are trivially copiable, still a @todo
-			}
 
-			// compute the hash from the binding
-			m_bindingHash.append(
-				lsd::toString(binding.type) + 
-				lsd::toString(binding.shaderType) + 
-				lsd::toString(binding.set) + 
-				lsd::toString(binding.arraySize) + 
-				lsd::toString(binding.flags) + 
-				lsd::toString(binding.immutableSamplers.size())
+			// mix the binding into the hash
+			m_bindingHash = hashCombine(
+				m_bindingHash,
+				binding.type,
+				binding.shaderType,
+				binding.set,
+				binding.arraySize,
+				binding.flags,
+				reinterpret_cast<uintptr>(binding.immutableSamplers)
 			);
 		}
 		constexpr void addBindings(const lsd::Vector<Binding>& bindings) {
@@ -1307,16 +1718,46 @@ public:
 		constexpr void addPushConstant(const PushConstant& pushConstant) {
 			m_pushConstants.pushBack({
 				static_cast<VkShaderStageFlags>(pushConstant.shaderType),
-				m_pushConstants.back().size + m_pushConstants.back().offset,
+				m_pushConstants.empty() ? 0 : m_pushConstants.back().size + m_pushConstants.back().offset,
 				pushConstant.size
 			});
 
-			m_pushConstantHash.append(lsd::toString(pushConstant.shaderType) + lsd::toString(pushConstant.size));
+			m_pushConstantHash = hashCombine(m_pushConstantHash, pushConstant.shaderType, pushConstant.size);
 		}
 		constexpr void addPushConstants(const lsd::Vector<PushConstant>& pushConstants) {
 			for (const auto& pushConstant : pushConstants) addPushConstant(pushConstant);
 		}
 
+	protected:
+		NODISCARD constexpr uint64 layoutHash() const noexcept {
+			return hashCombine(m_bindingHash, m_pushConstantHash);
+		}
+		NODISCARD bool equalLayout(const Builder& other) const noexcept;
+
+		lsd::Dynarray<lsd::Vector<VkDescriptorSetLayoutBinding>, config::maxShaderSets> m_bindings;
+		lsd::Dynarray<lsd::Vector<VkDescriptorBindingFlags>, config::maxShaderSets> m_bindingFlags;
+		lsd::Vector<VkPushConstantRange> m_pushConstants;
+
+		uint64 m_bindingHash = fnvOffsetBasis;
+		uint64 m_pushConstantHash = fnvOffsetBasis;
+
+		friend class Program;
+	};
+
+	Program() = default;
+	// creates the descriptor set layouts and the pipeline layout described by the builder
+	Program(const Builder& builder);
+
+	lsd::Dynarray<vk::DescriptorSetLayout, config::maxShaderSets> descriptorSetLayouts;
+	lsd::Dynarray<DescriptorPools::SetSize, config::maxShaderSets> descriptorSetSizes;
+	lsd::Dynarray<uint32, config::maxShaderSets> dynamicDescriptorCounts;
+	vk::PipelineLayout pipelineLayout;
+};
+
+class GraphicsProgram : public Program {
+public:
+	class Builder : public Program::Builder {
+	public:
 		constexpr void setVertexShader(const Shader& shader) {
 			m_vertexShader = &shader;
 		}
@@ -1324,19 +1765,13 @@ public:
 			m_fragmentShader = &shader;
 		}
 
-		lsd::String hash() const noexcept;
+		// the hash is only used to find candidates, builders with the same hash still have to be compared
+		NODISCARD uint64 hash() const noexcept;
+		NODISCARD bool operator==(const Builder& other) const noexcept;
 
 	private:
-		lsd::Dynarray<lsd::Vector<VkDescriptorSetLayoutBinding>, config::maxShaderSets> m_bindings;
-		lsd::Dynarray<lsd::Vector<VkDescriptorBindingFlags>, config::maxShaderSets> m_bindingFlags;
-		lsd::Dynarray<VkDescriptorSetLayoutBindingFlagsCreateInfo, config::maxShaderSets> m_bindingFlagsCreateInfo;
-		lsd::Vector<VkPushConstantRange> m_pushConstants;
-
-		const Shader* m_vertexShader;
-		const Shader* m_fragmentShader;
-
-		lsd::String m_bindingHash;
-		lsd::String m_pushConstantHash;
+		const Shader* m_vertexShader = nullptr;
+		const Shader* m_fragmentShader = nullptr;
 
 		friend class GraphicsProgram;
 	};
@@ -1347,14 +1782,11 @@ public:
 	// Constructs a shader program with a custom layout
 	GraphicsProgram(const Builder& builder);
 
-	lsd::Dynarray<vk::DescriptorSetLayout, config::maxShaderSets> descriptorSetLayouts;
-	lsd::Dynarray<uint32, config::maxShaderSets> dynamicDescriptorCounts;
-	vk::PipelineLayout pipelineLayout;
-
 	const Shader* vertexShader;
 	const Shader* fragmentShader;
 
-	lsd::String hash;
+	Builder builder;
+	uint64 hash;
 };
 
 class GraphicsPipeline : public Pipeline {
@@ -1410,6 +1842,8 @@ public:
 		struct DepthStencil {
 			bool write;
 			Image::Compare compare;
+
+			constexpr bool operator==(const DepthStencil&) const noexcept = default;
 		};
 
 		constexpr Builder() noexcept : 
@@ -1492,9 +1926,65 @@ public:
 			m_graphicsProgram = &graphicsProgram;
 		}
 
-		NODISCARD lsd::String hash() const noexcept;
+		// the hash is only used to find candidates, builders with the same hash still have to be compared
+		NODISCARD uint64 hash() const noexcept;
+		NODISCARD bool operator==(const Builder& other) const noexcept;
 
 	private:
+		// hashes every property except for the render target and the program, since their defaults are only known at runtime
+		NODISCARD constexpr uint64 structuralHash() const noexcept {
+			auto hash = hashCombine(
+				fnvOffsetBasis,
+				m_viewport.index(),
+				m_scissor.index(),
+				m_topology,
+				m_renderMode,
+				m_culling,
+				m_polyFrontFace,
+				m_sampleCount,
+				m_sampleShading.index(),
+				m_depthStencil.index(),
+				m_blendAttachments.size()
+			);
+
+			if (auto viewport = std::get_if<VkViewport>(&m_viewport)) hash = hashCombine(
+				hash,
+				std::bit_cast<uint32>(viewport->x),
+				std::bit_cast<uint32>(viewport->y),
+				std::bit_cast<uint32>(viewport->width),
+				std::bit_cast<uint32>(viewport->height),
+				std::bit_cast<uint32>(viewport->minDepth),
+				std::bit_cast<uint32>(viewport->maxDepth)
+			);
+			if (auto scissor = std::get_if<VkRect2D>(&m_scissor)) hash = hashCombine(
+				hash,
+				scissor->offset.x,
+				scissor->offset.y,
+				scissor->extent.width,
+				scissor->extent.height
+			);
+
+			if (auto strength = std::get_if<float32>(&m_sampleShading)) hash = hashCombine(hash, std::bit_cast<uint32>(*strength));
+			else hash = hashCombine(hash, std::get<bool>(m_sampleShading));
+
+			if (auto depthStencil = std::get_if<DepthStencil>(&m_depthStencil)) hash = hashCombine(hash, depthStencil->write, depthStencil->compare);
+			else hash = hashCombine(hash, std::get<bool>(m_depthStencil));
+
+			for (const auto& attachment : m_blendAttachments) hash = hashCombine(
+				hash,
+				attachment.blendEnable,
+				attachment.srcColorBlendFactor,
+				attachment.dstColorBlendFactor,
+				attachment.colorBlendOp,
+				attachment.srcAlphaBlendFactor,
+				attachment.dstAlphaBlendFactor,
+				attachment.alphaBlendOp,
+				attachment.colorWriteMask
+			);
+
+			return hash;
+		}
+
 		std::variant<bool, VkViewport> m_viewport;
 		std::variant<bool, VkRect2D> m_scissor;
 		Topology m_topology;
@@ -1516,23 +2006,76 @@ public:
 	GraphicsPipeline();
 	// create a graphics pipeline with custom properties
 	GraphicsPipeline(const Builder& builder);
+	// create a graphics pipeline with custom properties, which is compiled by the workers in the background
+	// until the compilation has finished, the pipeline is drawn with the fallback if it is compatible, otherwise drawing is skipped
+	GraphicsPipeline(const Builder& builder, ThreadPool& workers, const GraphicsPipeline* fallback = nullptr);
+	~GraphicsPipeline();
 
 	void bind() const;
+	// binds the pipeline and the current dynamic state without touching the command queue, so it may be called from worker threads
+	void bind(const CommandQueue::CommandBuffer& commandBuffer) const;
+
+	NODISCARD bool compiled() const noexcept {
+		return m_compiled.load(std::memory_order_acquire);
+	}
+	NODISCARD bool drawable() const noexcept {
+		return compiled() || fallback;
+	}
+	// blocks until the background compilation has finished
+	void wait() const;
 
 	std::variant<bool, VkViewport> dynamicViewport;
 	std::variant<bool, VkRect2D> dynamicScissor;
 
 	const GraphicsProgram* program;
+	const GraphicsPipeline* fallback = nullptr;
+
+	Builder builder;
+
+private:
+	void compile();
+
+	std::future<void> m_compilation;
+	std::atomic<bool> m_compiled = false;
 };
 
-class ComputeProgram {
+class ComputeProgram : public Program {
 public:
+	class Builder : public Program::Builder {
+	public:
+		constexpr void setComputeShader(const Shader& shader) {
+			m_computeShader = &shader;
+		}
 
+		NODISCARD uint64 hash() const noexcept;
+		NODISCARD bool operator==(const Builder& other) const noexcept;
+
+	private:
+		const Shader* m_computeShader = nullptr;
+
+		friend class ComputeProgram;
+	};
+
+	ComputeProgram() = default;
+	ComputeProgram(const Builder& builder);
+
+	const Shader* computeShader = nullptr;
+
+	Builder builder;
+	uint64 hash = 0;
 };
 
 class ComputePipeline : public Pipeline {
 public:
+	static constexpr Pipeline::BindPoint bindPoint = Pipeline::BindPoint::compute;
+
+	ComputePipeline() = default;
+	ComputePipeline(const ComputeProgram& program);
 
+	void bind() const;
+	void bind(const CommandQueue::CommandBuffer& commandBuffer) const;
+
+	const ComputeProgram* program = nullptr;
 };
 
 class ImGuiRenderer : public lyra::ImGuiRenderer {
@@ -1547,7 +2090,7 @@ private:
 	void beginFrame();
 	void endFrame();
 
-	vulkan::DescriptorPools m_descriptorPools;
+	vulkan::vk::DescriptorPool m_descriptorPool;
 	vulkan::RenderTarget m_renderTarget;
 };
 
@@ -1569,6 +2112,8 @@ public:
 	);
 
 	void initRenderComponents();
+	// merges the pipelines other instances have written to the cache file in the meantime and writes the cache back to it
+	void savePipelineCache();
 
 	/**
 	 * @brief wrappers around the core Vulkan API and VMA functions
@@ -1708,7 +2253,7 @@ public:
 	VkResult mapMemory(const vma::Allocation& allocation, void** ppData) {
 		return vmaMapMemory(allocator, allocation, ppData);
 	}
-	VkResult mergePipelineCache(const vk::PipelineCache& dstCache, const vk::PipelineCache srcCache) {
+	VkResult mergePipelineCache(const vk::PipelineCache& dstCache, const vk::PipelineCache& srcCache) {
 		return vkMergePipelineCaches(device, dstCache, 1, &srcCache.get());
 	}
 	VkResult mergePipelineCaches(const vk::PipelineCache& dstCache, const lsd::Vector<VkPipelineCache>& srcCaches) {
@@ -1755,6 +2300,7 @@ public:
 	VkPhysicalDeviceProperties deviceProperties;
 	VkPhysicalDeviceDescriptorIndexingPropertiesEXT descriptorIndexingProperties;
 	VkPhysicalDeviceFeatures deviceFeatures;
+	VkPhysicalDeviceVulkan12Features vulkan12Features; // the enabled features, the device has been created with these
 	vk::Device device;
 
 	QueueFamilies queueFamilies;
@@ -1764,18 +2310,30 @@ public:
 
 	vma::Allocator allocator;
 
-	vk::PipelineCache pipelineCache; // Implement the pipeline cache @todo
+	vk::PipelineCache pipelineCache;
+	uint64 loadedPipelineCacheHash = 0;
+
+	// compiles pipelines in the background, declared after the cache so that it is joined before the cache is destroyed
+	ThreadPool pipelineWorkers;
 
 	lsd::UniquePointer<CommandQueue> commandQueue;
+	lsd::UniquePointer<UploadQueue> uploadQueue;
+	lsd::UniquePointer<CommandRecorder> commandRecorder; // only created if config::parallelRecording is enabled
 	lsd::UniquePointer<Swapchain> swapchain;
 	lsd::UniquePointer<DescriptorPools> descriptorPools;
+	lsd::UniquePointer<TransientDescriptorPools> transientDescriptorPools;
+	lsd::UniquePointer<GeometryBuffer> geometryBuffer;
+	lsd::UniquePointer<InstanceBuffer> instanceBuffer;
+	lsd::UniquePointer<MaterialTable> materialTable;
 
 	lsd::Vector<RenderTarget*> renderTargets;
-	lsd::UnorderedSparseMap<lsd::String, const GraphicsProgram*> graphicsPrograms;
-	lsd::UnorderedSparseMap<lsd::String, GraphicsPipeline*> graphicsPipelines;
+	// keyed by the hash of the builder, colliding builders are moved to the next key in the probe sequence
+	lsd::UnorderedSparseMap<uint64, const GraphicsProgram*> graphicsPrograms;
+	lsd::UnorderedSparseMap<uint64, GraphicsPipeline*> graphicsPipelines;
 
 	RenderTarget* defaultRenderTarget;
 	const GraphicsProgram* defaultGraphicsProgram;
+	const GraphicsPipeline* defaultGraphicsPipeline;
 
 	std::filesystem::path defaultVertexShaderPath;
 	std::filesystem::path defaultFragmentShaderPath;
@@ -1786,8 +2344,9 @@ public:
 	etcs::Entity* sceneRoot;
 
 	lsd::Vector<Camera*> cameras;
-	lsd::UnorderedSparseMap<GraphicsPipeline*, lsd::Vector<const Material*>> materials;
-	lsd::UnorderedSparseMap<Material*, lsd::Vector<const MeshRenderer*>> meshRenderers;
+	lsd::UnorderedSparseMap<GraphicsPipeline*, lsd::Vector<Material*>> materials;
+	// renderers of the same mesh and material are drawn as instances of a single draw
+	lsd::UnorderedSparseMap<Material*, lsd::UnorderedSparseMap<const Mesh*, lsd::Vector<const MeshRenderer*>>> meshRenderers;
 
 	std::chrono::time_point<std::chrono::high_resolution_clock> startTime;
 
@@ -86,6 +86,7 @@ inline void init(InitFlags flags = InitFlags::all, InitInfo info = InitInfo()) {
 }
 
 inline void quit() {
+	quitResourceSystem();
 	quitRenderSystem();
 	SDL_Quit();
 }
@@ -0,0 +1,86 @@
+/*************************
+ * @file Culling.h
+ *
+ * @brief bounding volumes and CPU frustum culling
+ * @brief the volumes are tested in structure of arrays batches with SSE or AVX, depending on what the engine was compiled with
+ *************************/
+
+#pragma once
+
+#include <Common/Common.h>
+
+#include <LSD/Array.h>
+#include <LSD/Vector.h>
+
+#include <glm/glm.hpp>
+
+namespace lyra {
+
+// local space bounds of a mesh, stored both as an axis aligned box and as the sphere enclosing it
+struct BoundingVolume {
+	glm::vec3 center = glm::vec3(0.0f);
+	float32 radius = 0.0f;
+	glm::vec3 extent = glm::vec3(0.0f);
+
+	NODISCARD static BoundingVolume fromPoints(const glm::vec3* points, size_type count, size_type stride = sizeof(glm::vec3));
+};
+
+// a cluster of consecutive triangles of a mesh with its own bounds, so parts of a mesh can be culled on their own
+struct Meshlet {
+	glm::vec3 center = glm::vec3(0.0f); // mesh space bounding sphere of the triangles
+	float32 radius = 0.0f;
+	glm::vec3 coneAxis = glm::vec3(0.0f); // average normal of the counter clockwise triangles
+	float32 coneCutoff = 1.0f; // sine of the largest angle between the axis and a normal, one if the triangles can never all face away
+	uint32 firstIndex = 0;
+	uint32 indexCount = 0;
+	uint32 padding[2] = { };
+
+	// if every triangle faces away from a camera at the mesh space position, the test is conservative for the whole sphere
+	NODISCARD bool backfacing(const glm::vec3& cameraPosition) const noexcept;
+};
+
+class Frustum {
+public:
+	Frustum() = default;
+	// extracts the planes from a matrix with a zero to one depth range, the normals of the planes point inwards
+	Frustum(const glm::mat4& viewProjection);
+
+	NODISCARD bool intersects(const glm::vec3& center, float32 radius) const noexcept;
+
+	// left, right, bottom, top, near, far
+	lsd::Array<glm::vec4, 6> planes;
+};
+
+/**
+ * @brief world space bounding spheres in a structure of arrays layout
+ * @brief the arrays are padded to the SIMD width with spheres which are never visible, so the batches need no remainder loop
+ */
+class CullingVolumes {
+public:
+	void clear();
+	void reserve(size_type count);
+
+	// transforms the volume into world space and appends it
+	void pushBack(const BoundingVolume& volume, const glm::mat4& transform);
+
+	// writes the indices of all volumes intersecting the frustum to visible in ascending order
+	void cull(const Frustum& frustum, lsd::Vector<uint32>& visible) const;
+	// the same test one volume at a time, as a reference for the SIMD implementation
+	void cullScalar(const Frustum& frustum, lsd::Vector<uint32>& visible) const;
+
+	// world space center in xyz and radius in w
+	NODISCARD glm::vec4 sphere(size_type index) const noexcept { return { m_x[index], m_y[index], m_z[index], m_radius[index] }; }
+
+	NODISCARD constexpr size_type size() const noexcept { return m_size; }
+	NODISCARD constexpr bool empty() const noexcept { return m_size == 0; }
+
+private:
+	lsd::Vector<float32> m_x;
+	lsd::Vector<float32> m_y;
+	lsd::Vector<float32> m_z;
+	lsd::Vector<float32> m_radius;
+
+	size_type m_size = 0;
+};
+
+} // namespace lyra
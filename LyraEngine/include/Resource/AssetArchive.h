@@ -0,0 +1,85 @@
+/*************************
+ * @file AssetArchive.h
+ *
+ * @brief A single packed archive containing the built data of all assets in a project
+ * @brief Generated by LyraAssets next to the project file and mapped directly into memory at runtime
+ *************************/
+
+#pragma once
+
+#include <Common/Common.h>
+#include <Common/FileSystem.h>
+
+#include <filesystem>
+#include <string_view>
+
+namespace lyra {
+
+namespace resource {
+
+/**
+ * Layout of the archive:
+ *
+ * Header
+ * Entry entries[entryCount] - sorted by hash, starts at tocOffset
+ * char strings[stringsSize] - the paths of all entries, used to verify a hash match
+ * (padding to the alignment)
+ * entry data, every entry starts at a multiple of the alignment and is stored in the order the entries were added
+ */
+class AssetArchive {
+public:
+	static constexpr uint32 magic = 0x4B50594C; // "LYPK"
+	static constexpr uint32 version = 1;
+	static constexpr uint32 alignment = 64;
+	static constexpr const char* extension = ".lypak";
+
+	struct Header {
+		uint32 magic;
+		uint32 version;
+		uint32 entryCount;
+		uint32 alignment;
+		uint64 tocOffset;
+		uint64 stringsOffset;
+		uint64 stringsSize;
+		uint64 dataOffset;
+	};
+
+	struct Entry {
+		uint64 hash;
+		uint64 offset; // relative to the start of the file
+		uint64 size;
+		uint32 pathOffset;
+		uint32 pathSize;
+	};
+
+	static_assert(sizeof(Header) % alignof(Entry) == 0 && sizeof(Entry) == 32, "lyra::resource::AssetArchive: The archive layout is written to disk and may not change implicitly!");
+
+	AssetArchive() = default;
+	AssetArchive(const std::filesystem::path& path);
+
+	NODISCARD static constexpr uint64 alignUp(uint64 value) noexcept {
+		return (value + alignment - 1) & ~static_cast<uint64>(alignment - 1);
+	}
+
+	NODISCARD const Entry* find(std::string_view path) const noexcept;
+	// returns a view into the mapped archive, or an empty file if no such entry exists
+	NODISCARD MappedFile entry(std::string_view path) const;
+
+	NODISCARD size_type size() const noexcept {
+		return m_header ? m_header->entryCount : 0;
+	}
+	NODISCARD bool valid() const noexcept {
+		return m_header != nullptr;
+	}
+
+private:
+	MappedFile m_file;
+
+	const Header* m_header = nullptr;
+	const Entry* m_entries = nullptr;
+	const char* m_strings = nullptr;
+};
+
+} // namespace resource
+
+} // namespace lyra
@@ -0,0 +1,132 @@
+/*************************
+ * @file AssetIndex.h
+ *
+ * @brief A binary index over the metadata of all assets in a project
+ * @brief Generated by LyraAssets next to the project file and mapped directly into memory at runtime
+ *************************/
+
+#pragma once
+
+#include <Common/Common.h>
+#include <Common/FileSystem.h>
+
+#include <LSD/Vector.h>
+#include <LSD/JSON.h>
+
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+namespace lyra {
+
+namespace resource {
+
+/**
+ * Layout of the index, all sections are tightly packed after one another:
+ *
+ * Header
+ * uint32 buckets[bucketCount] - open addressing hash table, holds (record index + 1) or 0 for an empty bucket
+ * (padding to 8 bytes)
+ * Record records[recordCount]
+ * uint32 blocks[blockCount] - vertex and index block sizes of all meshes
+ * char strings[stringsSize] - the paths of all records, used to verify a hash match
+ */
+class AssetIndex {
+public:
+	static constexpr uint32 magic = 0x5849594C; // "LYIX"
+	static constexpr uint32 version = 2;
+	static constexpr const char* extension = ".lyidx";
+
+	enum class Kind : uint32 {
+		none,
+		texture,
+		mesh,
+		shader
+	};
+
+	struct Header {
+		uint32 magic;
+		uint32 version;
+		uint32 recordCount;
+		uint32 bucketCount;
+		uint32 blockCount;
+		uint32 stringsSize;
+	};
+
+	struct Record {
+		uint64 hash;
+		uint32 pathOffset;
+		uint32 pathSize;
+
+		Kind kind;
+		uint32 type;
+		uint32 uncompressed;
+
+		// texture metadata
+		uint32 width;
+		uint32 height;
+		uint32 alpha;
+		uint32 mipmap;
+		uint32 dimension;
+		uint32 wrap;
+		uint32 format;
+
+		// mesh metadata, the vertex block sizes are directly followed by the index block sizes
+		uint32 blockOffset;
+		uint32 vertexBlockCount;
+		uint32 indexBlockCount;
+
+		uint32 padding;
+	};
+
+	static_assert(sizeof(Record) == 72, "lyra::resource::AssetIndex::Record: The record layout is written to disk and may not change implicitly!");
+
+	AssetIndex() = default;
+	// map a previously built index file
+	AssetIndex(const std::filesystem::path& path);
+	// build the index in memory from the project file
+	AssetIndex(const lsd::Json& projectFile);
+	AssetIndex(const AssetIndex&) = delete;
+	DEFINE_DEFAULT_MOVE(AssetIndex)
+
+	AssetIndex& operator=(const AssetIndex&) = delete;
+
+	NODISCARD static lsd::Vector<char> build(const lsd::Json& projectFile);
+	NODISCARD static Kind kind(const std::filesystem::path& path);
+
+	NODISCARD const Record* find(std::string_view path) const noexcept;
+	NODISCARD const Record& at(std::string_view path) const;
+
+	NODISCARD std::string_view path(const Record& record) const noexcept {
+		return std::string_view(m_strings + record.pathOffset, record.pathSize);
+	}
+	NODISCARD std::span<const uint32> vertexBlocks(const Record& record) const noexcept {
+		return std::span<const uint32>(m_blocks + record.blockOffset, record.vertexBlockCount);
+	}
+	NODISCARD std::span<const uint32> indexBlocks(const Record& record) const noexcept {
+		return std::span<const uint32>(m_blocks + record.blockOffset + record.vertexBlockCount, record.indexBlockCount);
+	}
+
+	NODISCARD size_type size() const noexcept {
+		return m_header ? m_header->recordCount : 0;
+	}
+	NODISCARD bool valid() const noexcept {
+		return m_header != nullptr;
+	}
+
+private:
+	MappedFile m_file;
+	lsd::Vector<char> m_buffer;
+
+	const Header* m_header = nullptr;
+	const uint32* m_buckets = nullptr;
+	const Record* m_records = nullptr;
+	const uint32* m_blocks = nullptr;
+	const char* m_strings = nullptr;
+
+	void setup(const char* data, size_type size);
+};
+
+} // namespace resource
+
+} // namespace lyra
@@ -0,0 +1,68 @@
+/*************************
+ * @file Compression.h
+ *
+ * @brief Block based LZ4 compression of built asset data
+ * @brief Blocks are compressed independently, so they can be compressed and decompressed in parallel
+ *************************/
+
+#pragma once
+
+#include <Common/Common.h>
+#include <Common/FileSystem.h>
+
+#include <LSD/Vector.h>
+
+namespace lyra {
+
+class ThreadPool;
+
+namespace resource {
+
+/**
+ * Layout of a compressed file:
+ *
+ * CompressionHeader
+ * uint32 blockSizes[blockCount] - compressed size of every block
+ * block data, tightly packed in the order of the blocks
+ *
+ * Every block except the last one decompresses to exactly blockSize bytes
+ */
+struct CompressionHeader {
+	static constexpr uint32 magic = 0x4B42594C; // "LYBK"
+	static constexpr uint32 version = 1;
+
+	uint32 fileMagic;
+	uint32 fileVersion;
+	uint32 level;
+	uint32 blockSize;
+	uint64 uncompressed;
+	uint32 blockCount;
+	uint32 padding;
+};
+
+static_assert(sizeof(CompressionHeader) == 32, "lyra::resource::CompressionHeader: The header layout is written to disk and may not change implicitly!");
+
+// level 0 selects the fast default compressor, everything above selects the high compression compressor with that level
+inline constexpr uint32 maxCompressionLevel = 12;
+inline constexpr uint32 defaultBlockSize = 256 * 1024;
+inline constexpr uint32 minBlockSize = 16 * 1024;
+
+NODISCARD lsd::Vector<char> compress(
+	const void* data,
+	size_type size,
+	uint32 level = 0,
+	uint32 blockSize = defaultBlockSize,
+	ThreadPool* workers = nullptr
+);
+// writes exactly size bytes to dst, returns false if the file is corrupt or does not decompress to size bytes
+// files without a block header are treated as a single raw LZ4 block, as written by older versions of LyraAssets
+NODISCARD bool decompress(
+	const MappedFile& compressedFile,
+	void* dst,
+	size_type size,
+	ThreadPool* workers = nullptr
+);
+
+} // namespace resource
+
+} // namespace lyra
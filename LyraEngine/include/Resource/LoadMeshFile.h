@@ -12,31 +12,50 @@
 #pragma once
 
 #include <Common/Common.h>
+#include <Common/FileSystem.h>
 
 #include <LSD/Utility.h>
 #include <LSD/Vector.h>
 #include <LSD/StringView.h>
-#include <LSD/JSON.h>
+
+#include <Math/Culling.h>
 
 #include <filesystem>
+#include <span>
 
 namespace lyra {
 
+class ThreadPool;
+
 namespace resource {
 
+// every vertex block is preceded by the bounds its vertices were quantized with and the errors of its levels of detail, followed by the already packed vertices
 struct MeshFile {
+	// the levels of detail of a vertex block are consecutive index blocks, starting with the original mesh
+	struct Lods {
+		uint32 firstIndexBlock;
+		lsd::Vector<float32> errors;
+	};
+
 	lsd::Vector<uint32> vertexBlocks;
 	lsd::Vector<uint32> indexBlocks;
 
-	lsd::Vector<lsd::Vector<float32>> vertexData;
-	lsd::Vector<lsd::Vector<uint32>> indexData;
+	lsd::Vector<BoundingVolume> bounds;
+	lsd::Vector<Lods> lods;
+	lsd::Vector<lsd::Vector<char>> vertexData;
+	// stored after all vertex blocks, with 16 bit indices if the vertex block they belong to can be addressed by them
+	lsd::Vector<lsd::Vector<char>> indexData;
+	// stored after all index blocks, every index block is split into meshlets
+	lsd::Vector<lsd::Vector<Meshlet>> meshletData;
 };
 
 NODISCARD MeshFile loadMeshFile(
-	std::filesystem::path path, 
+	const MappedFile& compressedFile, 
 	uint32 uncompressed,
-	const lsd::Json::array_type& vertexBlocks,
-	const lsd::Json::array_type& indexBlocks
+	uint32 vertexLayout,
+	std::span<const uint32> vertexBlocks,
+	std::span<const uint32> indexBlocks,
+	ThreadPool* workers = nullptr
 );
 
 } // namespace resource
@@ -12,15 +12,62 @@
 #pragma once
 
 #include <Common/Common.h>
+#include <Common/FileSystem.h>
 #include <LSD/UniquePointer.h>
 
 #include <LSD/Vector.h>
+
+#include <algorithm>
 #include <filesystem>
 
 namespace lyra {
 
+class ThreadPool;
+
 namespace resource {
 
+// format of the texture data in the built files
+// all mip levels are stored directly after each other, starting with the largest one
+enum class TextureFormat : uint32 {
+	rgba8,
+	bc1,
+	bc3,
+	bc4,
+	bc5, // only stores the x and y components of normals, z has to be reconstructed when sampling
+	bc7
+};
+
+NODISCARD constexpr bool blockCompressed(TextureFormat format) noexcept {
+	return format != TextureFormat::rgba8;
+}
+// size of a single texel for uncompressed formats, otherwise of a block of 4x4 texels
+NODISCARD constexpr uint32 textureBlockSize(TextureFormat format) noexcept {
+	switch (format) {
+		case TextureFormat::bc1:
+		case TextureFormat::bc4:
+			return 8;
+		case TextureFormat::bc3:
+		case TextureFormat::bc5:
+		case TextureFormat::bc7:
+			return 16;
+		default:
+			return 4;
+	}
+}
+NODISCARD constexpr size_type textureLevelSize(TextureFormat format, uint32 width, uint32 height) noexcept {
+	if (!blockCompressed(format)) return static_cast<size_type>(width) * height * textureBlockSize(format);
+	return static_cast<size_type>((width + 3) / 4) * ((height + 3) / 4) * textureBlockSize(format);
+}
+NODISCARD constexpr size_type textureSize(TextureFormat format, uint32 width, uint32 height, uint32 levels) noexcept {
+	size_type size = 0;
+
+	for (uint32 i = 0; i < levels; i++) {
+		size += textureLevelSize(format, std::max(width >> i, 1U), std::max(height >> i, 1U));
+	}
+
+	return size;
+}
+
 struct TextureFile {
 	uint32 width;
 	uint32 height;
@@ -29,12 +76,13 @@ struct TextureFile {
 	uint32 mipmap;
 	uint32 dimension;
 	uint32 wrap;
+	TextureFormat format;
 
 	lsd::Vector<char> data;
 };
 
 NODISCARD TextureFile loadTextureFile(
-	std::filesystem::path path,
+	const MappedFile& compressedFile,
 	uint32 uncompressed,
 	uint32 width,
 	uint32 height,
@@ -42,7 +90,9 @@ NODISCARD TextureFile loadTextureFile(
 	uint32 alpha,
 	uint32 mipmap,
 	uint32 dimension,
-	uint32 wrap
+	uint32 wrap,
+	TextureFormat format,
+	ThreadPool* workers = nullptr
 );
 
 } // namespace resource
@@ -18,12 +18,43 @@
 #include <Graphics/Mesh.h>
 #include <Graphics/Material.h>
 
+#include <chrono>
+#include <future>
+#include <limits>
+
 namespace lyra {
 
 void initResourceSystem();
+void quitResourceSystem();
 
 namespace resource {
 
+// Handle to a resource which is loaded in the background
+// File IO and decompression run on the resource systems worker threads, while the GPU side creation only happens in finalizeLoads() on the main thread
+template <class Ty> class Future {
+public:
+	using value_type = Ty;
+	using future_type = std::shared_future<const value_type*>;
+
+	Future() = default;
+	Future(const future_type& future) : m_future(future) { }
+
+	NODISCARD bool valid() const noexcept {
+		return m_future.valid();
+	}
+	NODISCARD bool ready() const {
+		return m_future.valid() && m_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+	// since the resource is finalized on the main thread, blocking on it there would never return
+	NODISCARD const value_type& get() const {
+		ASSERT(ready(), "lyra::resource::Future::get(): Attempted to access a resource which hasn't finished loading yet!");
+		return *m_future.get();
+	}
+
+private:
+	future_type m_future;
+};
+
 const vulkan::Shader& shader(std::filesystem::path name);
 const Texture& texture(std::filesystem::path name);
 const Material& material(std::filesystem::path name);
@@ -35,6 +66,14 @@ inline const Mesh& mesh(std::filesystem::path path, uint32 index) {
 	return mesh(path)[index];
 }
 
+NODISCARD Future<vulkan::Shader> shaderAsync(std::filesystem::path name);
+NODISCARD Future<Texture> textureAsync(std::filesystem::path name);
+NODISCARD Future<lsd::Vector<Mesh>> meshAsync(std::filesystem::path name);
+
+// create the GPU objects of at most maxCount resources whose background work completed, has to be called on the main thread
+void finalizeLoads(uint32 maxCount = std::numeric_limits<uint32>::max());
+NODISCARD bool loadsPending();
+
 } // namespace resource
 
 } // namespace lyra
\ No newline at end of file
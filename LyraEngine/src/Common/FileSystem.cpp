@@ -8,9 +8,19 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <mutex>
 #include <stdexcept>
 #include <LSD/UnorderedSparseMap.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace lyra {
 
 namespace {
@@ -24,6 +34,7 @@ class FileSystem {
 public:
 	static constexpr size_type bufferSize = BUFSIZ;
 	static constexpr size_type maxFiles = FOPEN_MAX;
+	static constexpr size_type maxMappings = 256;
 	static constexpr const char* assetsFilePath = "data/Assets.lyproj";
 
 	using PathStringType = std::filesystem::path::string_type;
@@ -37,9 +48,8 @@ public:
 	}
 
 	NODISCARD lsd::SharedPointer<std::FILE> loadFile(const std::filesystem::path& path, const char* mode) {
-		// @todo implement as multithreaded
-		// return signal (bool mutex?)
-		// run on different thread and set bool to true when done
+		// files may be opened from the resource systems worker threads
+		std::lock_guard<std::mutex> guard(mutex);
 
 		PathStringType p(path.native());
 #ifdef _WIN32
@@ -76,7 +86,55 @@ public:
 		return file;
 	}
 
+	NODISCARD MappedFile::mapping_type mapFile(const std::filesystem::path& path) {
+		std::lock_guard<std::mutex> guard(mutex);
+
+		std::error_code error;
+		auto writeTime = std::filesystem::last_write_time(absolutePath(path), error);
+		auto fileSize = error ? 0 : std::filesystem::file_size(absolutePath(path), error);
+
+		auto it = loadedMappings.find(path.native());
+
+		if (it != loadedMappings.end()) {
+			// a file rewritten since it was mapped gets a new mapping, the views of the old one keep it alive until they are closed
+			if (!error && it->second->writeTime == writeTime && it->second->size == fileSize) {
+				return it->second;
+			}
+
+			loadedMappings.erase(it);
+		}
+
+		if (loadedMappings.size() >= maxMappings) { // unmap a file which isn't viewed anymore
+			for (auto it = loadedMappings.begin(); it != loadedMappings.end(); it++) {
+				if (it->second.count() == 1) {
+					loadedMappings.erase(it);
+					break;
+				}
+			}
+		}
+
+		auto& mapping = loadedMappings.tryEmplace(
+			path.native(),
+			new MappedFile::Mapping(absolutePath(path))
+		).first->second;
+
+		ASSERT(mapping->data, "Failed to map file at path: {}!", absolutePath(path).string());
+		mapping->writeTime = writeTime;
+
+		return mapping;
+	}
+
+	NODISCARD MappedFile::mapping_type mapUnsharedFile(const std::filesystem::path& path) const {
+		MappedFile::mapping_type mapping(new MappedFile::Mapping(absolutePath(path)));
+
+		ASSERT(mapping->data, "Failed to map file at path: {}!", absolutePath(path).string());
+
+		return mapping;
+	}
+
 	NODISCARD char* unusedBuffer() {
+		std::lock_guard<std::mutex> guard(mutex);
+
 		if (buffers.empty()) buffers.pushBack(new char[bufferSize]);
 
 		auto r = buffers.back();
@@ -86,14 +144,19 @@ public:
 	
 	void returnBuffer(char* buffer) {
 		memset(buffer, '\0', bufferSize);
+
+		std::lock_guard<std::mutex> guard(mutex);
 		buffers.pushBack(buffer);
 	}
 
 	lsd::Vector<char*> buffers;
 
 	lsd::UnorderedSparseMap<PathStringType, lsd::SharedPointer<std::FILE>> loadedFiles;
+	lsd::UnorderedSparseMap<PathStringType, MappedFile::mapping_type> loadedMappings;
 
 	std::filesystem::path absolutePathBase;
+
+	std::mutex mutex;
 };
 
 const char* enumToOpenMode(OpenMode m) {
@@ -147,6 +210,10 @@ bool fileLoaded(const std::filesystem::path& path) {
 	return globalFileSystem->loadedFiles.contains(path);
 }
 
+bool fileMapped(const std::filesystem::path& path) {
+	return globalFileSystem->loadedMappings.contains(path.native());
+}
+
 ByteFile tmpFile() {
 	auto s = 
 #ifdef _WIN32
@@ -299,6 +366,86 @@ std::filesystem::path File<char>::absolutePath() const {
 }
 
 
+MappedFile::Mapping::Mapping(const std::filesystem::path& path) {
+#ifdef _WIN32
+	auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize)) fileSize.QuadPart = -1;
+
+	if (fileSize.QuadPart == 0) {
+		// empty files cannot be mapped, but are still valid
+		data = "";
+	} else if (fileSize.QuadPart > 0) {
+		auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (mapping) {
+			// the view keeps the mapping object alive after the handle is closed
+			data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			if (data) size = static_cast<size_type>(fileSize.QuadPart);
+			CloseHandle(mapping);
+		}
+	}
+
+	CloseHandle(file);
+#else
+	auto file = open(path.c_str(), O_RDONLY);
+	if (file == -1) return;
+
+	struct stat fileInfo;
+	if (fstat(file, &fileInfo) != 0) fileInfo.st_size = -1;
+
+	if (fileInfo.st_size == 0) {
+		// empty files cannot be mapped, but are still valid
+		data = "";
+	} else if (fileInfo.st_size > 0) {
+		// the mapping stays valid after closing the file descriptor
+		auto mapped = mmap(nullptr, static_cast<size_type>(fileInfo.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+		if (mapped != MAP_FAILED) {
+			data = static_cast<const char*>(mapped);
+			size = static_cast<size_type>(fileInfo.st_size);
+
+			// assets are almost always decompressed front to back
+			madvise(mapped, size, MADV_SEQUENTIAL);
+		}
+	}
+
+	::close(file);
+#endif
+}
+
+MappedFile::Mapping::~Mapping() {
+	if (size == 0) return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+#else
+	munmap(const_cast<char*>(data), size);
+#endif
+}
+
+MappedFile::MappedFile(const std::filesystem::path& path, bool shared) : 
+	m_mapping(shared ? globalFileSystem->mapFile(path) : globalFileSystem->mapUnsharedFile(path)),
+	m_data(m_mapping->data),
+	m_size(m_mapping->size),
+	m_path(path) { }
+MappedFile::MappedFile(const MappedFile& file, size_type offset, size_type size) :
+	m_mapping(file.m_mapping),
+	m_data(file.m_data + offset),
+	m_size(size),
+	m_path(file.m_path) {
+	ASSERT(offset + size <= file.m_size, "lyra::MappedFile::MappedFile(): Section at offset: {} with size: {} exceeds the size of the mapped file at path: {}!", offset, size, file.m_path.string());
+}
+
+void MappedFile::close() {
+	m_mapping = nullptr;
+	m_data = nullptr;
+	m_size = 0;
+}
+
+
 File<wchar>::File(const std::filesystem::path& path, OpenMode mode, bool buffered) : 
 	m_stream(globalFileSystem->loadFile(path, enumToOpenMode(mode))), 
 	m_path(path), 
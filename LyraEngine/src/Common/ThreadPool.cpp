@@ -0,0 +1,92 @@
+#include <Common/ThreadPool.h>
+
+namespace lyra {
+
+ThreadPool::ThreadPool(uint32 threadCount) {
+	m_threads.reserve(threadCount);
+	for (uint32 i = 0; i < threadCount; i++) m_threads.emplaceBack(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_stop = true;
+	}
+
+	m_taskCondition.notify_all();
+	for (auto& thread : m_threads) thread.join();
+}
+
+void ThreadPool::push(task_type&& task) {
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_tasks.push_back(std::move(task));
+	}
+
+	m_taskCondition.notify_one();
+}
+
+void ThreadPool::parallelFor(size_type count, const std::function<void(size_type)>& func) {
+	parallelFor(count, [&func](size_type index, uint32) { func(index); });
+}
+
+void ThreadPool::parallelFor(size_type count, const std::function<void(size_type, uint32)>& func) {
+	if (count == 0) return;
+
+	// the state is shared, since helper tasks may still be dequeued after all indices were processed and this function returned
+	struct State {
+		std::function<void(size_type, uint32)> func;
+		size_type count;
+		std::atomic<size_type> next = 0;
+		std::atomic<size_type> done = 0;
+	};
+
+	auto state = std::make_shared<State>(func, count);
+
+	// every helper task is pushed with its own slot, a task is only ever executed by a single thread
+	auto process = [state](uint32 slot) {
+		for (auto i = state->next.fetch_add(1); i < state->count; i = state->next.fetch_add(1)) {
+			state->func(i, slot);
+			state->done.fetch_add(1, std::memory_order_release);
+		}
+	};
+
+	for (uint32 i = 0; i < std::min<size_type>(count - 1, m_threads.size()); i++) push([process, i]() { process(i + 1); });
+
+	process(0);
+
+	while (state->done.load(std::memory_order_acquire) != count) std::this_thread::yield();
+}
+
+void ThreadPool::wait() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idleCondition.wait(lock, [this]() { return m_tasks.empty() && m_activeTasks == 0; });
+}
+
+void ThreadPool::work() {
+	while (true) {
+		task_type task;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_taskCondition.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+
+			if (m_stop && m_tasks.empty()) return;
+
+			task = std::move(m_tasks.front());
+			m_tasks.pop_front();
+			m_activeTasks++;
+		}
+
+		task();
+
+		{
+			std::lock_guard<std::mutex> guard(m_mutex);
+			m_activeTasks--;
+		}
+
+		m_idleCondition.notify_all();
+	}
+}
+
+} // namespace lyra
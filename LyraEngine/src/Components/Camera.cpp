@@ -34,12 +34,15 @@ void Camera::update() {
 	}
 }
 
-Camera::TransformData Camera::data(const glm::mat4& meshTransform) const noexcept {
+Camera::TransformData Camera::data() const noexcept {
 	return TransformData {
 		entity->component<etcs::Transform>().globalTransform(),
-		m_projectionMatrix,
-		meshTransform
+		m_projectionMatrix
 	};
 }
 
+Frustum Camera::frustum() const {
+	return Frustum(m_projectionMatrix * entity->component<etcs::Transform>().globalTransform());
+}
+
 } // namespace lyra
@@ -0,0 +1,426 @@
+#include <Graphics/CullingPass.h>
+
+#include <Resource/ResourceSystem.h>
+
+#include <algorithm>
+#include <bit>
+
+namespace lyra {
+
+namespace renderer {
+
+extern vulkan::RenderSystem* globalRenderSystem;
+
+}
+
+namespace vulkan {
+
+namespace {
+
+ComputeProgram::Builder depthPyramidProgramBuilder() {
+	ComputeProgram::Builder builder;
+	builder.setComputeShader(resource::shader("shader/depthPyramid.spv"));
+	builder.addBindings({
+		{ DescriptorSets::Type::imageSampler, Shader::Type::compute }, // previous level or the depth source
+		{ DescriptorSets::Type::storageImage, Shader::Type::compute } // current level
+	});
+	builder.addPushConstant({ Shader::Type::compute, sizeof(glm::uvec4) });
+
+	return builder;
+}
+
+// both culling passes share the same layout, so a single descriptor set is compatible with both
+ComputeProgram::Builder cullingProgramBuilder(std::filesystem::path shaderPath) {
+	ComputeProgram::Builder builder;
+	builder.setComputeShader(resource::shader(shaderPath));
+	builder.addBindings({
+		{ DescriptorSets::Type::storageBuffer, Shader::Type::compute }, // candidates
+		{ DescriptorSets::Type::storageBuffer, Shader::Type::compute }, // draws
+		{ DescriptorSets::Type::storageBuffer, Shader::Type::compute }, // instances
+		{ DescriptorSets::Type::storageBuffer, Shader::Type::compute }, // visible instances
+		{ DescriptorSets::Type::storageBuffer, Shader::Type::compute }, // visible instance count per draw
+		{ DescriptorSets::Type::storageBuffer, Shader::Type::compute }, // output draws
+		{ DescriptorSets::Type::storageBuffer, Shader::Type::compute }, // output draw count per batch
+		{ DescriptorSets::Type::imageSampler, Shader::Type::compute, 0, 1, Program::Builder::Flags::partiallyBound } // depth pyramid
+	});
+	builder.addPushConstant({ Shader::Type::compute, sizeof(CullingPass::PushConstants) });
+
+	return builder;
+}
+
+}
+
+DepthPyramid::DepthPyramid(const glm::uvec2& sourceExtent) :
+	extent(std::bit_floor(sourceExtent.x), std::bit_floor(sourceExtent.y)),
+	sourceExtent(sourceExtent),
+	program(depthPyramidProgramBuilder()),
+	pipeline(program) {
+	auto levelCount = static_cast<uint32>(std::bit_width(std::max(extent.x, extent.y)));
+
+	image = Image(
+		image.imageCreateInfo(
+			Image::Format::r32SFloat,
+			{ extent.x, extent.y, 1 },
+			VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+			levelCount
+		),
+		GPUMemory::getAllocCreateInfo(VMA_MEMORY_USAGE_GPU_ONLY, VkMemoryPropertyFlags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)),
+		memory.memory
+	);
+
+	resource = Image::Resource(image, { VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1 });
+
+	levels.reserve(levelCount);
+	for (uint32 i = 0; i < levelCount; i++) {
+		levels.emplaceBack(image, VkImageSubresourceRange { VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1 });
+	}
+
+	// the shaders only fetch single texels, so the filter is irrelevant
+	sampler = Image::createSampler(
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE,
+		static_cast<float32>(levelCount),
+		0.0f,
+		0.0f,
+		VK_FILTER_NEAREST,
+		VK_FILTER_NEAREST,
+		VK_SAMPLER_MIPMAP_MODE_NEAREST
+	);
+
+	descriptorSets.reserve(levelCount);
+	for (uint32 i = 0; i < levelCount; i++) {
+		descriptorSets.pushBack(renderer::globalRenderSystem->descriptorPools->allocate(program, 0, false));
+
+		VkDescriptorImageInfo sourceInfo { sampler, (i == 0) ? VK_NULL_HANDLE : levels[i - 1].view.get(), VK_IMAGE_LAYOUT_GENERAL };
+		VkDescriptorImageInfo destinationInfo { VK_NULL_HANDLE, levels[i].view, VK_IMAGE_LAYOUT_GENERAL };
+
+		lsd::Vector<VkWriteDescriptorSet> writes;
+		writes.pushBack({
+			VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			nullptr,
+			descriptorSets[i],
+			1,
+			0,
+			1,
+			VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+			&destinationInfo,
+			nullptr,
+			nullptr
+		});
+
+		// the source of the first level is written once it is known
+		if (i != 0) writes.pushBack({
+			VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			nullptr,
+			descriptorSets[i],
+			0,
+			0,
+			1,
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			&sourceInfo,
+			nullptr,
+			nullptr
+		});
+
+		renderer::globalRenderSystem->updateDescriptorSet(writes);
+	}
+}
+
+void DepthPyramid::setSource(const VkImageView& sourceView, const glm::uvec2& sourceExtent) {
+	this->sourceExtent = sourceExtent;
+
+	VkDescriptorImageInfo sourceInfo { sampler, sourceView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+
+	renderer::globalRenderSystem->updateDescriptorSet({{
+		VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+		nullptr,
+		descriptorSets[0],
+		0,
+		0,
+		1,
+		VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		&sourceInfo,
+		nullptr,
+		nullptr
+	}});
+}
+
+void DepthPyramid::build(const CommandQueue::CommandBuffer& commandBuffer) const {
+	// the previous contents are overwritten entirely, but the culling of the last frame may still read them
+	commandBuffer.pipelineBarrier(
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		{ },
+		{ },
+		image.imageMemoryBarrier(
+			GPUMemory::Access::shaderRead,
+			GPUMemory::Access::shaderWrite,
+			Image::Layout::undefined,
+			Image::Layout::general,
+			{ VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount(), 0, 1 }
+		)
+	);
+
+	pipeline.bind(commandBuffer);
+
+	for (uint32 i = 0; i < levelCount(); i++) {
+		auto levelExtent = glm::max(extent >> i, 1u);
+		glm::uvec4 constants((i == 0) ? sourceExtent : glm::max(extent >> (i - 1), 1u), levelExtent);
+
+		commandBuffer.bindDescriptorSet(VK_PIPELINE_BIND_POINT_COMPUTE, program.pipelineLayout, 0, descriptorSets[i]);
+		commandBuffer.pushConstants(program.pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		commandBuffer.dispatchInvocations(levelExtent.x, localSize, levelExtent.y, localSize);
+
+		// the next level reads this one
+		commandBuffer.pipelineBarrier(
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			{ },
+			{ },
+			image.imageMemoryBarrier(
+				GPUMemory::Access::shaderWrite,
+				GPUMemory::Access::shaderRead,
+				Image::Layout::general,
+				Image::Layout::general,
+				{ VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1 }
+			)
+		);
+	}
+}
+
+CullingPass::CullingPass(uint32 candidateCapacity, uint32 drawCapacity, uint32 batchCapacity) :
+	cullProgram(cullingProgramBuilder("shader/cull.spv")),
+	cullPipeline(cullProgram),
+	compactProgram(cullingProgramBuilder("shader/cullCompact.spv")),
+	compactPipeline(compactProgram) {
+	descriptorSet = renderer::globalRenderSystem->descriptorPools->allocate(cullProgram, 0, false);
+
+	create(candidateCapacity, drawCapacity, batchCapacity);
+}
+
+CullingPass::~CullingPass() {
+	destroy();
+}
+
+void CullingPass::reserve(uint32 candidateCount, uint32 drawCount, uint32 batchCount) {
+	if (candidateCount <= candidateCapacity && drawCount <= drawCapacity && batchCount <= batchCapacity) return;
+
+	destroy();
+	create(
+		std::max(candidateCapacity * 2, candidateCount),
+		std::max(drawCapacity * 2, drawCount),
+		std::max(batchCapacity * 2, batchCount)
+	);
+}
+
+void CullingPass::flush(uint32 candidateCount, uint32 drawCount) const {
+	if (candidateCount != 0) {
+		VULKAN_ASSERT(renderer::globalRenderSystem->flushAllocation(candidateBuffer.memory, 0, candidateCount * sizeof(Candidate)), "flush culling candidate buffer memory");
+		VULKAN_ASSERT(renderer::globalRenderSystem->flushAllocation(instanceBuffer.memory, 0, candidateCount * sizeof(InstanceBuffer::InstanceData)), "flush culling instance buffer memory");
+	}
+
+	if (drawCount != 0) {
+		VULKAN_ASSERT(renderer::globalRenderSystem->flushAllocation(drawBuffer.memory, 0, drawCount * sizeof(Draw)), "flush culling draw buffer memory");
+	}
+}
+
+void CullingPass::setDepthPyramid(const DepthPyramid& depthPyramid) {
+	this->depthPyramid = &depthPyramid;
+	updateDescriptorSet();
+}
+
+void CullingPass::record(
+	const CommandQueue::CommandBuffer& commandBuffer,
+	const glm::mat4& viewProjection,
+	uint32 candidateCount,
+	uint32 drawCount,
+	uint32 batchCount,
+	bool occlusion
+) const {
+	ASSERT(
+		candidateCount <= candidateCapacity && drawCount <= drawCapacity && batchCount <= batchCapacity,
+		"lyra::vulkan::CullingPass::record(): The counts exceed the capacity of the pass, call reserve() first!"
+	);
+
+	flush(candidateCount, drawCount);
+
+	PushConstants constants {
+		viewProjection,
+		(depthPyramid) ? glm::vec2(depthPyramid->extent) : glm::vec2(0.0f),
+		candidateCount,
+		drawCount,
+		(occlusion && depthPyramid) ? 1u : 0u
+	};
+
+	// the draws and instances of the previous cull may still be in use
+	commandBuffer.pipelineBarrier(
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0
+	);
+
+	commandBuffer.fillBuffer(visibleCountBuffer.buffer, 0, VK_WHOLE_SIZE, 0);
+	commandBuffer.fillBuffer(drawCountBuffer.buffer, 0, VK_WHOLE_SIZE, 0);
+	// without a count buffer the maximum number of draws is always drawn, so the unused ones must not draw anything
+	if (!renderer::globalRenderSystem->vulkan12Features.drawIndirectCount) commandBuffer.fillBuffer(outputDrawBuffer.buffer, 0, VK_WHOLE_SIZE, 0);
+
+	commandBuffer.pipelineBarrier(
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		{ VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT }
+	);
+
+	// cull the candidates and count the visible instances of every draw
+	cullPipeline.bind(commandBuffer);
+	commandBuffer.bindDescriptorSet(VK_PIPELINE_BIND_POINT_COMPUTE, cullProgram.pipelineLayout, 0, descriptorSet);
+	commandBuffer.pushConstants(cullProgram.pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	commandBuffer.dispatchInvocations(candidateCount, localSize);
+
+	commandBuffer.pipelineBarrier(
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		{ VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT }
+	);
+
+	// write the draws with at least one visible instance to the output of their batch
+	compactPipeline.bind(commandBuffer);
+	commandBuffer.bindDescriptorSet(VK_PIPELINE_BIND_POINT_COMPUTE, compactProgram.pipelineLayout, 0, descriptorSet);
+	commandBuffer.pushConstants(compactProgram.pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	commandBuffer.dispatchInvocations(drawCount, localSize);
+
+	commandBuffer.pipelineBarrier(
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0,
+		{ VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT }
+	);
+}
+
+void CullingPass::draw(const CommandQueue::CommandBuffer& commandBuffer, uint32 batch, uint32 firstOutput, uint32 maxDrawCount) const {
+	auto renderSystem = renderer::globalRenderSystem;
+
+	if (renderSystem->vulkan12Features.drawIndirectCount) {
+		commandBuffer.drawIndexedIndirectCount(
+			outputDrawBuffer.buffer,
+			firstOutput * sizeof(VkDrawIndexedIndirectCommand),
+			drawCountBuffer.buffer,
+			batch * sizeof(uint32),
+			maxDrawCount,
+			sizeof(VkDrawIndexedIndirectCommand)
+		);
+	} else if (renderSystem->deviceFeatures.multiDrawIndirect) {
+		commandBuffer.drawIndexedIndirect(outputDrawBuffer.buffer, firstOutput * sizeof(VkDrawIndexedIndirectCommand), maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+	} else {
+		for (uint32 i = 0; i < maxDrawCount; i++) {
+			commandBuffer.drawIndexedIndirect(outputDrawBuffer.buffer, (firstOutput + i) * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+		}
+	}
+}
+
+void CullingPass::create(uint32 candidateCapacity, uint32 drawCapacity, uint32 batchCapacity) {
+	this->candidateCapacity = candidateCapacity;
+	this->drawCapacity = drawCapacity;
+	this->batchCapacity = batchCapacity;
+
+	candidateBuffer = GPUBuffer(candidateCapacity * sizeof(Candidate), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	drawBuffer = GPUBuffer(drawCapacity * sizeof(Draw), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	instanceBuffer = GPUBuffer(candidateCapacity * sizeof(InstanceBuffer::InstanceData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+	visibleInstanceBuffer = GPUBuffer(
+		candidateCapacity * sizeof(InstanceBuffer::InstanceData),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VMA_MEMORY_USAGE_GPU_ONLY
+	);
+	visibleCountBuffer = GPUBuffer(
+		drawCapacity * sizeof(uint32),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VMA_MEMORY_USAGE_GPU_ONLY
+	);
+	outputDrawBuffer = GPUBuffer(
+		drawCapacity * sizeof(VkDrawIndexedIndirectCommand),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VMA_MEMORY_USAGE_GPU_ONLY
+	);
+	drawCountBuffer = GPUBuffer(
+		batchCapacity * sizeof(uint32),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VMA_MEMORY_USAGE_GPU_ONLY
+	);
+
+	VULKAN_ASSERT(renderer::globalRenderSystem->mapMemory(candidateBuffer.memory, reinterpret_cast<void**>(&candidates)), "map culling candidate buffer memory at {}", lsd::getAddress(candidateBuffer.memory));
+	VULKAN_ASSERT(renderer::globalRenderSystem->mapMemory(drawBuffer.memory, reinterpret_cast<void**>(&draws)), "map culling draw buffer memory at {}", lsd::getAddress(drawBuffer.memory));
+	VULKAN_ASSERT(renderer::globalRenderSystem->mapMemory(instanceBuffer.memory, reinterpret_cast<void**>(&instances)), "map culling instance buffer memory at {}", lsd::getAddress(instanceBuffer.memory));
+
+	updateDescriptorSet();
+}
+
+void CullingPass::destroy() {
+	if (candidates) renderer::globalRenderSystem->unmapMemory(candidateBuffer.memory);
+	if (draws) renderer::globalRenderSystem->unmapMemory(drawBuffer.memory);
+	if (instances) renderer::globalRenderSystem->unmapMemory(instanceBuffer.memory);
+
+	candidates = nullptr;
+	draws = nullptr;
+	instances = nullptr;
+}
+
+void CullingPass::updateDescriptorSet() const {
+	lsd::Array<VkDescriptorBufferInfo, 7> bufferInfos {{
+		candidateBuffer.getDescriptorBufferInfo(),
+		drawBuffer.getDescriptorBufferInfo(),
+		instanceBuffer.getDescriptorBufferInfo(),
+		visibleInstanceBuffer.getDescriptorBufferInfo(),
+		visibleCountBuffer.getDescriptorBufferInfo(),
+		outputDrawBuffer.getDescriptorBufferInfo(),
+		drawCountBuffer.getDescriptorBufferInfo()
+	}};
+
+	lsd::Vector<VkWriteDescriptorSet> writes;
+	writes.reserve(bufferInfos.size() + 1);
+
+	for (uint32 i = 0; i < bufferInfos.size(); i++) {
+		writes.pushBack({
+			VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			nullptr,
+			descriptorSet,
+			i,
+			0,
+			1,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			nullptr,
+			&bufferInfos[i],
+			nullptr
+		});
+	}
+
+	// the pyramid is partially bound, so it may be left empty if occlusion culling is never used
+	VkDescriptorImageInfo pyramidInfo { };
+	if (depthPyramid) {
+		pyramidInfo = { depthPyramid->sampler, depthPyramid->resource.view, VK_IMAGE_LAYOUT_GENERAL };
+
+		writes.pushBack({
+			VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			nullptr,
+			descriptorSet,
+			static_cast<uint32>(bufferInfos.size()),
+			0,
+			1,
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			&pyramidInfo,
+			nullptr,
+			nullptr
+		});
+	}
+
+	renderer::globalRenderSystem->updateDescriptorSet(writes);
+}
+
+} // namespace vulkan
+
+} // namespace lyra
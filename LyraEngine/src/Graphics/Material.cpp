@@ -6,6 +6,12 @@
 
 namespace lyra {
 
+namespace renderer {
+
+extern vulkan::RenderSystem* globalRenderSystem;
+
+}
+
 // material data
 Material::Material(
 	const Color& albedoColor,
@@ -24,83 +30,88 @@ Material::Material(
 	const vulkan::GraphicsPipeline::Builder& pipelineBuilder,
 	const vulkan::GraphicsProgram::Builder& programBuilder
 ) : m_graphicsPipeline(&renderer::graphicsPipeline(pipelineBuilder, programBuilder)),
-	m_descriptorSets(*m_graphicsPipeline->program, 0, true),
-	m_albedoColor(albedoColor),
 	m_albedoTextures(albedoTextures),
-	m_metallic(metallic),
-	m_roughness(roughness),
 	m_metallicTexture(metallicTexture),
-	m_specularColor(specularColor),
 	m_specularTexture(specularTexture),
-	m_emissionColor(emissionColor),
 	m_emissionTexture(emissionTexture),
 	m_normalMapTexture(normalMapTexture),
 	m_displacementMapTexture(displacementMapTexture),
-	m_occlusionColor(occlusionColor),
 	m_occlusionMapTexture(occlusionMapTexture)
 {
-	// uniform data to send to the fragment shader
-	FragmentShaderData fragDat {
-		m_albedoColor,
-		m_emissionColor,
-		m_specularColor,
-		m_occlusionColor,
-		m_metallic,
-		m_roughness
+	auto& materialTable = *renderer::globalRenderSystem->materialTable;
+
+	auto textureIndex = [&materialTable](const Texture* texture, const Texture& fallback) {
+		return materialTable.addTexture(texture ? *texture : fallback);
+	};
+
+	m_data = {
+		albedoColor,
+		emissionColor,
+		specularColor,
+		occlusionColor,
+		metallic,
+		roughness,
+		m_albedoTextures.empty() ? materialTable.addTexture(resource::defaultTexture()) : materialTable.addTextures(m_albedoTextures),
+		m_albedoTextures.empty() ? 1 : static_cast<uint32>(m_albedoTextures.size()),
+		textureIndex(m_normalMapTexture, resource::defaultNormal()),
+		textureIndex(m_displacementMapTexture, resource::defaultTexture()),
+		textureIndex(m_metallicTexture, resource::defaultTexture()),
+		textureIndex(m_specularTexture, resource::defaultTexture()),
+		textureIndex(m_emissionTexture, resource::defaultTexture()),
+		textureIndex(m_occlusionMapTexture, resource::defaultTexture())
 	};
 
-	for (uint32 i = 0; i < config::maxFramesInFlight; i++) {
-		m_fragShaderBuffers[i] = vulkan::GPUBuffer(sizeof(FragmentShaderData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
-		m_fragShaderBuffers[i].copyData(&fragDat);
-
-		m_descriptorSets.addWrites({
-			{ { m_fragShaderBuffers[i].getDescriptorBufferInfo() }, 6, lyra::vulkan::DescriptorSets::Type::uniformBuffer}
-		});
-	}
-
-	lsd::Vector<VkDescriptorImageInfo> albedoImageInfos(m_albedoTextures.size());
-
-	for (uint32 i = 0; i < m_albedoTextures.size(); i++) {
-		albedoImageInfos[i] = m_albedoTextures[i]->getDescriptorImageInfo();
-	}
-
-	m_descriptorSets.addWrites({
-		{ 
-			{ m_normalMapTexture ? m_normalMapTexture->getDescriptorImageInfo() : resource::defaultNormal().getDescriptorImageInfo() }, 
-			0, 
-			lyra::vulkan::DescriptorSets::Type::imageSampler
-		},
-		{ 
-			{ m_specularTexture ? m_specularTexture->getDescriptorImageInfo() : resource::defaultTexture().getDescriptorImageInfo() }, 
-			1, 
-			lyra::vulkan::DescriptorSets::Type::imageSampler
-		},
-		{ 
-			{ m_displacementMapTexture ? m_displacementMapTexture->getDescriptorImageInfo() : resource::defaultTexture().getDescriptorImageInfo() }, 
-			2, 
-			lyra::vulkan::DescriptorSets::Type::imageSampler
-		},
-		{ 
-			{ m_metallicTexture ? m_metallicTexture->getDescriptorImageInfo() : resource::defaultTexture().getDescriptorImageInfo() }, 
-			3, 
-			lyra::vulkan::DescriptorSets::Type::imageSampler
-		},
-		{ 
-			{ m_emissionTexture ? m_emissionTexture->getDescriptorImageInfo() : resource::defaultTexture().getDescriptorImageInfo() }, 
-			4, 
-			lyra::vulkan::DescriptorSets::Type::imageSampler
-		},
-		{ 
-			{ m_occlusionMapTexture ? m_occlusionMapTexture->getDescriptorImageInfo() : resource::defaultTexture().getDescriptorImageInfo() }, 
-			5, 
-			lyra::vulkan::DescriptorSets::Type::imageSampler
-		},
-		{ 
-			albedoImageInfos.empty() ? lsd::Vector<VkDescriptorImageInfo> { resource::defaultTexture().getDescriptorImageInfo() } : albedoImageInfos, 
-			7, 
-			lyra::vulkan::DescriptorSets::Type::imageSampler
-		}
-	});
+	m_index = materialTable.add(m_data);
+}
+
+Material::~Material() {
+	if (!renderer::globalRenderSystem || !renderer::globalRenderSystem->materialTable) return;
+
+	auto& materialTable = *renderer::globalRenderSystem->materialTable;
+
+	materialTable.remove(m_index);
+
+	materialTable.releaseTextures(m_data.albedoTexture);
+	materialTable.releaseTextures(m_data.normalMapTexture);
+	materialTable.releaseTextures(m_data.displacementMapTexture);
+	materialTable.releaseTextures(m_data.metallicTexture);
+	materialTable.releaseTextures(m_data.specularTexture);
+	materialTable.releaseTextures(m_data.emissionTexture);
+	materialTable.releaseTextures(m_data.occlusionMapTexture);
+}
+
+void Material::setAlbedoColor(const Color& color) {
+	m_data.albedoColor = color;
+	update();
+}
+
+void Material::setEmissionColor(const Color& color) {
+	m_data.emissionColor = color;
+	update();
+}
+
+void Material::setSpecularColor(const Color& color) {
+	m_data.specularColor = color;
+	update();
+}
+
+void Material::setOcclusionColor(const Color& color) {
+	m_data.occlusionColor = color;
+	update();
+}
+
+void Material::setMetallic(float32 metallic) {
+	m_data.metallic = metallic;
+	update();
+}
+
+void Material::setRoughness(float32 roughness) {
+	m_data.roughness = roughness;
+	update();
+}
+
+void Material::update() {
+	renderer::globalRenderSystem->materialTable->set(m_index, m_data);
 }
 
 } // namespace lyra
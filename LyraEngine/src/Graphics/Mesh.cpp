@@ -0,0 +1,143 @@
+#include <Graphics/Mesh.h>
+#include <Graphics/VulkanRenderSystem.h>
+
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace lyra {
+
+namespace renderer {
+
+extern vulkan::RenderSystem* globalRenderSystem;
+
+}
+
+namespace {
+
+// components of the extent which are zero would divide by zero, every position has the center value in them anyway
+glm::vec3 quantizationScale(const BoundingVolume& bounds) {
+	return glm::vec3(
+		(bounds.extent.x > 0.0f) ? bounds.extent.x : 1.0f,
+		(bounds.extent.y > 0.0f) ? bounds.extent.y : 1.0f,
+		(bounds.extent.z > 0.0f) ? bounds.extent.z : 1.0f
+	);
+}
+
+// maps the sphere onto an octahedron and unfolds its lower half into the corners of the square
+glm::vec2 encodeOctahedral(const glm::vec3& normal) {
+	auto length = glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z);
+	if (length == 0.0f) return glm::vec2(0.0f);
+
+	auto encoded = glm::vec2(normal) / length;
+
+	if (normal.z < 0.0f) {
+		encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * glm::vec2(
+			(encoded.x >= 0.0f) ? 1.0f : -1.0f,
+			(encoded.y >= 0.0f) ? 1.0f : -1.0f
+		);
+	}
+
+	return encoded;
+}
+
+glm::vec3 decodeOctahedral(const glm::vec2& encoded) {
+	glm::vec3 normal(encoded, 1.0f - glm::abs(encoded.x) - glm::abs(encoded.y));
+	auto t = glm::max(-normal.z, 0.0f);
+
+	normal.x += (normal.x >= 0.0f) ? -t : t;
+	normal.y += (normal.y >= 0.0f) ? -t : t;
+
+	return glm::normalize(normal);
+}
+
+int16 packSnorm16(float32 value) {
+	return static_cast<int16>(glm::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+float32 unpackSnorm16(int16 value) {
+	return glm::max(static_cast<float32>(value) / 32767.0f, -1.0f);
+}
+
+}
+
+Mesh::PackedVertex Mesh::pack(const Vertex& vertex, const BoundingVolume& bounds) {
+	PackedVertex packed { };
+
+	if constexpr (config::vertexPositionFormat == config::VertexPositionFormat::float32) {
+		packed.pos = vertex.pos;
+	} else if constexpr (config::vertexPositionFormat == config::VertexPositionFormat::float16) {
+		packed.pos = glm::u16vec4(glm::packHalf1x16(vertex.pos.x), glm::packHalf1x16(vertex.pos.y), glm::packHalf1x16(vertex.pos.z), 0);
+	} else {
+		auto quantized = (vertex.pos - bounds.center) / quantizationScale(bounds);
+		packed.pos = glm::i16vec4(packSnorm16(quantized.x), packSnorm16(quantized.y), packSnorm16(quantized.z), 0);
+	}
+
+	auto normal = encodeOctahedral(vertex.normal);
+	packed.normal = glm::i16vec2(packSnorm16(normal.x), packSnorm16(normal.y));
+
+	if constexpr (config::vertexColorFormat == config::VertexColorFormat::float32) {
+		packed.color = vertex.color;
+	} else {
+		auto color = glm::round(glm::clamp(vertex.color, 0.0f, 1.0f) * 255.0f);
+		packed.color = glm::u8vec4(color.x, color.y, color.z, 255);
+	}
+
+	if constexpr (config::vertexTexCoordFormat == config::VertexTexCoordFormat::float32) {
+		packed.uvw = vertex.uvw;
+	} else {
+		packed.uvw = glm::u16vec4(glm::packHalf1x16(vertex.uvw.x), glm::packHalf1x16(vertex.uvw.y), glm::packHalf1x16(vertex.uvw.z), 0);
+	}
+
+	return packed;
+}
+
+lsd::Vector<Mesh::PackedVertex> Mesh::pack(const lsd::Vector<Vertex>& vertices, const BoundingVolume& bounds) {
+	lsd::Vector<PackedVertex> packed;
+	packed.reserve(vertices.size());
+
+	for (const auto& vertex : vertices) packed.pushBack(pack(vertex, bounds));
+
+	return packed;
+}
+
+Mesh::Vertex Mesh::unpack(const PackedVertex& packed, const BoundingVolume& bounds) {
+	Vertex vertex;
+
+	if constexpr (config::vertexPositionFormat == config::VertexPositionFormat::float32) {
+		vertex.pos = packed.pos;
+	} else if constexpr (config::vertexPositionFormat == config::VertexPositionFormat::float16) {
+		vertex.pos = glm::vec3(glm::unpackHalf1x16(packed.pos.x), glm::unpackHalf1x16(packed.pos.y), glm::unpackHalf1x16(packed.pos.z));
+	} else {
+		vertex.pos = bounds.center + glm::vec3(unpackSnorm16(packed.pos.x), unpackSnorm16(packed.pos.y), unpackSnorm16(packed.pos.z)) * quantizationScale(bounds);
+	}
+
+	vertex.normal = decodeOctahedral(glm::vec2(unpackSnorm16(packed.normal.x), unpackSnorm16(packed.normal.y)));
+
+	if constexpr (config::vertexColorFormat == config::VertexColorFormat::float32) {
+		vertex.color = packed.color;
+	} else {
+		vertex.color = glm::vec3(packed.color) / 255.0f;
+	}
+
+	if constexpr (config::vertexTexCoordFormat == config::VertexTexCoordFormat::float32) {
+		vertex.uvw = packed.uvw;
+	} else {
+		vertex.uvw = glm::vec3(glm::unpackHalf1x16(packed.uvw.x), glm::unpackHalf1x16(packed.uvw.y), glm::unpackHalf1x16(packed.uvw.z));
+	}
+
+	return vertex;
+}
+
+glm::mat4 Mesh::dequantization() const noexcept {
+	if constexpr (config::vertexPositionFormat == config::VertexPositionFormat::snorm16) {
+		return glm::scale(glm::translate(glm::mat4(1.0f), m_bounds.center), quantizationScale(m_bounds));
+	} else {
+		return glm::mat4(1.0f);
+	}
+}
+
+Mesh::~Mesh() {
+	if (renderer::globalRenderSystem && renderer::globalRenderSystem->geometryBuffer) renderer::globalRenderSystem->geometryBuffer->remove(*this);
+}
+
+} // namespace lyra
@@ -9,6 +9,11 @@
 #include <Components/Camera.h>
 #include <Components/MeshRenderer.h>
 
+#include <Math/Culling.h>
+
+#include <cmath>
+#include <limits>
+
 namespace lyra {
 
 namespace renderer {
@@ -16,6 +21,131 @@ namespace renderer {
 extern Window* globalWindow;
 extern vulkan::RenderSystem* globalRenderSystem;
 
+namespace {
+
+// all renderers of a mesh using the same material, the instances of all groups are stored contiguously in the order of the groups
+struct InstanceGroup {
+	const Mesh* mesh;
+	vulkan::GeometryBuffer::Range geometry;
+	uint32 firstInstance;
+	uint32 instanceCount;
+};
+
+struct MaterialGroup {
+	const vulkan::GraphicsPipeline* graphicsPipeline;
+	uint32 material;
+	uint32 firstGroup;
+	uint32 groupCount;
+};
+
+// the visible meshes of all materials using a pipeline, which are drawn with a single indirect draw call containing one instanced draw per mesh
+// the materials are indexed by the instances, so the batch does not need to bind anything besides the pipeline and the index type of its meshes
+struct DrawBatch {
+	const vulkan::GraphicsPipeline* graphicsPipeline;
+	VkIndexType indexType;
+	uint32 firstDraw;
+	uint32 drawCount;
+};
+
+// radius in pixels of a world space sphere projected by the camera, infinite if the camera is inside of it
+float32 projectedRadius(const glm::vec4& sphere, const Camera::TransformData& cameraData, float32 viewportHeight) {
+	auto center = glm::vec3(cameraData.view * glm::vec4(glm::vec3(sphere), 1.0f));
+	auto squaredDistance = glm::dot(center, center) - sphere.w * sphere.w;
+
+	if (squaredDistance <= 0.0f) return std::numeric_limits<float32>::infinity();
+
+	// the second diagonal element of the projection is the cotangent of half the vertical field of view
+	return sphere.w / std::sqrt(squaredDistance) * cameraData.proj[1][1] * viewportHeight * 0.5f;
+}
+
+// the coarsest level whose error stays below the pixel threshold on screen
+// levels coarser than the current one have to pass a lower threshold, finer ones a higher one, so the level does not change back and forth at the boundary
+uint32 selectLod(const lsd::Vector<Mesh::Lod>& lods, float32 radius, uint32 current) {
+	uint32 lod = 0;
+
+	for (uint32 i = 1; i < lods.size(); i++) {
+		auto threshold = config::lodPixelError * ((i > current) ? (1.0f - config::lodHysteresis) : (1.0f + config::lodHysteresis));
+		if (lods[i].error * radius > threshold) break;
+
+		lod = i;
+	}
+
+	return lod;
+}
+
+// only binds state which differs from the previous batch
+void recordBatches(
+	const vulkan::CommandQueue::CommandBuffer& commandBuffer, 
+	const Camera::TransformData& cameraData, 
+	const lsd::Vector<DrawBatch>& batches, 
+	size_type first, 
+	size_type last
+) {
+	auto renderSystem = renderer::globalRenderSystem;
+
+	const vulkan::GraphicsPipeline* boundPipeline = nullptr;
+	auto boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+	auto frame = currentFrameIndex();
+	const auto& instances = renderSystem->instanceBuffer->frames[frame];
+
+	// without these features every draw command is read back from the mapped buffer and issued from the CPU
+	bool multiDraw = renderSystem->deviceFeatures.multiDrawIndirect && renderSystem->deviceFeatures.drawIndirectFirstInstance;
+	auto maxDrawCount = multiDraw ? renderSystem->deviceProperties.limits.maxDrawIndirectCount : 1;
+
+	for (auto i = first; i < last; i++) {
+		const auto& batch = batches[i];
+
+		if (batch.indexType != boundIndexType) {
+			renderSystem->geometryBuffer->bind(commandBuffer, batch.indexType);
+			boundIndexType = batch.indexType;
+		}
+
+		if (batch.graphicsPipeline != boundPipeline) {
+			batch.graphicsPipeline->bind(commandBuffer);
+			renderSystem->instanceBuffer->bind(frame, commandBuffer, *batch.graphicsPipeline->program);
+			renderSystem->materialTable->bind(frame, commandBuffer, *batch.graphicsPipeline->program);
+
+			commandBuffer.pushConstants(
+				batch.graphicsPipeline->program->pipelineLayout,
+				VK_SHADER_STAGE_VERTEX_BIT,
+				0,
+				sizeof(Camera::TransformData),
+				&cameraData
+			);
+
+			boundPipeline = batch.graphicsPipeline;
+		}
+
+		if (multiDraw) {
+			for (uint32 draw = 0; draw < batch.drawCount; draw += maxDrawCount) {
+				commandBuffer.drawIndexedIndirect(
+					instances.drawBuffer.buffer,
+					(batch.firstDraw + draw) * sizeof(VkDrawIndexedIndirectCommand),
+					std::min(batch.drawCount - draw, maxDrawCount),
+					sizeof(VkDrawIndexedIndirectCommand)
+				);
+			}
+		} else {
+			for (uint32 draw = batch.firstDraw; draw < batch.firstDraw + batch.drawCount; draw++) {
+				const auto& command = instances.draws[draw];
+				commandBuffer.drawIndexed(command.indexCount, command.instanceCount, command.firstIndex, command.vertexOffset, command.firstInstance);
+			}
+		}
+	}
+}
+
+// the hash of a builder only selects a candidate, if it belongs to a different builder the next key in the probe sequence is tried
+template <class Map, class Builder> uint64 findKey(const Map& map, const Builder& builder) {
+	auto key = builder.hash();
+
+	for (auto it = map.find(key); it != map.end() && it->second->builder != builder; it = map.find(key)) key = hashCombine(key, 1);
+
+	return key;
+}
+
+}
+
 void beginFrame() {
 	// calculate deltatime
 	auto now = std::chrono::high_resolution_clock::now();
@@ -27,32 +157,190 @@ void beginFrame() {
 		beginFrame();
 		return;
 	}
+	if (renderer::globalRenderSystem->commandRecorder) {
+		renderer::globalRenderSystem->commandRecorder->reset(renderer::globalRenderSystem->swapchain->currentFrame);
+	}
+	// the fence of the frame was waited on while aquiring, so none of its transient descriptor sets are in use anymore
+	renderer::globalRenderSystem->transientDescriptorPools->reset(renderer::globalRenderSystem->swapchain->currentFrame);
+	// the same holds for the geometry of the meshes which were destroyed during the previous use of the frame
+	renderer::globalRenderSystem->geometryBuffer->retire(renderer::globalRenderSystem->swapchain->currentFrame);
 	renderer::globalRenderSystem->swapchain->begin();
 	renderer::globalRenderSystem->commandQueue->activeCommandBuffer->begin();
 }
 
 void endFrame() {
 	renderer::globalRenderSystem->commandQueue->activeCommandBuffer->end();
+	// uploads recorded during the frame are submitted ahead of it, so they are visible to its draw calls
+	renderer::globalRenderSystem->uploadQueue->flush();
 	renderer::globalRenderSystem->commandQueue->submit(renderer::globalRenderSystem->swapchain->renderFinishedFences[renderer::globalRenderSystem->swapchain->currentFrame]);
 	renderer::globalRenderSystem->swapchain->present();
 	renderer::globalRenderSystem->swapchain->update(renderer::globalWindow->changed);
 }
 
 void draw() {
-	auto& renderTargets = renderer::globalRenderSystem->renderTargets;
-	auto& cameras = renderer::globalRenderSystem->cameras;
-	auto& materials = renderer::globalRenderSystem->materials;
-	auto& meshRenderers = renderer::globalRenderSystem->meshRenderers;
+	auto renderSystem = renderer::globalRenderSystem;
 
-	auto cmd = renderer::globalRenderSystem->commandQueue->activeCommandBuffer;
+	auto cmd = renderSystem->commandQueue->activeCommandBuffer;
+	auto frame = currentFrameIndex();
 
-	for (uint32 i = 0; i < renderTargets.size(); i++) {
-		renderTargets[i]->begin();
+	// the scene is flattened once per frame, the pipelines are the keys of the map, so materials sharing a pipeline are adjacent
+	static lsd::Vector<MaterialGroup> materialGroups;
+	static lsd::Vector<InstanceGroup> instanceGroups;
+	static lsd::Vector<glm::mat4> transforms;
+	static lsd::Vector<MeshRenderer*> instanceRenderers;
+	static CullingVolumes volumes;
 
-		for (uint32 j = 0; j < cameras.size(); j++) {
-			auto camera = cameras[j];
-			
-			for (auto& [graphicsPipeline, material] : materials) {
+	materialGroups.clear();
+	instanceGroups.clear();
+	transforms.clear();
+	instanceRenderers.clear();
+	volumes.clear();
+
+	for (auto& [graphicsPipeline, materials] : renderSystem->materials) {
+		// pipelines still compiling in the background without a compatible fallback are not drawn yet
+		if (!graphicsPipeline->drawable()) continue;
+
+		for (auto material : materials) {
+			const auto& meshRenderers = renderSystem->meshRenderers[material];
+			if (meshRenderers.empty()) continue;
+
+			materialGroups.pushBack({ graphicsPipeline, material->m_index, static_cast<uint32>(instanceGroups.size()), static_cast<uint32>(meshRenderers.size()) });
+
+			// meshes with 16 bit indices come first, so the draws of a material change the index type at most once
+			for (auto indexType : { VK_INDEX_TYPE_UINT16, VK_INDEX_TYPE_UINT32 }) {
+				for (const auto& [mesh, renderers] : meshRenderers) {
+					if (mesh->indexType() != indexType) continue;
+
+					instanceGroups.pushBack({ mesh, renderers.front()->geometry(), static_cast<uint32>(transforms.size()), static_cast<uint32>(renderers.size()) });
+
+					for (auto meshRenderer : renderers) {
+						const auto& global = meshRenderer->entity->component<etcs::Transform>().globalTransform();
+
+						// quantized positions are scaled back into the space of the mesh before the model transform
+						transforms.pushBack(global * mesh->dequantization());
+						instanceRenderers.pushBack(meshRenderer);
+						volumes.pushBack(mesh->bounds(), global);
+					}
+				}
+			}
+		}
+	}
+
+	// every camera gets its own batches, since every camera sees a different set of instances
+	static lsd::Vector<DrawBatch> batches;
+	static lsd::Vector<uint32> cameraBatches;
+	static lsd::Vector<uint32> visible;
+	static lsd::Vector<uint32> visibleLods;
+
+	batches.clear();
+	cameraBatches.clear();
+
+	// the previous use of this frame's buffers has finished, since the frame's fence was waited on while aquiring
+	renderSystem->instanceBuffer->reserve(frame, static_cast<uint32>(transforms.size() * renderSystem->cameras.size()));
+	renderSystem->materialTable->update(frame);
+	auto& instances = renderSystem->instanceBuffer->frames[frame];
+
+	uint32 drawCount = 0;
+	uint32 instanceCount = 0;
+
+	auto cameraCount = static_cast<uint32>(renderSystem->cameras.size());
+
+	for (uint32 c = 0; c < cameraCount; c++) {
+		auto camera = renderSystem->cameras[c];
+		cameraBatches.pushBack(static_cast<uint32>(batches.size()));
+
+		volumes.cull(camera->frustum(), visible);
+
+		auto cameraData = camera->data();
+		auto viewportHeight = camera->viewportSize.y * drawHeight();
+
+		// the visible indices are ascending, just like the instance ranges of the groups
+		size_type v = 0;
+
+		auto appendBatch = [&](const vulkan::GraphicsPipeline* graphicsPipeline, VkIndexType indexType, uint32 firstDraw) {
+			if (drawCount == firstDraw) return;
+
+			// materials sharing a pipeline are adjacent, so their draws can be appended to the batch of the previous material
+			if (batches.size() > cameraBatches.back() && batches.back().graphicsPipeline == graphicsPipeline && batches.back().indexType == indexType) {
+				batches.back().drawCount += drawCount - firstDraw;
+			} else {
+				batches.pushBack({ graphicsPipeline, indexType, firstDraw, drawCount - firstDraw });
+			}
+		};
+
+		for (const auto& materialGroup : materialGroups) {
+			auto firstDraw = drawCount;
+			auto indexType = VK_INDEX_TYPE_UINT16;
+
+			for (auto group = materialGroup.firstGroup; group < materialGroup.firstGroup + materialGroup.groupCount; group++) {
+				const auto& instanceGroup = instanceGroups[group];
+				const auto& lods = instanceGroup.mesh->lods();
+
+				if (instanceGroup.geometry.indexType != indexType) {
+					appendBatch(materialGroup.graphicsPipeline, indexType, firstDraw);
+
+					firstDraw = drawCount;
+					indexType = instanceGroup.geometry.indexType;
+				}
+
+				visibleLods.clear();
+				auto firstVisible = v;
+
+				for (; v < visible.size() && visible[v] < instanceGroup.firstInstance + instanceGroup.instanceCount; v++) {
+					// a camera the renderer was not visible to before starts at the original mesh
+					auto& selected = instanceRenderers[visible[v]]->m_lods[camera];
+
+					selected = selectLod(lods, projectedRadius(volumes.sphere(visible[v]), cameraData, viewportHeight), selected);
+					visibleLods.pushBack(selected);
+				}
+
+				// every level of detail is a separate draw of the instances which selected it
+				for (uint32 lod = 0; lod < lods.size(); lod++) {
+					auto firstInstance = instanceCount;
+
+					for (auto i = firstVisible; i < v; i++) {
+						if (visibleLods[i - firstVisible] == lod) instances.instances[instanceCount++] = { transforms[visible[i]], materialGroup.material };
+					}
+
+					if (instanceCount != firstInstance) {
+						instances.draws[drawCount++] = {
+							lods[lod].indexCount, 
+							instanceCount - firstInstance, 
+							instanceGroup.geometry.firstIndex + lods[lod].firstIndex, 
+							instanceGroup.geometry.vertexOffset, 
+							firstInstance
+						};
+					}
+				}
+			}
+
+			appendBatch(materialGroup.graphicsPipeline, indexType, firstDraw);
+		}
+	}
+
+	cameraBatches.pushBack(static_cast<uint32>(batches.size()));
+
+	renderSystem->instanceBuffer->flush(frame, instanceCount);
+
+	// pushed here instead of when binding, since the workers may not modify the command queue
+	renderSystem->commandQueue->pipelineStageFlags.pushBack(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+	bool parallel = renderSystem->commandRecorder && drawCount >= config::drawsPerCommandBuffer;
+
+	// the render targets are begun even if everything was culled, since their render passes transition and clear the swapchain images before presenting
+	for (auto renderTarget : renderSystem->renderTargets) {
+		renderTarget->begin(parallel ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+
+		for (uint32 c = 0; c < renderSystem->cameras.size(); c++) {
+			auto camera = renderSystem->cameras[c];
+			auto cameraData = camera->data();
+
+			auto firstBatch = cameraBatches[c];
+			auto batchCount = cameraBatches[c + 1] - firstBatch;
+			if (batchCount == 0) continue;
+
+			// the dynamic state is written before recording, so the workers only ever read it
+			for (auto& [graphicsPipeline, materials] : renderSystem->materials) {
 				if (std::holds_alternative<VkViewport>(graphicsPipeline->dynamicViewport)) {
 					graphicsPipeline->dynamicViewport = VkViewport {
 						0.0f,
@@ -76,35 +364,25 @@ void draw() {
 						},
 					};
 				}
-				
-				graphicsPipeline->bind();
-				
-				for (auto& [material, meshes] : meshRenderers) {
-					
-					material->m_descriptorSets.bind(currentFrameIndex());
-					
-					for (uint32 i = 0; i < meshes.size(); i++) {
-						auto mesh = meshes[i];
-						
-						auto data = camera->data(mesh->entity->component<etcs::Transform>().globalTransform());
-						
-						cmd->pushConstants(
-						   material->m_graphicsPipeline->program->pipelineLayout,
-						   VK_SHADER_STAGE_VERTEX_BIT,
-						   0,
-						   sizeof(Camera::TransformData),
-						   &data
-						);
-						
-						cmd->bindVertexBuffer(mesh->m_vertexBuffer.buffer, 0, 0);
-						cmd->bindIndexBuffer(mesh->m_indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-						cmd->drawIndexed(static_cast<uint32>(mesh->m_mesh->indices().size()), 1, 0, 0, 0);
+			}
+
+			if (parallel) {
+				renderSystem->commandRecorder->record(
+					renderTarget->inheritanceInfo(), 
+					batchCount, 
+					std::max<size_type>(batches.size() * config::drawsPerCommandBuffer / drawCount, 1), 
+					[&cameraData, firstBatch](const vulkan::CommandQueue::CommandBuffer& commandBuffer, size_type first, size_type last) {
+						recordBatches(commandBuffer, cameraData, batches, firstBatch + first, firstBatch + last);
 					}
-				}
+				);
+			} else {
+				recordBatches(*cmd, cameraData, batches, firstBatch, firstBatch + batchCount);
 			}
 		}
 
-		renderTargets[i]->end();
+		if (parallel) renderSystem->commandRecorder->execute(*cmd);
+
+		renderTarget->end();
 	}
 }
 
@@ -143,8 +421,10 @@ void setScene(etcs::Entity& sceneRoot) {
 			
 			if (entityHandle.contains<MeshRenderer>()) {
 				auto& m = entityHandle.component<MeshRenderer>();
-				renderer::globalRenderSystem->materials[m.m_material->m_graphicsPipeline].pushBack(m.m_material);
-				renderer::globalRenderSystem->meshRenderers[m.m_material].pushBack(&m);
+				auto& meshRenderers = renderer::globalRenderSystem->meshRenderers[m.m_material];
+				// every material is only listed once for its pipeline
+				if (meshRenderers.empty()) renderer::globalRenderSystem->materials[m.m_material->m_graphicsPipeline].pushBack(m.m_material);
+				meshRenderers[m.m_mesh].pushBack(&m);
 			}
 
 			func(entityHandle, func);
@@ -165,27 +445,44 @@ vulkan::GraphicsPipeline& graphicsPipeline(
 ) {
 	auto renderSystem = renderer::globalRenderSystem;
 
-	auto pipelineHash = pipelineBuilder.hash();
+	// the program is resolved first, since the pipeline is identified by the program it uses
+	auto programKey = findKey(renderSystem->graphicsPrograms, programBuilder);
+	auto program = renderSystem->graphicsPrograms.find(programKey);
 
-	if (!renderSystem->graphicsPipelines.contains(pipelineHash)) {
-		auto programHash = programBuilder.hash();
+	if (program == renderSystem->graphicsPrograms.end()) {
+		program = renderSystem->graphicsPrograms.emplace(programKey, new vulkan::GraphicsProgram(programBuilder)).first;
+	}
 
-		if (!renderSystem->graphicsPrograms.contains(programHash)) {
-			vulkan::GraphicsPipeline::Builder modifiedPipelineBuilder = pipelineBuilder;
-			modifiedPipelineBuilder.setGraphicsProgram(
-				*renderSystem->graphicsPrograms.emplace(
-					programHash, 
-					new vulkan::GraphicsProgram(programBuilder)
-				).first->second
-			);
+	vulkan::GraphicsPipeline::Builder modifiedPipelineBuilder = pipelineBuilder;
+	modifiedPipelineBuilder.setGraphicsProgram(*program->second);
 
-			return *renderSystem->graphicsPipelines.emplace(pipelineHash, new vulkan::GraphicsPipeline(modifiedPipelineBuilder)).first->second;
-		}
+	auto pipelineKey = findKey(renderSystem->graphicsPipelines, modifiedPipelineBuilder);
+	auto pipeline = renderSystem->graphicsPipelines.find(pipelineKey);
 
-		return *renderSystem->graphicsPipelines.emplace(pipelineHash, new vulkan::GraphicsPipeline(pipelineBuilder)).first->second;
+	if (pipeline == renderSystem->graphicsPipelines.end()) {
+		pipeline = renderSystem->graphicsPipelines.emplace(
+			pipelineKey, 
+			new vulkan::GraphicsPipeline(modifiedPipelineBuilder, renderSystem->pipelineWorkers, renderSystem->defaultGraphicsPipeline)
+		).first;
 	}
 
-	return *renderSystem->graphicsPipelines.at(pipelineHash);
+	return *pipeline->second;
+}
+
+void prewarmGraphicsPipelines(const lsd::Vector<PipelineVariant>& manifest) {
+	for (const auto& variant : manifest) {
+		static_cast<void>(graphicsPipeline(variant.pipelineBuilder, variant.programBuilder));
+	}
+}
+
+uint32 compilingGraphicsPipelines() {
+	uint32 count = 0;
+
+	for (const auto& [hash, pipeline] : renderer::globalRenderSystem->graphicsPipelines) {
+		if (!pipeline->compiled()) count++;
+	}
+
+	return count;
 }
 
 } // namespace renderer
@@ -203,7 +500,12 @@ void initRenderSystem(
 }
 
 void quitRenderSystem() {
-	if (renderer::globalRenderSystem) vkDeviceWaitIdle(renderer::globalRenderSystem->device);
+	if (renderer::globalRenderSystem) {
+		renderer::globalRenderSystem->uploadQueue->wait();
+		vkDeviceWaitIdle(renderer::globalRenderSystem->device);
+		renderer::globalRenderSystem->pipelineWorkers.wait();
+		renderer::globalRenderSystem->savePipelineCache();
+	}
 }
 
 } // namespace lyra
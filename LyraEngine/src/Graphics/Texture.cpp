@@ -4,16 +4,51 @@
 
 namespace lyra {
 
+namespace renderer {
+
+extern vulkan::RenderSystem* globalRenderSystem;
+
+}
+
+namespace {
+
+vulkan::Image::Format imageFormat(resource::TextureFormat format, Texture::Type type) {
+	using vulkan::Image;
+
+	// only color textures are stored in sRGB, all other types contain linear data
+	bool srgb = (type == Texture::Type::texture);
+
+	switch (format) {
+		case resource::TextureFormat::bc1:
+			return srgb ? Image::Format::bc1RGBASRGBBlock : Image::Format::bc1RGBAUNormBlock;
+		case resource::TextureFormat::bc3:
+			return srgb ? Image::Format::bc3SRGBBlock : Image::Format::bc3UNormBlock;
+		case resource::TextureFormat::bc4:
+			return Image::Format::bc4UNormBlock;
+		case resource::TextureFormat::bc5:
+			return Image::Format::bc5UNormBlock;
+		case resource::TextureFormat::bc7:
+			return srgb ? Image::Format::bc7SRGBBlock : Image::Format::bc7UNormBlock;
+		default:
+			return srgb ? Image::Format::r8g8b8a8SRGB : Image::Format::r8g8b8a8UNorm;
+	}
+}
+
+}
+
 Texture::Texture(const resource::TextureFile& imageData, vulkan::Image::Format format) : 
 	m_type(static_cast<Type>(imageData.type)),
 	m_width(imageData.width), 
 	m_height(imageData.height)
 {
+	if (format == vulkan::Image::Format::max) format = imageFormat(imageData.format, m_type);
+
 	{
-		// create a staging buffer
-		vulkan::GPUBuffer stagingBuffer(m_width * m_height * 4, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
-		// copy the image data into the staging buffer
-		stagingBuffer.copyData(imageData.data.data());
+		auto mipmap = std::max(imageData.mipmap, 1U);
+
+		// files built by older versions only contain the base level, the rest of the chain is then generated on the GPU
+		bool precomputedMipmaps = imageData.data.size() >= resource::textureSize(imageData.format, m_width, m_height, mipmap);
+		auto uploadedLevels = precomputedMipmaps ? mipmap : 1U;
 
 		// extent (size) of the image
 		VkExtent3D imageExtent = { m_width, m_height, 1 };
@@ -23,31 +58,56 @@ Texture::Texture(const resource::TextureFile& imageData, vulkan::Image::Format f
 			m_image.imageCreateInfo(
 				format, 
 				imageExtent,
-				VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-				imageData.mipmap,
+				VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | (precomputedMipmaps ? 0 : VK_IMAGE_USAGE_TRANSFER_SRC_BIT),
+				mipmap,
 				static_cast<vulkan::Image::Type>(imageData.dimension)
 			),
 			m_memory.getAllocCreateInfo(VMA_MEMORY_USAGE_GPU_ONLY),
 			m_memory.memory
 		);
 
-		// convert the image layout and copy it from the buffer
-		m_image.transitionLayout(vulkan::Image::Layout::undefined, vulkan::Image::Layout::transferDst, { VK_IMAGE_ASPECT_COLOR_BIT, 0, imageData.mipmap, 0, 1 });
-		m_image.copyFromBuffer(stagingBuffer, imageExtent);
+		// one copy region per mip level, the levels are tightly packed in the staging buffer
+		lsd::Vector<VkBufferImageCopy> regions;
+		regions.reserve(uploadedLevels);
+
+		for (uint32 i = 0, offset = 0; i < uploadedLevels; i++) {
+			auto levelWidth = std::max(m_width >> i, 1U), levelHeight = std::max(m_height >> i, 1U);
 
-		// generate the mipmaps
-		if (imageData.mipmap != 0) {
+			regions.pushBack({
+				offset,
+				0,
+				0,
+				{ VK_IMAGE_ASPECT_COLOR_BIT, i, 0, 1 },
+				{ 0, 0, 0 },
+				{ levelWidth, levelHeight, 1 }
+			});
+
+			offset += static_cast<uint32>(resource::textureLevelSize(imageData.format, levelWidth, levelHeight));
+		}
+
+		auto& uploadQueue = *renderer::globalRenderSystem->uploadQueue;
+
+		// queue the copy of the image data, the layout is only left in transfer destination if the mipmaps still have to be generated
+		uploadQueue.copy(
+			m_image,
+			imageData.data.data(),
+			resource::textureSize(imageData.format, m_width, m_height, uploadedLevels),
+			regions,
+			{ VK_IMAGE_ASPECT_COLOR_BIT, 0, mipmap, 0, 1 },
+			precomputedMipmaps ? vulkan::Image::Layout::shaderReadOnly : vulkan::Image::Layout::transferDst
+		);
+
+		if (!precomputedMipmaps) {
 			// check if image supports linear filtering
-			ASSERT(m_image.formatProperties().optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT, "Image does not support linear filtering with its current format!\n");
+			ASSERT(m_image.formatProperties(format).optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT, "Image does not support linear filtering with its current format!\n");
 
-			// temporary command buffer for generating midmaps
-			vulkan::CommandQueue cmdQueue;
-			cmdQueue.oneTimeBegin();
+			// the mipmaps are generated in the same batch as the copy
+			const auto& cmd = uploadQueue.commandBuffer();
 
 			int32 mipWidth = m_width, mipHeight = m_height;
 
-			for (uint32 i = 1; i < imageData.mipmap; i++) {
-				cmdQueue.activeCommandBuffer->pipelineBarrier(
+			for (uint32 i = 1; i < mipmap; i++) {
+				cmd.pipelineBarrier(
 					VK_PIPELINE_STAGE_TRANSFER_BIT,
 					VK_PIPELINE_STAGE_TRANSFER_BIT, 
 					0,
@@ -70,7 +130,7 @@ Texture::Texture(const resource::TextureFile& imageData, vulkan::Image::Format f
 					{ { 0, 0, 0 }, { (mipWidth > 1) ? mipWidth / 2 : 1, (mipHeight > 1) ? mipHeight / 2 : 1, 1 } }
 				};
 
-				cmdQueue.activeCommandBuffer->blitImage(
+				cmd.blitImage(
 					m_image.image, 
 					vulkan::Image::Layout::transferSrc, 
 					m_image.image, 
@@ -79,7 +139,7 @@ Texture::Texture(const resource::TextureFile& imageData, vulkan::Image::Format f
 					VK_FILTER_LINEAR
 				);
 
-				cmdQueue.activeCommandBuffer->pipelineBarrier(
+				cmd.pipelineBarrier(
 					VK_PIPELINE_STAGE_TRANSFER_BIT,
 					VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
 					0,
@@ -98,7 +158,7 @@ Texture::Texture(const resource::TextureFile& imageData, vulkan::Image::Format f
 				if (mipHeight > 1) mipHeight /= 2;
 			}
 
-			cmdQueue.activeCommandBuffer->pipelineBarrier(
+			cmd.pipelineBarrier(
 				VK_PIPELINE_STAGE_TRANSFER_BIT,
 				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
 				0,
@@ -109,11 +169,9 @@ Texture::Texture(const resource::TextureFile& imageData, vulkan::Image::Format f
 					vulkan::GPUMemory::Access::shaderRead,
 					vulkan::Image::Layout::transferDst,
 					vulkan::Image::Layout::shaderReadOnly,
-					{ VK_IMAGE_ASPECT_COLOR_BIT, imageData.mipmap - 1, 1, 0, 1 }
+					{ VK_IMAGE_ASPECT_COLOR_BIT, mipmap - 1, 1, 0, 1 }
 				)
 			);
-
-			cmdQueue.oneTimeSubmit();
 		}
 	}
 
@@ -133,4 +191,8 @@ Texture::Texture(const resource::TextureFile& imageData, vulkan::Image::Format f
 	);
 }
 
+Texture::~Texture() {
+	if (renderer::globalRenderSystem && renderer::globalRenderSystem->materialTable) renderer::globalRenderSystem->materialTable->removeTexture(*this);
+}
+
 } // namespace lyra
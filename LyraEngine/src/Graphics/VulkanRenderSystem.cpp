@@ -2,11 +2,14 @@
 
 #include <Common/Logger.h>
 #include <Common/Config.h>
+#include <Common/FileSystem.h>
+#include <Common/Hash.h>
 
 #include <Graphics/Renderer.h>
 #include <Graphics/Window.h>
 #include <Graphics/Material.h>
 #include <Graphics/Mesh.h>
+#include <Graphics/Texture.h>
 
 #include <Components/Camera.h>
 #include <Components/MeshRenderer.h>
@@ -21,8 +24,11 @@
 #include <LSD/String.h>
 
 #include <utility>
+#include <algorithm>
 #include <limits>
 #include <map>
+#include <fstream>
+#include <cstring>
 
 using namespace lsd::enum_operators;
 
@@ -62,6 +68,72 @@ constexpr void imguiVulkanAssert(VkResult r) {
 	vulkanAssert(r, "ImGUI Vulkan: Vulkan call failed with code: {}", r);
 }
 
+// layout of the pipeline cache file, followed by the data returned by vkGetPipelineCacheData
+struct PipelineCacheHeader {
+	static constexpr uint32 magic = 0x43504C59; // "LYPC"
+	static constexpr uint32 version = 1;
+
+	uint32 fileMagic;
+	uint32 fileVersion;
+	uint32 vendorID;
+	uint32 deviceID;
+	uint32 driverVersion;
+	uint32 padding;
+	uint64 dataSize;
+	uint64 dataHash;
+	uint8 pipelineCacheUUID[VK_UUID_SIZE];
+};
+
+// returns nothing if the file does not exist, is corrupt or was written with a different device or driver
+lsd::Vector<char> readPipelineCache(const std::filesystem::path& path, const VkPhysicalDeviceProperties& properties) {
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open()) return { };
+
+	auto fileSize = static_cast<size_type>(file.tellg());
+	file.seekg(0);
+
+	PipelineCacheHeader header { };
+	if (fileSize >= sizeof(PipelineCacheHeader)) file.read(reinterpret_cast<char*>(&header), sizeof(PipelineCacheHeader));
+
+	if (header.fileMagic != PipelineCacheHeader::magic || header.fileVersion != PipelineCacheHeader::version) {
+		log::warning("lyra::readPipelineCache(): The pipeline cache at path: {} has an invalid header or an unsupported version!", path.string());
+		return { };
+	}
+
+	if (
+		header.vendorID != properties.vendorID || 
+		header.deviceID != properties.deviceID || 
+		header.driverVersion != properties.driverVersion ||
+		std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0
+	) {
+		log::info("lyra::readPipelineCache(): The pipeline cache at path: {} was written by a different device or driver and will be rebuilt!", path.string());
+		return { };
+	}
+
+	if (header.dataSize != fileSize - sizeof(PipelineCacheHeader)) {
+		log::warning("lyra::readPipelineCache(): The pipeline cache at path: {} is truncated!", path.string());
+		return { };
+	}
+
+	lsd::Vector<char> data(header.dataSize);
+	file.read(data.data(), data.size());
+
+	if (!file || hashBytes(data.data(), data.size()) != header.dataHash) {
+		log::warning("lyra::readPipelineCache(): The pipeline cache at path: {} is corrupt!", path.string());
+		return { };
+	}
+
+	return data;
+}
+
+// only used on vulkan structures without padding, where comparing the bytes is the same as comparing every member
+template <class Ty> bool equalBytes(const Ty& first, const Ty& second) noexcept {
+	return std::memcmp(&first, &second, sizeof(Ty)) == 0;
+}
+template <class Ty> bool equalBytes(const lsd::Vector<Ty>& first, const lsd::Vector<Ty>& second) noexcept {
+	return first.size() == second.size() && (first.empty() || std::memcmp(first.data(), second.data(), first.size() * sizeof(Ty)) == 0);
+}
+
 }
 
 namespace renderer {
@@ -189,6 +261,7 @@ RenderSystem::RenderSystem(
 			VkPhysicalDeviceProperties properties;
 			VkPhysicalDeviceDescriptorIndexingPropertiesEXT descriptorIndexingProperties;
 			VkPhysicalDeviceFeatures features;
+			VkPhysicalDeviceVulkan12Features vulkan12Features;
 			QueueFamilies queueFamilies;
 		};
 
@@ -219,10 +292,16 @@ RenderSystem::RenderSystem(
 				localQueueFamilies.queueFamilyProperties.resize(queueFamilyCount);
 				vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, localQueueFamilies.queueFamilyProperties.data());
 
-				uint32 i = 0;
-				for (const auto& property : localQueueFamilies.queueFamilyProperties) {
+				// graphics and compute families always support transfers, even if they do not report it
+				constexpr auto supportsTransfer = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+				
+				uint32 asyncCopyFamilyIndex = std::numeric_limits<uint32>::max();
+
+				for (uint32 i = 0; i < localQueueFamilies.queueFamilyProperties.size(); i++) {
+					const auto& property = localQueueFamilies.queueFamilyProperties[i];
+
 					if (
-						localQueueFamilies.computeFamilyIndex == std::numeric_limits<uint32>::max() && 
+						localQueueFamilies.graphicsFamilyIndex == std::numeric_limits<uint32>::max() && 
 						(property.queueFlags & VK_QUEUE_GRAPHICS_BIT)
 					) {
 						localQueueFamilies.graphicsFamilyIndex = i;
@@ -235,23 +314,29 @@ RenderSystem::RenderSystem(
 						localQueueFamilies.computeFamilyIndex = i;
 					} 
 					
+					// uploads copy mip levels down to a single texel, so the transfer granularity has to be a single texel as well
+					const auto& granularity = property.minImageTransferGranularity;
 					if (
-						localQueueFamilies.copyFamilyIndex == std::numeric_limits<uint32>::max() && 
-						(property.queueFlags & VK_QUEUE_TRANSFER_BIT)
+						!(property.queueFlags & VK_QUEUE_GRAPHICS_BIT) && 
+						(property.queueFlags & supportsTransfer) &&
+						granularity.width == 1 && granularity.height == 1 && granularity.depth == 1
 					) {
-						localQueueFamilies.copyFamilyIndex = i;
+						if (!(property.queueFlags & VK_QUEUE_COMPUTE_BIT)) { // dedicated transfer family, usually backed by a DMA engine
+							if (localQueueFamilies.copyFamilyIndex == std::numeric_limits<uint32>::max()) localQueueFamilies.copyFamilyIndex = i;
+						} else if (asyncCopyFamilyIndex == std::numeric_limits<uint32>::max()) asyncCopyFamilyIndex = i;
 					}
+				}
 
-					if (
-						localQueueFamilies.copyFamilyIndex != std::numeric_limits<uint32>::max() && 
-						localQueueFamilies.computeFamilyIndex != std::numeric_limits<uint32>::max() &&
-						localQueueFamilies.copyFamilyIndex != std::numeric_limits<uint32>::max()
-					) {
-						score = 1;
-						break;
-					}
+				// fall back to an async compute family and then to the graphics family if there is no dedicated transfer family
+				if (localQueueFamilies.copyFamilyIndex == std::numeric_limits<uint32>::max()) localQueueFamilies.copyFamilyIndex = asyncCopyFamilyIndex;
+				if (localQueueFamilies.copyFamilyIndex == std::numeric_limits<uint32>::max()) localQueueFamilies.copyFamilyIndex = localQueueFamilies.graphicsFamilyIndex;
 
-					i++;
+				if (
+					localQueueFamilies.graphicsFamilyIndex != std::numeric_limits<uint32>::max() && 
+					localQueueFamilies.computeFamilyIndex != std::numeric_limits<uint32>::max() &&
+					localQueueFamilies.copyFamilyIndex != std::numeric_limits<uint32>::max()
+				) {
+					score = 1;
 				}
 
 				if (score == 0) {
@@ -272,8 +357,16 @@ RenderSystem::RenderSystem(
 					.pNext = &descriptorIndexingProperties
 				};
 				vkGetPhysicalDeviceProperties2KHR(device, &extendedProperties);
-				VkPhysicalDeviceFeatures features;
-				vkGetPhysicalDeviceFeatures(device, &features);
+				VkPhysicalDeviceVulkan12Features vulkan12Features {
+					.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES
+				};
+				VkPhysicalDeviceFeatures2 extendedFeatures {
+					.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+					.pNext = &vulkan12Features
+				};
+				vkGetPhysicalDeviceFeatures2(device, &extendedFeatures);
+				const auto& features = extendedFeatures.features;
+				vulkan12Features.pNext = nullptr;
 
 				// some required features. If not available, make the GPU unavailable
 				if ([&availableDeviceExtensions]() -> bool {
@@ -311,6 +404,9 @@ RenderSystem::RenderSystem(
 					} if (features.samplerAnisotropy) {
 						score += 4;
 						log::debug("\t{}", "Supports anistropic filtering");
+					} if (localQueueFamilies.copyFamilyIndex != localQueueFamilies.graphicsFamilyIndex) {
+						score += 2;
+						log::debug("\t{}", "Has an asynchronous transfer queue");
 					} 
 					score += (int)(extendedProperties.properties.limits.maxImageDimension2D / 2048);
 
@@ -318,7 +414,7 @@ RenderSystem::RenderSystem(
 				}
 
 				// insert the device into the queue
-				possibleDevices.emplace(score, PhysicalDeviceData {device, extendedProperties.properties, descriptorIndexingProperties, features, localQueueFamilies});
+				possibleDevices.emplace(score, PhysicalDeviceData {device, extendedProperties.properties, descriptorIndexingProperties, features, vulkan12Features, localQueueFamilies});
 			}
 		}
 
@@ -330,6 +426,16 @@ RenderSystem::RenderSystem(
 		deviceProperties = possibleDevices.rbegin()->second.properties;
 		descriptorIndexingProperties = possibleDevices.rbegin()->second.descriptorIndexingProperties;
 		deviceFeatures = possibleDevices.rbegin()->second.features;
+		// only enable the optional Vulkan 1.2 features the engine actually uses
+		vulkan12Features = VkPhysicalDeviceVulkan12Features {
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+			.drawIndirectCount = possibleDevices.rbegin()->second.vulkan12Features.drawIndirectCount,
+			.shaderSampledImageArrayNonUniformIndexing = VK_TRUE,
+			.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
+			.descriptorBindingPartiallyBound = VK_TRUE,
+			.descriptorBindingVariableDescriptorCount = VK_TRUE,
+			.runtimeDescriptorArray = VK_TRUE
+		};
 		queueFamilies = possibleDevices.rbegin()->second.queueFamilies;
 	}
 
@@ -356,18 +462,10 @@ RenderSystem::RenderSystem(
 		auto& requestedExtensions = config::requestedDeviceExtensions;
 #endif
 
-		VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures { 
-			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
-			.shaderSampledImageArrayNonUniformIndexing = VK_TRUE,
-			.descriptorBindingPartiallyBound = VK_TRUE,
-			.descriptorBindingVariableDescriptorCount = VK_TRUE,
-			.runtimeDescriptorArray = VK_TRUE
-		};
-
 		// device creation info
 		VkDeviceCreateInfo createInfo {
 			VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-			&descriptorIndexingFeatures,
+			&vulkan12Features,
 			0,
 			static_cast<uint32>(queueCreateInfos.size()),
 			queueCreateInfos.data(),
@@ -389,7 +487,7 @@ RenderSystem::RenderSystem(
 	{ // create queues
 		graphicsQueue = vk::Queue(device, queueFamilies.graphicsFamilyIndex, 0);
 		computeQueue = vk::Queue(device, queueFamilies.computeFamilyIndex, 0);
-		copyQueue = vk::Queue(device, queueFamilies.computeFamilyIndex, 0);
+		copyQueue = vk::Queue(device, queueFamilies.copyFamilyIndex, 0);
 	}
 	
 	{ // create the memory allocator
@@ -411,12 +509,87 @@ RenderSystem::RenderSystem(
 		// create the allocator
 		allocator = vma::Allocator(instance, createInfo);
 	}
+
+	{ // create the pipeline cache, already containing the pipelines of previous runs if they were built on the same device and driver
+		auto data = readPipelineCache(absolutePath(config::pipelineCachePath.data()), deviceProperties);
+		if (!data.empty()) loadedPipelineCacheHash = hashBytes(data.data(), data.size());
+
+		pipelineCache = vk::PipelineCache(device, VkPipelineCacheCreateInfo {
+			VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+			nullptr,
+			0,
+			data.size(),
+			data.data()
+		});
+	}
+}
+
+void RenderSystem::savePipelineCache() {
+	auto path = absolutePath(config::pipelineCachePath.data());
+
+	{ // other instances of the engine may have written to the file since it was loaded, merge their pipelines instead of overwriting them
+		auto data = readPipelineCache(path, deviceProperties);
+
+		if (!data.empty() && hashBytes(data.data(), data.size()) != loadedPipelineCacheHash) {
+			vk::PipelineCache diskCache(device, VkPipelineCacheCreateInfo {
+				VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+				nullptr,
+				0,
+				data.size(),
+				data.data()
+			});
+
+			VULKAN_ASSERT(mergePipelineCache(pipelineCache, diskCache), "merge pipeline caches");
+		}
+	}
+
+	size_type size = 0;
+	VULKAN_ASSERT(getPipelineCacheData(pipelineCache, size, nullptr), "get pipeline cache size");
+	lsd::Vector<char> data(size);
+	VULKAN_ASSERT(getPipelineCacheData(pipelineCache, size, data.data()), "get pipeline cache data");
+
+	PipelineCacheHeader header {
+		PipelineCacheHeader::magic,
+		PipelineCacheHeader::version,
+		deviceProperties.vendorID,
+		deviceProperties.deviceID,
+		deviceProperties.driverVersion,
+		0,
+		size,
+		hashBytes(data.data(), size),
+		{ }
+	};
+	std::memcpy(header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+
+	// write to a temporary file first, so that a crash while writing can't leave a truncated cache behind
+	auto tmpPath = path;
+	tmpPath.concat(".tmp");
+
+	{
+		std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(PipelineCacheHeader));
+		file.write(data.data(), size);
+
+		if (!file) {
+			log::error("lyra::vulkan::RenderSystem::savePipelineCache(): Failed to write the pipeline cache to path: {}!", tmpPath.string());
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tmpPath, path, error);
+
+	if (error) log::error("lyra::vulkan::RenderSystem::savePipelineCache(): Failed to replace the pipeline cache at path: {} with error: {}!", path.string(), error.message());
+	else loadedPipelineCacheHash = header.dataHash;
 }
 
 void RenderSystem::initRenderComponents() {
 	commandQueue = commandQueue.create();
+	uploadQueue = uploadQueue.create();
+	if constexpr (config::parallelRecording) commandRecorder = commandRecorder.create();
 	swapchain = swapchain.create(*commandQueue);
-	descriptorPools = descriptorPools.create( lsd::Vector<DescriptorPools::Size> {
+	descriptorPools = descriptorPools.create();
+	transientDescriptorPools = transientDescriptorPools.create( lsd::Vector<TransientDescriptorPools::Size> {
 		{ DescriptorSets::Type::sampler, 1 },
 		{ DescriptorSets::Type::imageSampler, 8 },
 		{ DescriptorSets::Type::sampledImage, 8 },
@@ -428,7 +601,7 @@ void RenderSystem::initRenderComponents() {
 		{ DescriptorSets::Type::dynamicUniformBuffer, 2 },
 		{ DescriptorSets::Type::dynamicStorageBuffer, 2 },
 		{ DescriptorSets::Type::inputAttachment, 1 }
-	}, DescriptorPools::Flags::freeDescriptorSet | DescriptorPools::Flags::updateAfterBind);
+	});
 
 	defaultVertexShader = &resource::shader(defaultVertexShaderPath);
 	defaultFragmentShader = &resource::shader(defaultFragmentShaderPath);
@@ -498,16 +671,23 @@ void RenderSystem::initRenderComponents() {
 
 	defaultGraphicsProgram = new GraphicsProgram();
 	graphicsPrograms.emplace(defaultGraphicsProgram->hash, defaultGraphicsProgram);
-	graphicsPipelines.emplace(GraphicsPipeline::Builder().hash(), new GraphicsPipeline());
+	defaultGraphicsPipeline = graphicsPipelines.emplace(GraphicsPipeline::Builder().hash(), new GraphicsPipeline()).first->second;
+
+	// the instance buffer and material table allocate their descriptor sets with the layout of the default program
+	geometryBuffer = geometryBuffer.create();
+	instanceBuffer = instanceBuffer.create();
+	materialTable = materialTable.create();
 }
 
 
-CommandQueue::CommandPool::CommandPool() {
+CommandQueue::CommandPool::CommandPool() : CommandPool(renderer::globalRenderSystem->queueFamilies.graphicsFamilyIndex) { }
+
+CommandQueue::CommandPool::CommandPool(uint32 queueFamilyIndex) {
 	VkCommandPoolCreateInfo createInfo{
 		VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
 		nullptr,
 		VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-		renderer::globalRenderSystem->queueFamilies.graphicsFamilyIndex
+		queueFamilyIndex
 	};
 
 	commandPool = vk::CommandPool(renderer::globalRenderSystem->device, createInfo);
@@ -545,6 +725,17 @@ void CommandQueue::CommandBuffer::begin(const Usage& usage) const {
 	VULKAN_ASSERT(vkBeginCommandBuffer(commandBuffer, &beginInfo), "start recording Vulkan command buffer");
 }
 
+void CommandQueue::CommandBuffer::begin(const Usage& usage, const VkCommandBufferInheritanceInfo& inheritanceInfo) const {
+	VkCommandBufferBeginInfo beginInfo{
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		nullptr,
+		static_cast<VkCommandBufferUsageFlags>(usage),
+		&inheritanceInfo
+	};
+
+	VULKAN_ASSERT(vkBeginCommandBuffer(commandBuffer, &beginInfo), "start recording secondary Vulkan command buffer");
+}
+
 void CommandQueue::CommandBuffer::reset(VkCommandBufferResetFlags flags) const {
 	VULKAN_ASSERT(vkResetCommandBuffer(commandBuffer, flags), "reset command buffer"); // reset the command buffer
 }
@@ -612,10 +803,866 @@ void CommandQueue::oneTimeSubmit() {
 		nullptr
 	};
 
-	VULKAN_ASSERT(vkQueueSubmit(renderer::globalRenderSystem->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE), "submit Vulkan queue");
-	vkQueueWaitIdle(renderer::globalRenderSystem->graphicsQueue);
+	// only wait for this submission instead of the entire queue
+	vk::Fence fence(renderer::globalRenderSystem->device, VkFenceCreateInfo { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, nullptr, 0 });
+
+	VULKAN_ASSERT(vkQueueSubmit(renderer::globalRenderSystem->graphicsQueue, 1, &submitInfo, fence), "submit Vulkan queue");
+	VULKAN_ASSERT(renderer::globalRenderSystem->waitForFence(fence, VK_TRUE, std::numeric_limits<uint64>::max()), "wait for fence to finish");
+
+	delete activeCommandBuffer;
+}
+
+UploadQueue::Batch::Batch(const CommandQueue::CommandPool& commandPool, const CommandQueue::CommandPool& transferCommandPool) : 
+	commandBuffer(commandPool),
+	transferCommandBuffer(transferCommandPool),
+	transferFinished(renderer::globalRenderSystem->device, VkSemaphoreCreateInfo { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, nullptr, 0 }),
+	fence(renderer::globalRenderSystem->device, VkFenceCreateInfo { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, nullptr, 0 }) { }
+
+UploadQueue::UploadQueue(VkDeviceSize stagingSize) : 
+	graphicsFamilyIndex(renderer::globalRenderSystem->queueFamilies.graphicsFamilyIndex),
+	transferFamilyIndex(renderer::globalRenderSystem->queueFamilies.copyFamilyIndex),
+	dedicatedTransfer(graphicsFamilyIndex != transferFamilyIndex),
+	commandPool(graphicsFamilyIndex),
+	transferCommandPool(transferFamilyIndex),
+	stagingBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY) {
+	// the staging buffer stays mapped for its entire lifetime
+	VULKAN_ASSERT(renderer::globalRenderSystem->mapMemory(stagingBuffer.memory, reinterpret_cast<void**>(&stagingData)), "map staging buffer memory at {}", lsd::getAddress(stagingBuffer.memory));
+}
+
+UploadQueue::~UploadQueue() {
+	wait();
+	renderer::globalRenderSystem->unmapMemory(stagingBuffer.memory);
+}
+
+void UploadQueue::copy(const GPUBuffer& dstBuffer, const void* src, VkDeviceSize size, VkDeviceSize dstOffset) {
+	if (size == 0) return;
+
+	VkDeviceSize offset;
+	const auto& srcBuffer = stage(src, size, offset);
+
+	if (!dedicatedTransfer || dstOffset != 0 || size != dstBuffer.size) {
+		recording->commandBuffer.copyBuffer(srcBuffer, dstBuffer.buffer, VkBufferCopy { offset, dstOffset, size });
+		return;
+	}
+
+	recording->transferCommandBuffer.copyBuffer(srcBuffer, dstBuffer.buffer, VkBufferCopy { offset, dstOffset, size });
+
+	// release the buffer from the transfer queue and acquire it on the graphics queue, the semaphore orders the two barriers
+	recording->transferCommandBuffer.pipelineBarrier(
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		0,
+		{ },
+		dstBuffer.bufferMemoryBarrier(
+			GPUMemory::Access::transferWrite,
+			GPUMemory::Access::none,
+			transferFamilyIndex,
+			graphicsFamilyIndex
+		)
+	);
+	recording->commandBuffer.pipelineBarrier(
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		{ },
+		dstBuffer.bufferMemoryBarrier(
+			GPUMemory::Access::none,
+			GPUMemory::Access::vertexAttributeRead | GPUMemory::Access::indexRead | GPUMemory::Access::uniformRead | GPUMemory::Access::shaderRead,
+			transferFamilyIndex,
+			graphicsFamilyIndex
+		)
+	);
+}
+
+void UploadQueue::copy(
+	const Image& dstImage,
+	const void* src,
+	VkDeviceSize size,
+	const lsd::Vector<VkBufferImageCopy>& regions,
+	const VkImageSubresourceRange& subresourceRange,
+	Image::Layout finalLayout
+) {
+	VkDeviceSize offset;
+	const auto& srcBuffer = stage(src, size, offset);
+	const auto& cmd = dedicatedTransfer ? recording->transferCommandBuffer : recording->commandBuffer;
+
+	cmd.pipelineBarrier(
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0,
+		{ },
+		{ },
+		dstImage.imageMemoryBarrier(
+			GPUMemory::Access::none,
+			GPUMemory::Access::transferWrite,
+			Image::Layout::undefined,
+			Image::Layout::transferDst,
+			subresourceRange
+		)
+	);
+
+	auto stagedRegions = regions;
+	for (auto& region : stagedRegions) region.bufferOffset += offset;
+
+	cmd.copyBufferToImage(srcBuffer, dstImage.image, Image::Layout::transferDst, stagedRegions);
+
+	// commands recorded after the copy continue on the graphics queue in transfer destination layout
+	auto dstStage = (finalLayout == Image::Layout::transferDst) ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	auto dstAccess = (finalLayout == Image::Layout::transferDst) ? 
+		GPUMemory::Access::transferRead | GPUMemory::Access::transferWrite : 
+		GPUMemory::Access::shaderRead;
+
+	if (dedicatedTransfer) {
+		// the layout transition is part of the ownership transfer, so both barriers have to describe it identically
+		recording->transferCommandBuffer.pipelineBarrier(
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0,
+			{ },
+			{ },
+			dstImage.imageMemoryBarrier(
+				GPUMemory::Access::transferWrite,
+				GPUMemory::Access::none,
+				Image::Layout::transferDst,
+				finalLayout,
+				subresourceRange,
+				transferFamilyIndex,
+				graphicsFamilyIndex
+			)
+		);
+		recording->commandBuffer.pipelineBarrier(
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			dstStage,
+			0,
+			{ },
+			{ },
+			dstImage.imageMemoryBarrier(
+				GPUMemory::Access::none,
+				dstAccess,
+				Image::Layout::transferDst,
+				finalLayout,
+				subresourceRange,
+				transferFamilyIndex,
+				graphicsFamilyIndex
+			)
+		);
+	} else if (finalLayout != Image::Layout::transferDst) {
+		recording->commandBuffer.pipelineBarrier(
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			dstStage,
+			0,
+			{ },
+			{ },
+			dstImage.imageMemoryBarrier(
+				GPUMemory::Access::transferWrite,
+				dstAccess,
+				Image::Layout::transferDst,
+				finalLayout,
+				subresourceRange
+			)
+		);
+	}
+}
+
+const CommandQueue::CommandBuffer& UploadQueue::commandBuffer() {
+	return record().commandBuffer;
+}
+
+void UploadQueue::flush() {
+	if (recording) {
+		// make the uploaded data visible to all commands submitted to the graphics queue after this batch
+		recording->commandBuffer.pipelineBarrier(
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			VkMemoryBarrier {
+				VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+				nullptr,
+				VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT
+			}
+		);
+		recording->commandBuffer.end();
+		recording->stagingEnd = stagingHead;
+
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		VkSubmitInfo submitInfo {
+			VK_STRUCTURE_TYPE_SUBMIT_INFO,
+			nullptr,
+			0,
+			nullptr,
+			nullptr,
+			1,
+			&recording->commandBuffer.commandBuffer.get(),
+			0,
+			nullptr
+		};
+
+		if (dedicatedTransfer) {
+			recording->transferCommandBuffer.end();
+
+			// the copies run on the transfer queue while the graphics queue continues with previously submitted frames
+			VkSubmitInfo transferSubmitInfo {
+				VK_STRUCTURE_TYPE_SUBMIT_INFO,
+				nullptr,
+				0,
+				nullptr,
+				nullptr,
+				1,
+				&recording->transferCommandBuffer.commandBuffer.get(),
+				1,
+				&recording->transferFinished.get()
+			};
+
+			VULKAN_ASSERT(vkQueueSubmit(renderer::globalRenderSystem->copyQueue, 1, &transferSubmitInfo, VK_NULL_HANDLE), "submit upload batch to transfer queue");
+
+			// the graphics side of the batch acquires the resources once the transfer queue has signaled
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = &recording->transferFinished.get();
+			submitInfo.pWaitDstStageMask = &waitStage;
+		}
+
+		// the fence of the graphics submission also covers the transfer submission, since it waits for it
+		VULKAN_ASSERT(vkQueueSubmit(renderer::globalRenderSystem->graphicsQueue, 1, &submitInfo, recording->fence), "submit upload batch");
+
+		submitted.pushBack(recording);
+		recording = nullptr;
+	}
+
+	retire(false);
+}
+
+void UploadQueue::wait() {
+	flush();
+	while (!submitted.empty()) retire(true);
+}
+
+VkDeviceSize UploadQueue::allocate(VkDeviceSize size) {
+	size = (size + alignment - 1) & ~(alignment - 1);
+	if (size > stagingBuffer.size) return std::numeric_limits<VkDeviceSize>::max();
+
+	retire(false);
+
+	VkDeviceSize offset;
+
+	for (;;) {
+		// an empty ring starts over at the beginning of the staging buffer, otherwise the padding could make an allocation wait forever
+		if (stagingHead == stagingTail) {
+			stagingHead = (stagingHead + stagingBuffer.size - 1) / stagingBuffer.size * stagingBuffer.size;
+			stagingTail = stagingHead;
+		}
+
+		// allocations never wrap around the end of the staging buffer, the rest of it is skipped instead
+		offset = stagingHead % stagingBuffer.size;
+		auto padding = (offset + size > stagingBuffer.size) ? stagingBuffer.size - offset : 0;
+
+		if (stagingHead + padding + size - stagingTail <= stagingBuffer.size) {
+			stagingHead += padding;
+			break;
+		}
+
+		// the batch still recording occupies the space needed, so it has to be submitted before it can be waited for
+		if (submitted.empty()) flush();
+		retire(true);
+	}
+
+	offset = stagingHead % stagingBuffer.size;
+	stagingHead += size;
+
+	return offset;
+}
+
+const vk::Buffer& UploadQueue::stage(const void* src, VkDeviceSize size, VkDeviceSize& offset) {
+	offset = allocate(size);
+	auto& batch = record();
+
+	if (offset == std::numeric_limits<VkDeviceSize>::max()) {
+		batch.overflowBuffers.emplaceBack(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+		batch.overflowBuffers.back().copyData(src, size);
+
+		offset = 0;
+		return batch.overflowBuffers.back().buffer;
+	}
+
+	memcpy(stagingData + offset, src, size);
+	return stagingBuffer.buffer;
+}
+
+UploadQueue::Batch& UploadQueue::record() {
+	if (!recording) {
+		if (retired.empty()) {
+			batches.pushBack(lsd::UniquePointer<Batch>::create(commandPool, transferCommandPool));
+			retired.pushBack(batches.back().get());
+		}
+
+		recording = retired.back();
+		retired.popBack();
+
+		recording->commandBuffer.begin(CommandQueue::CommandBuffer::Usage::oneTimeSubmit);
+		if (dedicatedTransfer) recording->transferCommandBuffer.begin(CommandQueue::CommandBuffer::Usage::oneTimeSubmit);
+	}
+
+	return *recording;
+}
+
+void UploadQueue::retire(bool wait) {
+	if (wait && !submitted.empty()) {
+		VULKAN_ASSERT(renderer::globalRenderSystem->waitForFence(submitted.front()->fence, VK_TRUE, std::numeric_limits<uint64>::max()), "wait for upload batch to finish");
+	}
+
+	// batches finish in order of submission, so the staging memory can be released front to back
+	while (!submitted.empty() && renderer::globalRenderSystem->getFenceStatus(submitted.front()->fence) == VK_SUCCESS) {
+		auto batch = submitted.front();
+		submitted.erase(submitted.begin());
+
+		// batches submitted before the ring started over may end before the current tail
+		stagingTail = std::max(stagingTail, batch->stagingEnd);
+		batch->overflowBuffers.clear();
+		VULKAN_ASSERT(renderer::globalRenderSystem->resetFence(batch->fence), "reset upload batch fence");
+
+		retired.pushBack(batch);
+	}
+}
+
+CommandRecorder::CommandRecorder(uint32 threadCount) : workers(threadCount) {
+	// the recording thread takes part in the work as well
+	threadCommands.reserve((threadCount + 1) * config::maxFramesInFlight);
+	for (uint32 i = 0; i < (threadCount + 1) * config::maxFramesInFlight; i++) threadCommands.emplaceBack();
+}
+
+void CommandRecorder::reset(uint32 frame) {
+	currentFrame = frame;
+
+	for (uint32 i = frame; i < threadCommands.size(); i += config::maxFramesInFlight) {
+		auto& commands = threadCommands[i];
+		if (commands.used == 0) continue;
+
+		// keep the memory of the pool, since roughly the same amount of commands is recorded every frame
+		VULKAN_ASSERT(renderer::globalRenderSystem->resetCommandPool(commands.commandPool.commandPool, 0), "reset recording command pool");
+		commands.used = 0;
+	}
+}
+
+void CommandRecorder::record(const VkCommandBufferInheritanceInfo& inheritanceInfo, size_type count, size_type chunkSize, const record_func& func) {
+	if (count == 0) return;
+
+	auto chunkCount = (count + chunkSize - 1) / chunkSize;
+	auto firstChunk = recorded.size();
+	recorded.resize(firstChunk + chunkCount);
+
+	workers.parallelFor(chunkCount, [&](size_type chunk, uint32 slot) {
+		ASSERT(slot <= workers.size(), "lyra::vulkan::CommandRecorder::record(): Recording slot: {} is out of range for {} workers!", slot, workers.size());
+
+		auto& commands = threadCommands[slot * config::maxFramesInFlight + currentFrame];
+
+		if (commands.used == commands.commandBuffers.size()) {
+			commands.commandBuffers.emplaceBack(commands.commandPool, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+		}
+
+		const auto& commandBuffer = commands.commandBuffers[commands.used++];
+
+		commandBuffer.begin(
+			CommandQueue::CommandBuffer::Usage::renderPassContinue | CommandQueue::CommandBuffer::Usage::oneTimeSubmit, 
+			inheritanceInfo
+		);
+		func(commandBuffer, chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+		commandBuffer.end();
+
+		recorded[firstChunk + chunk] = commandBuffer.commandBuffer.get();
+	});
+}
+
+void CommandRecorder::execute(const CommandQueue::CommandBuffer& commandBuffer) {
+	if (!recorded.empty()) commandBuffer.executeCommands(recorded);
+	recorded.clear();
+}
+
+GeometryBuffer::GeometryBuffer(uint32 vertexCapacity, uint32 indexCapacity) : 
+	vertexBuffer(
+		vertexCapacity * sizeof(Mesh::PackedVertex), 
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 
+		VMA_MEMORY_USAGE_GPU_ONLY
+	),
+	indexBuffer(
+		indexCapacity * sizeof(uint32), 
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 
+		VMA_MEMORY_USAGE_GPU_ONLY
+	),
+	vertexCapacity(vertexCapacity),
+	indexCapacity(indexCapacity * sizeof(uint32)) { }
+
+GeometryBuffer::Range GeometryBuffer::add(const Mesh& mesh) {
+	auto it = ranges.find(&mesh);
+	if (it != ranges.end()) return it->second;
+
+	auto meshVertexCount = static_cast<uint32>(mesh.vertices().size());
+	auto meshIndexCount = mesh.indexCount();
+	auto meshIndexSize = Mesh::indexSize(mesh.indexType());
+	auto meshIndexBytes = meshIndexCount * meshIndexSize;
+
+	// the first index is counted in the index type of the mesh, so its offset has to be a multiple of the index size
+	uint32 vertexOffset;
+	uint32 indexOffset;
+
+	auto vertexEnd = vertexCount;
+	auto indexEnd = indexSize;
+
+	if (!takeFreeRange(freeVertices, meshVertexCount, 1, vertexOffset)) {
+		vertexOffset = vertexCount;
+		vertexEnd += meshVertexCount;
+	}
+
+	if (!takeFreeRange(freeIndices, meshIndexBytes, meshIndexSize, indexOffset)) {
+		indexOffset = (indexSize + meshIndexSize - 1) / meshIndexSize * meshIndexSize;
+		indexEnd = indexOffset + meshIndexBytes;
+	}
+
+	if (vertexEnd > vertexCapacity || indexEnd > indexCapacity) {
+		grow(std::max(vertexCapacity * 2, vertexEnd), std::max(indexCapacity * 2, indexEnd));
+	}
+
+	Range range { indexOffset / meshIndexSize, meshIndexCount, static_cast<int32>(vertexOffset), mesh.indexType() };
+
+	// the copies are batched with all other uploads and submitted at the end of the frame
+	renderer::globalRenderSystem->uploadQueue->copy(vertexBuffer, mesh.vertices().data(), meshVertexCount * sizeof(Mesh::PackedVertex), vertexOffset * sizeof(Mesh::PackedVertex));
+	renderer::globalRenderSystem->uploadQueue->copy(indexBuffer, mesh.indexData(), meshIndexBytes, indexOffset);
+
+	vertexCount = vertexEnd;
+	indexSize = indexEnd;
+
+	return ranges.emplace(&mesh, range).first->second;
+}
+
+void GeometryBuffer::remove(const Mesh& mesh) {
+	auto it = ranges.find(&mesh);
+	if (it == ranges.end()) return;
+
+	const auto& range = it->second;
+	auto meshIndexSize = Mesh::indexSize(range.indexType);
+
+	// without a swapchain no frame can be in flight anymore
+	auto& frame = released[renderer::globalRenderSystem->swapchain ? renderer::globalRenderSystem->swapchain->currentFrame : 0];
+
+	if (!mesh.vertices().empty()) frame.vertices.pushBack({ static_cast<uint32>(range.vertexOffset), static_cast<uint32>(mesh.vertices().size()) });
+	if (range.indexCount != 0) frame.indices.pushBack({ range.firstIndex * meshIndexSize, range.indexCount * meshIndexSize });
+
+	ranges.erase(it);
+}
+
+void GeometryBuffer::retire(uint32 frame) {
+	auto& space = released[frame];
+
+	for (const auto& [offset, size] : space.vertices) releaseRange(freeVertices, offset, size);
+	for (const auto& [offset, size] : space.indices) releaseRange(freeIndices, offset, size);
+
+	space.vertices.clear();
+	space.indices.clear();
+
+	// free space at the end of the buffers is appended to again, which also keeps the copies of grow() small
+	if (!freeVertices.empty() && freeVertices.back().first + freeVertices.back().second == vertexCount) {
+		vertexCount = freeVertices.back().first;
+		freeVertices.popBack();
+	}
+
+	if (!freeIndices.empty() && freeIndices.back().first + freeIndices.back().second == indexSize) {
+		indexSize = freeIndices.back().first;
+		freeIndices.popBack();
+	}
+}
+
+bool GeometryBuffer::takeFreeRange(lsd::Vector<FreeRange>& freeRanges, uint32 size, uint32 alignment, uint32& offset) {
+	if (size == 0) return false;
+
+	for (auto it = freeRanges.begin(); it != freeRanges.end(); it++) {
+		auto first = (it->first + alignment - 1) / alignment * alignment;
+		auto end = it->first + it->second;
+
+		if (first + size > end) continue;
+
+		offset = first;
+
+		// the padding before the aligned offset stays free, just like the space after the taken range
+		auto padding = first - it->first;
+		auto rest = end - (first + size);
+
+		if (padding != 0 && rest != 0) {
+			it->second = padding;
+			freeRanges.pushBack({ first + size, rest });
+			std::sort(freeRanges.begin(), freeRanges.end());
+		} else if (padding != 0) {
+			it->second = padding;
+		} else if (rest != 0) {
+			*it = { first + size, rest };
+		} else {
+			freeRanges.erase(it);
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+void GeometryBuffer::releaseRange(lsd::Vector<FreeRange>& freeRanges, uint32 offset, uint32 size) {
+	freeRanges.pushBack({ offset, size });
+	std::sort(freeRanges.begin(), freeRanges.end());
+
+	// adjacent free ranges are merged, so larger meshes fit into them again
+	uint32 merged = 0;
+	for (uint32 i = 1; i < freeRanges.size(); i++) {
+		if (freeRanges[merged].first + freeRanges[merged].second == freeRanges[i].first) {
+			freeRanges[merged].second += freeRanges[i].second;
+		} else {
+			freeRanges[++merged] = freeRanges[i];
+		}
+	}
+
+	freeRanges.resize(merged + 1);
+}
+
+void GeometryBuffer::bind(const CommandQueue::CommandBuffer& commandBuffer, VkIndexType indexType) const {
+	commandBuffer.bindVertexBuffer(vertexBuffer.buffer, 0, 0);
+	commandBuffer.bindIndexBuffer(indexBuffer.buffer, 0, indexType);
+}
+
+void GeometryBuffer::grow(uint32 newVertexCapacity, uint32 newIndexCapacity) {
+	log::debug("lyra::vulkan::GeometryBuffer::grow(): Growing the geometry buffers to {} vertices and {} bytes of indices!", newVertexCapacity, newIndexCapacity);
+
+	// frames in flight may still read from the old buffers
+	VULKAN_ASSERT(vkDeviceWaitIdle(renderer::globalRenderSystem->device), "wait for device to finish before growing the geometry buffers");
+
+	GPUBuffer newVertexBuffer(
+		newVertexCapacity * sizeof(Mesh::PackedVertex), 
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 
+		VMA_MEMORY_USAGE_GPU_ONLY
+	);
+	GPUBuffer newIndexBuffer(
+		newIndexCapacity, 
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 
+		VMA_MEMORY_USAGE_GPU_ONLY
+	);
+
+	const auto& commandBuffer = renderer::globalRenderSystem->uploadQueue->commandBuffer();
+
+	// uploads into the old buffers may have been recorded into the same batch
+	commandBuffer.pipelineBarrier(
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0,
+		VkMemoryBarrier {
+			VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+			nullptr,
+			VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_ACCESS_TRANSFER_READ_BIT
+		}
+	);
+
+	if (vertexCount != 0) commandBuffer.copyBuffer(vertexBuffer.buffer, newVertexBuffer.buffer, VkBufferCopy { 0, 0, vertexCount * sizeof(Mesh::PackedVertex) });
+	if (indexSize != 0) commandBuffer.copyBuffer(indexBuffer.buffer, newIndexBuffer.buffer, VkBufferCopy { 0, 0, indexSize });
+
+	// the old buffers can only be destroyed once the copies have finished
+	renderer::globalRenderSystem->uploadQueue->wait();
+
+	vertexBuffer = std::move(newVertexBuffer);
+	indexBuffer = std::move(newIndexBuffer);
+	vertexCapacity = newVertexCapacity;
+	indexCapacity = newIndexCapacity;
+}
+
+InstanceBuffer::InstanceBuffer(uint32 capacity) {
+	for (auto& frame : frames) create(frame, capacity);
+}
+
+InstanceBuffer::~InstanceBuffer() {
+	for (auto& frame : frames) destroy(frame);
+}
+
+void InstanceBuffer::reserve(uint32 frame, uint32 count) {
+	auto& buffers = frames[frame];
+
+	if (count > buffers.capacity) {
+		auto capacity = std::max(buffers.capacity * 2, count);
+
+		destroy(buffers);
+		create(buffers, capacity);
+	}
+
+	// the set of the previous use of this frame was freed together with the transient pools of the frame
+	buffers.descriptorSet = renderer::globalRenderSystem->transientDescriptorPools->allocate(frame, *renderer::globalRenderSystem->defaultGraphicsProgram, descriptorSetIndex);
+
+	auto bufferInfo = buffers.instanceBuffer.getDescriptorBufferInfo();
+
+	renderer::globalRenderSystem->updateDescriptorSet({{
+		VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+		nullptr,
+		buffers.descriptorSet,
+		0,
+		0,
+		1,
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		nullptr,
+		&bufferInfo,
+		nullptr
+	}});
+}
+
+void InstanceBuffer::flush(uint32 frame, uint32 count) const {
+	if (count == 0) return;
+
+	const auto& buffers = frames[frame];
+
+	VULKAN_ASSERT(renderer::globalRenderSystem->flushAllocation(buffers.instanceBuffer.memory, 0, count * sizeof(InstanceData)), "flush instance buffer memory");
+	VULKAN_ASSERT(renderer::globalRenderSystem->flushAllocation(buffers.drawBuffer.memory, 0, count * sizeof(VkDrawIndexedIndirectCommand)), "flush indirect draw buffer memory");
+}
+
+void InstanceBuffer::bind(uint32 frame, const CommandQueue::CommandBuffer& commandBuffer, const GraphicsProgram& program) const {
+	commandBuffer.bindDescriptorSet(VK_PIPELINE_BIND_POINT_GRAPHICS, program.pipelineLayout, descriptorSetIndex, frames[frame].descriptorSet);
+}
+
+void InstanceBuffer::create(Frame& frame, uint32 capacity) {
+	frame.capacity = capacity;
+
+	// both buffers stay mapped for their entire lifetime, since they are rewritten every frame
+	frame.instanceBuffer = GPUBuffer(capacity * sizeof(InstanceData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	frame.drawBuffer = GPUBuffer(capacity * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+	VULKAN_ASSERT(renderer::globalRenderSystem->mapMemory(frame.instanceBuffer.memory, reinterpret_cast<void**>(&frame.instances)), "map instance buffer memory at {}", lsd::getAddress(frame.instanceBuffer.memory));
+	VULKAN_ASSERT(renderer::globalRenderSystem->mapMemory(frame.drawBuffer.memory, reinterpret_cast<void**>(&frame.draws)), "map indirect draw buffer memory at {}", lsd::getAddress(frame.drawBuffer.memory));
+}
+
+void InstanceBuffer::destroy(Frame& frame) {
+	if (frame.instances) renderer::globalRenderSystem->unmapMemory(frame.instanceBuffer.memory);
+	if (frame.draws) renderer::globalRenderSystem->unmapMemory(frame.drawBuffer.memory);
+
+	frame.instances = nullptr;
+	frame.draws = nullptr;
+}
+
+MaterialTable::MaterialTable(uint32 capacity) : 
+	textureCapacity(renderer::globalRenderSystem->defaultGraphicsProgram->dynamicDescriptorCounts[descriptorSetIndex]) {
+	for (auto& frame : frames) {
+		frame.descriptorSet = renderer::globalRenderSystem->descriptorPools->allocate(*renderer::globalRenderSystem->defaultGraphicsProgram, descriptorSetIndex, true);
+		create(frame, capacity);
+	}
+}
+
+MaterialTable::~MaterialTable() {
+	for (auto& frame : frames) destroy(frame);
+}
+
+uint32 MaterialTable::addTexture(const Texture& texture) {
+	return addTextures({ &texture });
+}
+
+uint32 MaterialTable::addTextures(const lsd::Vector<const Texture*>& newTextures) {
+	ASSERT(!newTextures.empty(), "lyra::vulkan::MaterialTable::addTextures(): At least one texture has to be added!");
+
+	// materials using the same textures in the same order share their range
+	auto uses = textureUses.find(newTextures.front());
+
+	if (uses != textureUses.end()) {
+		for (auto first : uses->second) {
+			auto& range = textureRanges.at(first);
+
+			if (std::equal(range.textures.begin(), range.textures.end(), newTextures.begin(), newTextures.end())) {
+				range.references++;
+				return first;
+			}
+		}
+	}
+
+	auto count = static_cast<uint32>(newTextures.size());
+	auto first = allocateTextures(count);
+
+	for (uint32 i = 0; i < count; i++) textures[first + i] = newTextures[i]->getDescriptorImageInfo();
+	writeTextures(first, count);
+
+	textureRanges.emplace(first, TextureRange { newTextures, count, 1 });
+
+	for (uint32 i = 0; i < count; i++) {
+		// a texture used multiple times in the same range only lists it once
+		if (std::find(newTextures.begin(), newTextures.begin() + i, newTextures[i]) == newTextures.begin() + i) textureUses[newTextures[i]].pushBack(first);
+	}
+
+	return first;
+}
+
+void MaterialTable::releaseTextures(uint32 first) {
+	auto it = textureRanges.find(first);
+	ASSERT(it != textureRanges.end(), "lyra::vulkan::MaterialTable::releaseTextures(): No texture range starts at slot: {}!", first);
+
+	if (--it->second.references != 0) return;
+
+	for (auto texture : it->second.textures) {
+		auto uses = textureUses.find(texture);
+		if (uses == textureUses.end()) continue;
+
+		auto use = std::find(uses->second.begin(), uses->second.end(), first);
+		if (use != uses->second.end()) uses->second.erase(use);
+		if (uses->second.empty()) textureUses.erase(uses);
+	}
+
+	freeTextures.pushBack({ first, it->second.count });
+	textureRanges.erase(it);
+
+	// neighbouring released slots are merged, so larger ranges can be placed in them again
+	std::sort(freeTextures.begin(), freeTextures.end());
+
+	uint32 merged = 0;
+	for (uint32 i = 1; i < freeTextures.size(); i++) {
+		if (freeTextures[merged].first + freeTextures[merged].second == freeTextures[i].first) {
+			freeTextures[merged].second += freeTextures[i].second;
+		} else {
+			freeTextures[++merged] = freeTextures[i];
+		}
+	}
+
+	freeTextures.resize(merged + 1);
+}
+
+void MaterialTable::removeTexture(const Texture& texture) {
+	auto uses = textureUses.find(&texture);
+	if (uses == textureUses.end()) return;
+
+	// the ranges stay allocated until the materials using them release them, but are never shared again
+	auto firsts = std::move(uses->second);
+	textureUses.erase(uses);
+
+	for (auto first : firsts) {
+		auto& range = textureRanges.at(first);
+
+		for (auto other : range.textures) {
+			auto otherUses = textureUses.find(other);
+			if (otherUses == textureUses.end()) continue;
+
+			auto use = std::find(otherUses->second.begin(), otherUses->second.end(), first);
+			if (use != otherUses->second.end()) otherUses->second.erase(use);
+			if (otherUses->second.empty()) textureUses.erase(otherUses);
+		}
+
+		range.textures.clear();
+	}
+}
+
+uint32 MaterialTable::allocateTextures(uint32 count) {
+	for (auto it = freeTextures.begin(); it != freeTextures.end(); it++) {
+		if (it->second < count) continue;
+
+		auto first = it->first;
+
+		it->first += count;
+		it->second -= count;
+		if (it->second == 0) freeTextures.erase(it);
+
+		return first;
+	}
+
+	ASSERT(textures.size() + count <= textureCapacity, "lyra::vulkan::MaterialTable::allocateTextures(): The texture array is full with {} textures!", textureCapacity);
+
+	auto first = static_cast<uint32>(textures.size());
+	textures.resize(first + count);
+
+	return first;
+}
+
+uint32 MaterialTable::add(const MaterialData& data) {
+	version++;
+
+	if (!freeMaterials.empty()) {
+		auto index = freeMaterials.back();
+		freeMaterials.popBack();
+
+		materials[index] = data;
+		return index;
+	}
+
+	materials.pushBack(data);
+
+	return static_cast<uint32>(materials.size() - 1);
+}
+
+void MaterialTable::set(uint32 index, const MaterialData& data) {
+	materials[index] = data;
+	version++;
+}
+
+void MaterialTable::remove(uint32 index) {
+	// the data stays in the buffer until the index is reused, since no instance references it anymore
+	freeMaterials.pushBack(index);
+}
+
+void MaterialTable::update(uint32 frame) {
+	auto& buffers = frames[frame];
+	if (buffers.version == version) return;
+
+	if (materials.size() > buffers.capacity) {
+		auto capacity = std::max(buffers.capacity * 2, static_cast<uint32>(materials.size()));
+
+		destroy(buffers);
+		create(buffers, capacity);
+	}
+
+	std::memcpy(buffers.materials, materials.data(), materials.size() * sizeof(MaterialData));
+	VULKAN_ASSERT(renderer::globalRenderSystem->flushAllocation(buffers.materialBuffer.memory, 0, materials.size() * sizeof(MaterialData)), "flush material buffer memory");
+
+	buffers.version = version;
+}
+
+void MaterialTable::bind(uint32 frame, const CommandQueue::CommandBuffer& commandBuffer, const GraphicsProgram& program) const {
+	commandBuffer.bindDescriptorSet(VK_PIPELINE_BIND_POINT_GRAPHICS, program.pipelineLayout, descriptorSetIndex, frames[frame].descriptorSet);
+}
+
+void MaterialTable::create(Frame& frame, uint32 capacity) {
+	frame.capacity = capacity;
+
+	// stays mapped for its entire lifetime, since it is rewritten whenever a material changes
+	frame.materialBuffer = GPUBuffer(capacity * sizeof(MaterialData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+	VULKAN_ASSERT(renderer::globalRenderSystem->mapMemory(frame.materialBuffer.memory, reinterpret_cast<void**>(&frame.materials)), "map material buffer memory at {}", lsd::getAddress(frame.materialBuffer.memory));
+
+	auto bufferInfo = frame.materialBuffer.getDescriptorBufferInfo();
+
+	renderer::globalRenderSystem->updateDescriptorSet({{
+		VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+		nullptr,
+		frame.descriptorSet,
+		materialBinding,
+		0,
+		1,
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		nullptr,
+		&bufferInfo,
+		nullptr
+	}});
+}
+
+void MaterialTable::destroy(Frame& frame) {
+	if (frame.materials) renderer::globalRenderSystem->unmapMemory(frame.materialBuffer.memory);
+
+	frame.materials = nullptr;
+}
+
+void MaterialTable::writeTextures(uint32 first, uint32 count) {
+	lsd::Vector<VkWriteDescriptorSet> writes;
+	writes.reserve(frames.size());
+
+	for (const auto& frame : frames) {
+		writes.pushBack({
+			VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			nullptr,
+			frame.descriptorSet,
+			textureBinding,
+			first,
+			count,
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			&textures[first],
+			nullptr,
+			nullptr
+		});
+	}
 
-	delete activeCommandBuffer;
+	renderer::globalRenderSystem->updateDescriptorSet(writes);
 }
 
 GPUBuffer::GPUBuffer(
@@ -778,6 +1825,15 @@ void Image::copyFromBuffer(const vulkan::GPUBuffer& stagingBuffer, const VkExten
 	commandQueue.oneTimeSubmit();
 }
 
+void Image::copyFromBuffer(const vulkan::GPUBuffer& stagingBuffer, const lsd::Vector<VkBufferImageCopy>& regions) {
+	CommandQueue commandQueue;
+	commandQueue.oneTimeBegin();
+
+	commandQueue.activeCommandBuffer->copyBufferToImage(stagingBuffer.buffer, image, Image::Layout::transferDst, regions);
+
+	commandQueue.oneTimeSubmit();
+}
+
 vk::Sampler Image::createSampler(
 	VkSamplerAddressMode addressModeU,
 	VkSamplerAddressMode addressModeV,
@@ -1309,7 +2365,7 @@ void RenderTarget::createFramebuffers(const glm::u32vec2& size) {
 	for (uint32 i = 0; i < framebuffers.size(); i++) framebuffers[i] = Framebuffer(i, *this, s);
 }
 
-void RenderTarget::begin() const {
+void RenderTarget::begin(VkSubpassContents contents) const {
 	static constexpr lsd::Array<VkClearValue, 2> clear {{
 		{
 			{{ 0.0f, 0.0f, 0.0f, 1.0f }},
@@ -1332,7 +2388,20 @@ void RenderTarget::begin() const {
 		clear.data()
 	};
 
-	renderer::globalRenderSystem->commandQueue->activeCommandBuffer->beginRenderPass(beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	renderer::globalRenderSystem->commandQueue->activeCommandBuffer->beginRenderPass(beginInfo, contents);
+}
+
+VkCommandBufferInheritanceInfo RenderTarget::inheritanceInfo(uint32 subpass) const {
+	return {
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+		nullptr,
+		renderPass,
+		subpass,
+		framebuffers[renderer::globalRenderSystem->swapchain->imageIndex].framebuffer,
+		VK_FALSE,
+		0,
+		0
+	};
 }
 
 void RenderTarget::end() const {
@@ -1340,14 +2409,14 @@ void RenderTarget::end() const {
 }
 
 DescriptorSets::~DescriptorSets() {
-	for (uint32 i = 0; i < descriptorSets.size(); i++) 
-		vkFreeDescriptorSets(renderer::globalRenderSystem->device, descriptorSets[i].owner(), 1, &descriptorSets[i].get());
-			
-	renderer::globalRenderSystem->descriptorPools->allocationIndex = 0;
+	for (const auto& descriptorSet : descriptorSets) 
+		renderer::globalRenderSystem->descriptorPools->free(descriptorSet);
 }
 
 void DescriptorSets::update(uint32 index) {
 	if (dirty) {
+		// the writes are rebuilt from scratch, since the image and buffer writes contain every write added so far
+		writes.clear();
 		writes.reserve(imageWrites.size() + bufferWrites.size());
 
 		for (const auto& write : imageWrites) {
@@ -1379,6 +2448,8 @@ void DescriptorSets::update(uint32 index) {
 				nullptr
 			});
 		}
+
+		dirty = false;
 	}
 
 	if (index != std::numeric_limits<uint32>::max()) {
@@ -1399,51 +2470,172 @@ void DescriptorSets::update(uint32 index) {
 void DescriptorSets::addDescriptorSets(uint32 count) {
 	for (uint32 i = 0; i < count; i++) {
 		descriptorSets.emplaceBack(
-			renderer::globalRenderSystem->descriptorPools->allocate(*graphicsProgram, layoutIndex, variableCount)
+			renderer::globalRenderSystem->descriptorPools->allocate(*program, layoutIndex, variableCount)
 		);
 	}
 
 	update();
 }
 
-void DescriptorSets::bind(uint32 index) {
+void DescriptorSets::allocate(uint32 index) {
 	if (descriptorSets.size() <= index) {
-		addDescriptorSets(1);
+		addDescriptorSets(index + 1 - static_cast<uint32>(descriptorSets.size()));
+	}
+}
+
+void DescriptorSets::bind(uint32 index) {
+	allocate(index);
+	bind(index, *renderer::globalRenderSystem->commandQueue->activeCommandBuffer);
+}
+
+void DescriptorSets::bind(uint32 index, const CommandQueue::CommandBuffer& commandBuffer) const {
+	commandBuffer.bindDescriptorSet(static_cast<VkPipelineBindPoint>(bindPoint), program->pipelineLayout, layoutIndex, descriptorSets[index]);
+}
+
+DescriptorPools::SetSize DescriptorPools::setSize(const VkDescriptorSetLayoutCreateInfo& createInfo) {
+	SetSize size { { }, (createInfo.flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT) != 0 };
+
+	for (uint32 i = 0; i < createInfo.bindingCount; i++) {
+		const auto& binding = createInfo.pBindings[i];
+
+		auto it = std::find_if(size.sizes.begin(), size.sizes.end(), [&binding](const VkDescriptorPoolSize& poolSize) { return poolSize.type == binding.descriptorType; });
+
+		if (it != size.sizes.end()) it->descriptorCount += binding.descriptorCount;
+		else size.sizes.pushBack({ binding.descriptorType, binding.descriptorCount });
+	}
+
+	// the order of the bindings does not matter to the pools
+	std::sort(size.sizes.begin(), size.sizes.end(), [](const VkDescriptorPoolSize& first, const VkDescriptorPoolSize& second) { return first.type < second.type; });
+
+	return size;
+}
+
+vk::DescriptorSet DescriptorPools::allocate(const Program& program, uint32 layoutIndex, bool variableCount) {
+	const auto& setSize = program.descriptorSetSizes[layoutIndex];
+
+	auto flags = (setSize.updateAfterBind) ? Flags::freeDescriptorSet | Flags::updateAfterBind : Flags::freeDescriptorSet;
+
+	lsd::Vector<VkDescriptorPoolSize> sizes;
+	for (const auto& size : setSize.sizes) sizes.pushBack({ size.type, std::bit_ceil(size.descriptorCount) });
+
+	auto key = hashCombine(fnvOffsetBasis, setSize.updateAfterBind);
+	for (const auto& size : sizes) key = hashCombine(key, size.type, size.descriptorCount);
+
+	// the hash only selects a candidate, if it belongs to a different size class the next key in the probe sequence is tried
+	auto sameClass = [&flags, &sizes](const SizeClass& sizeClass) {
+		return sizeClass.flags == flags && sizeClass.sizes.size() == sizes.size() && std::equal(sizes.begin(), sizes.end(), sizeClass.sizes.begin(), [](const VkDescriptorPoolSize& first, const VkDescriptorPoolSize& second) {
+			return first.type == second.type && first.descriptorCount == second.descriptorCount;
+		});
+	};
+
+	auto sizeClassIt = sizeClasses.find(key);
+	for (; sizeClassIt != sizeClasses.end() && !sameClass(sizeClassIt->second); sizeClassIt = sizeClasses.find(key)) key = hashCombine(key, 1);
+
+	if (sizeClassIt == sizeClasses.end()) {
+		SizeClass sizeClass { std::move(sizes), flags };
+
+		uint32 descriptorCount = 0;
+		for (const auto& size : sizeClass.sizes) descriptorCount += size.descriptorCount;
+
+		// large sets, f.e. bindless arrays, would make the pools of their class huge
+		sizeClass.setsPerPool = static_cast<uint32>(std::clamp<size_type>(config::maxDescriptorPoolDescriptors / std::max(descriptorCount, 1u), 1, config::maxDescriptorPoolSets));
+
+		sizeClassIt = sizeClasses.emplace(key, std::move(sizeClass)).first;
+	}
+
+	auto& sizeClass = sizeClassIt->second;
+
+	if (sizeClass.availablePools.empty()) {
+		lsd::Vector<VkDescriptorPoolSize> poolSizes;
+		for (const auto& size : sizeClass.sizes) poolSizes.pushBack({ size.type, size.descriptorCount * sizeClass.setsPerPool });
+
+		VkDescriptorPoolCreateInfo createInfo {
+			VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+			nullptr,
+			static_cast<VkDescriptorPoolCreateFlags>(sizeClass.flags),
+			sizeClass.setsPerPool,
+			static_cast<uint32>(poolSizes.size()),
+			poolSizes.data()
+		};
+
+		auto pool = static_cast<uint32>(sizeClass.pools.size());
+
+		poolLocations.emplace(sizeClass.pools.emplaceBack(renderer::globalRenderSystem->device, createInfo).get(), PoolLocation { key, pool });
+		sizeClass.setCounts.pushBack(0);
+		sizeClass.availablePools.pushBack(pool);
 	}
 
-	renderer::globalRenderSystem->commandQueue->activeCommandBuffer->bindDescriptorSet(VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsProgram->pipelineLayout, layoutIndex, descriptorSets[index]);
+	auto pool = sizeClass.availablePools.back();
+
+	VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountAlloc {
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO,
+		nullptr,
+		1,
+		&program.dynamicDescriptorCounts[layoutIndex]
+	};
+
+	VkDescriptorSetAllocateInfo allocInfo {
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+		(variableCount) ? &variableCountAlloc : nullptr,
+		sizeClass.pools[pool],
+		1,
+		&program.descriptorSetLayouts[layoutIndex].get()
+	};
+
+	VkResult r;
+	vk::DescriptorSet descriptorSet = vk::DescriptorSet(renderer::globalRenderSystem->device, allocInfo, r);
+	// every set of the class fits into a pool with space for another set
+	VULKAN_ASSERT(r, "allocate Vulkan descriptor set");
+
+	if (++sizeClass.setCounts[pool] == sizeClass.setsPerPool) sizeClass.availablePools.popBack();
+
+	return descriptorSet;
 }
 
-DescriptorPools::DescriptorPools(const lsd::Vector<Size>& sizes, Flags flags) {
-	constexpr static uint32 descriptorCount = config::descriptorPoolAllocCount * config::maxFramesInFlight;
+void DescriptorPools::free(const vk::DescriptorSet& descriptorSet) {
+	if (descriptorSet.get() == VK_NULL_HANDLE) return;
+
+	const auto& location = poolLocations.at(descriptorSet.owner());
+	auto& sizeClass = sizeClasses.at(location.sizeClass);
 
+	VULKAN_ASSERT(vkFreeDescriptorSets(renderer::globalRenderSystem->device, descriptorSet.owner(), 1, &descriptorSet.get()), "free Vulkan descriptor set");
+
+	if (sizeClass.setCounts[location.pool]-- == sizeClass.setsPerPool) sizeClass.availablePools.pushBack(location.pool);
+}
+
+TransientDescriptorPools::TransientDescriptorPools(const lsd::Vector<Size>& sizes) {
 	for (const auto& size : sizes) {
 		this->sizes.pushBack({
 			static_cast<VkDescriptorType>(size.type),
-			descriptorCount * size.multiplier
+			static_cast<uint32>(config::transientDescriptorPoolSets * size.multiplier)
 		});
 	}
 
 	createInfo = VkDescriptorPoolCreateInfo {
 		VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
 		nullptr,
-		static_cast<VkDescriptorPoolCreateFlags>(flags),
-		config::maxDescriptorPoolSets,
-		static_cast<uint32>(sizes.size()),
+		0,
+		config::transientDescriptorPoolSets,
+		static_cast<uint32>(this->sizes.size()),
 		this->sizes.data()
 	};
 
-	descriptorPools.emplaceBack(renderer::globalRenderSystem->device, createInfo);
+	for (auto& frame : frames) frame.pools.emplaceBack(renderer::globalRenderSystem->device, createInfo);
 }
 
-void DescriptorPools::reset() {
-	allocationIndex = 0;
+void TransientDescriptorPools::reset(uint32 frame) {
+	auto& pools = frames[frame];
 
-	for (auto& pool : descriptorPools)
-		renderer::globalRenderSystem->resetDescriptorPool(pool, 0);
+	// only the pools which were allocated from have to be reset
+	for (uint32 i = 0; i <= pools.poolIndex && i < pools.pools.size(); i++)
+		renderer::globalRenderSystem->resetDescriptorPool(pools.pools[i], 0);
+
+	pools.poolIndex = 0;
 }
 
-vk::DescriptorSet DescriptorPools::allocate(const GraphicsProgram& program, uint32 layoutIndex, bool variableCount) {
+vk::DescriptorSet TransientDescriptorPools::allocate(uint32 frame, const Program& program, uint32 layoutIndex, bool variableCount) {
+	auto& pools = frames[frame];
+
 	VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountAlloc {
 		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO,
 		nullptr,
@@ -1454,7 +2646,7 @@ vk::DescriptorSet DescriptorPools::allocate(const GraphicsProgram& program, uint
 	VkDescriptorSetAllocateInfo allocInfo {
 		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
 		(variableCount) ? &variableCountAlloc : nullptr,
-		descriptorPools[allocationIndex],
+		pools.pools[pools.poolIndex],
 		1,
 		&program.descriptorSetLayouts[layoutIndex].get()
 	};
@@ -1462,27 +2654,17 @@ vk::DescriptorSet DescriptorPools::allocate(const GraphicsProgram& program, uint
 	VkResult r;
 	vk::DescriptorSet descriptorSet = vk::DescriptorSet(renderer::globalRenderSystem->device, allocInfo, r);
 
-	while (descriptorSet.get() == VK_NULL_HANDLE) {
-		switch (r) {
-			case VK_ERROR_FRAGMENTED_POOL:
-			case VK_ERROR_OUT_OF_POOL_MEMORY:
-				++allocationIndex;
-				
-				if (allocationIndex >= descriptorPools.size()) {
-					allocInfo.descriptorPool = descriptorPools.emplaceBack(renderer::globalRenderSystem->device, createInfo).get();
-				} else {
-					allocInfo.descriptorPool = descriptorPools[allocationIndex];
-				}
-
-				descriptorSet = vk::DescriptorSet(renderer::globalRenderSystem->device, allocInfo, r);
-
-				break;
+	if (descriptorSet.get() == VK_NULL_HANDLE && (r == VK_ERROR_OUT_OF_POOL_MEMORY || r == VK_ERROR_FRAGMENTED_POOL)) {
+		// the pools are never probed again, the full pool stays full until the frame is reset
+		if (++pools.poolIndex == pools.pools.size()) pools.pools.emplaceBack(renderer::globalRenderSystem->device, createInfo);
 
-			default:
-				VULKAN_ASSERT(r, "allocate Vulkan descriptor set");
-		}
+		allocInfo.descriptorPool = pools.pools[pools.poolIndex];
+		descriptorSet = vk::DescriptorSet(renderer::globalRenderSystem->device, allocInfo, r);
 	}
 
+	// a set which does not fit into an empty pool never fits into any of the pools
+	VULKAN_ASSERT(r, "allocate transient Vulkan descriptor set");
+
 	return descriptorSet;
 }
 
@@ -1510,98 +2692,135 @@ Shader::Shader(Type type, const lsd::Vector<char>& source) : shaderSrc(source),
 	module = vk::ShaderModule(renderer::globalRenderSystem->device, createInfo);
 }
 
-lsd::String GraphicsProgram::Builder::hash() const noexcept {
+bool Program::Builder::equalLayout(const Builder& other) const noexcept {
+	if (m_bindings.size() != other.m_bindings.size()) return false;
+
+	for (uint32 i = 0; i < m_bindings.size(); i++) {
+		if (!equalBytes(m_bindings[i], other.m_bindings[i]) || !equalBytes(m_bindingFlags[i], other.m_bindingFlags[i])) return false;
+	}
+
+	return equalBytes(m_pushConstants, other.m_pushConstants);
+}
+
+Program::Program(const Builder& builder) {
+	auto setCount = builder.m_bindings.size();
+
+	lsd::Vector<VkDescriptorSetLayout> tmpLayouts(setCount);
+
+	descriptorSetLayouts.resize(setCount);
+	descriptorSetSizes.resize(setCount);
+	dynamicDescriptorCounts.resize(setCount);
+
+	for (uint32 i = 0; i < setCount; i++) {
+		const auto& bindingFlags = builder.m_bindingFlags[i];
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo {
+			VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+			nullptr,
+			static_cast<uint32>(bindingFlags.size()),
+			bindingFlags.data()
+		};
+
+		VkDescriptorBindingFlags combinedFlags = 0;
+		for (auto flags : bindingFlags) combinedFlags |= flags;
+
+		VkDescriptorSetLayoutCreateInfo createInfo {
+			VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+			(combinedFlags != 0) ? &bindingFlagsCreateInfo : nullptr,
+			(combinedFlags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT : VkDescriptorSetLayoutCreateFlags(0),
+			static_cast<uint32>(builder.m_bindings[i].size()),
+			builder.m_bindings[i].data()
+		};
+
+		// only the last binding of a set may have a variable count
+		dynamicDescriptorCounts[i] = (!bindingFlags.empty() && (bindingFlags.back() & VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT)) ? 
+			builder.m_bindings[i].back().descriptorCount : 
+			0;
+
+		descriptorSetSizes[i] = DescriptorPools::setSize(createInfo);
+		tmpLayouts[i] = (descriptorSetLayouts[i] = vk::DescriptorSetLayout(renderer::globalRenderSystem->device, createInfo)).get();
+	}
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{
+		VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		nullptr,
+		0,
+		static_cast<uint32>(setCount),
+		tmpLayouts.data(),
+		static_cast<uint32>(builder.m_pushConstants.size()),
+		builder.m_pushConstants.data()
+	};
+
+	pipelineLayout = vk::PipelineLayout(renderer::globalRenderSystem->device, pipelineLayoutCreateInfo);
+}
+
+uint64 GraphicsProgram::Builder::hash() const noexcept {
+	return hashCombine(
+		layoutHash(),
+		reinterpret_cast<uintptr>((m_vertexShader) ? m_vertexShader : renderer::globalRenderSystem->defaultVertexShader),
+		reinterpret_cast<uintptr>((m_fragmentShader) ? m_fragmentShader : renderer::globalRenderSystem->defaultFragmentShader)
+	);
+}
+
+bool GraphicsProgram::Builder::operator==(const Builder& other) const noexcept {
 	return 
-		lsd::String(m_bindingHash) + 
-		m_pushConstantHash + 
-		lsd::toString(reinterpret_cast<uintptr>((m_vertexShader) ? m_vertexShader : renderer::globalRenderSystem->defaultVertexShader)) + 
-		lsd::toString(reinterpret_cast<uintptr>((m_fragmentShader) ? m_fragmentShader : renderer::globalRenderSystem->defaultFragmentShader));
+		equalLayout(other) &&
+		((m_vertexShader) ? m_vertexShader : renderer::globalRenderSystem->defaultVertexShader) == 
+			((other.m_vertexShader) ? other.m_vertexShader : renderer::globalRenderSystem->defaultVertexShader) &&
+		((m_fragmentShader) ? m_fragmentShader : renderer::globalRenderSystem->defaultFragmentShader) == 
+			((other.m_fragmentShader) ? other.m_fragmentShader : renderer::globalRenderSystem->defaultFragmentShader);
 }
 
 GraphicsProgram::GraphicsProgram() : 
-	dynamicDescriptorCounts({ config::maxDynamicBindings, 0 }),
 	vertexShader(renderer::globalRenderSystem->defaultVertexShader), 
 	fragmentShader(renderer::globalRenderSystem->defaultFragmentShader), 
 	hash(Builder().hash()) {
-	static constexpr lsd::Array<VkDescriptorBindingFlags, 8> bindingFlags = {{ 
-		0,
-		0,
-		0,
-		0,
-		0,
+	static constexpr lsd::Array<VkDescriptorBindingFlags, 2> bindingFlags = {{ 
 		0,
-		0,
-		VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT
+		VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
 	}};
-	static constexpr lsd::Array<VkDescriptorSetLayoutBindingFlagsCreateInfo, 1> bindingExt {{
+	static constexpr lsd::Array<VkDescriptorSetLayoutBindingFlagsCreateInfo, 2> bindingExt {{
 		{
 			VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
 			nullptr,
 			bindingFlags.size(),
 			bindingFlags.data()
+		},
+		{
+			VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+			nullptr,
+			0,
+			nullptr
 		}
 	}};
-	static constexpr lsd::Array<lsd::Dynarray<VkDescriptorSetLayoutBinding, 8>, 1> bindings {{
+	static constexpr lsd::Array<lsd::Dynarray<VkDescriptorSetLayoutBinding, 8>, 2> bindings {{
 		{{
-			{
-				0,
-				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-				1,
-				VK_SHADER_STAGE_VERTEX_BIT,
-				nullptr
-			},
-			{ 
-				1,
-				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-				1,
-				VK_SHADER_STAGE_VERTEX_BIT,
-				nullptr
-			},
-			{ 
-				2,
-				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-				1,
-				VK_SHADER_STAGE_FRAGMENT_BIT,
-				nullptr
-			},
-			{ 
-				3,
-				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			{	// data of all materials
+				MaterialTable::materialBinding,
+				VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
 				1,
-				VK_SHADER_STAGE_FRAGMENT_BIT,
+				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
 				nullptr
 			},
-			{ 
-				4,
+			{	// textures of all materials
+				MaterialTable::textureBinding,
 				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-				1,
-				VK_SHADER_STAGE_FRAGMENT_BIT,
+				config::bindlessTextureCapacity,
+				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
 				nullptr
-			},
-			{
-				5,
-				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			}
+		}},
+		{{
+			{	// per instance data of indirect draws
+				0,
+				VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
 				1,
 				VK_SHADER_STAGE_VERTEX_BIT,
 				nullptr
-			},
-			{ 
-				6,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-				1,
-				VK_SHADER_STAGE_FRAGMENT_BIT,
-				nullptr
-			},
-			{ 
-				7,
-				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-				config::maxDynamicBindings,
-				VK_SHADER_STAGE_FRAGMENT_BIT,
-				nullptr
 			}
 		}}
 	}};
-	static constexpr lsd::Array<VkPushConstantRange, bindings.size()> pushConstants {{
+	static constexpr lsd::Array<VkPushConstantRange, 1> pushConstants {{
 		{
 			VK_SHADER_STAGE_VERTEX_BIT,
 			0,
@@ -1612,26 +2831,34 @@ GraphicsProgram::GraphicsProgram() :
 	lsd::Array<VkDescriptorSetLayout, bindings.size()> tmpLayouts;
 
 	descriptorSetLayouts.resize(bindings.size());
+	descriptorSetSizes.resize(bindings.size());
+
+	dynamicDescriptorCounts.pushBack(config::bindlessTextureCapacity);
+	dynamicDescriptorCounts.pushBack(0);
 
 	for (uint32 i = 0; i < bindings.size(); i++) {
+		auto data = bindings[i];
+
 		VkDescriptorSetLayoutCreateInfo createInfo{
 			VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
 			&bindingExt[i],
 			0,
-			static_cast<uint32>(bindings[i].size()),
-			bindings[i].data()
+			static_cast<uint32>(data.size()),
+			data.data()
 		};
 
-		if (i == 0) {
+		if (i == MaterialTable::descriptorSetIndex) {
 			createInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
 
-			if (config::maxDynamicBindings >= renderer::globalRenderSystem->descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers - 3) {
-				auto data = bindings[i];
-				data[7].descriptorCount = (dynamicDescriptorCounts[0] = renderer::globalRenderSystem->descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers - 3);
-				createInfo.pBindings = data.data();
+			const auto& properties = renderer::globalRenderSystem->descriptorIndexingProperties;
+			auto textureLimit = std::min(properties.maxPerStageDescriptorUpdateAfterBindSamplers, properties.maxPerStageDescriptorUpdateAfterBindSampledImages);
+
+			if (config::bindlessTextureCapacity > textureLimit) {
+				data[MaterialTable::textureBinding].descriptorCount = (dynamicDescriptorCounts[i] = textureLimit);
 			}
 		}
 
+		descriptorSetSizes[i] = DescriptorPools::setSize(createInfo);
 		tmpLayouts[i] = (descriptorSetLayouts[i] = vk::DescriptorSetLayout(renderer::globalRenderSystem->device, createInfo)).get();
 	}
 
@@ -1649,66 +2876,55 @@ GraphicsProgram::GraphicsProgram() :
 }
 
 GraphicsProgram::GraphicsProgram(const Builder& builder) : 
+	Program(builder),
 	vertexShader(builder.m_vertexShader), 
 	fragmentShader(builder.m_fragmentShader), 
-	hash(builder.hash()) {
-	auto setCount = builder.m_bindings.size();
-
-	lsd::Vector<VkDescriptorSetLayout> tmpLayouts(setCount);
+	builder(builder),
+	hash(builder.hash()) { }
 
-	descriptorSetLayouts.resize(setCount);
-	dynamicDescriptorCounts.resize(setCount);
+uint64 ComputeProgram::Builder::hash() const noexcept {
+	return hashCombine(layoutHash(), reinterpret_cast<uintptr>(m_computeShader));
+}
 
-	for (uint32 i = 0; i < setCount; i++) {
-		VkDescriptorSetLayoutCreateInfo createInfo {
-			VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-			&builder.m_bindingFlagsCreateInfo[i],
-			0,
-			static_cast<uint32>(builder.m_bindings[i].size()),
-			builder.m_bindings[i].data()
-		};
+bool ComputeProgram::Builder::operator==(const Builder& other) const noexcept {
+	return equalLayout(other) && m_computeShader == other.m_computeShader;
+}
 
-		dynamicDescriptorCounts[i] = builder.m_bindingFlagsCreateInfo[i].bindingCount;
+ComputeProgram::ComputeProgram(const Builder& builder) : 
+	Program(builder),
+	computeShader(builder.m_computeShader),
+	builder(builder),
+	hash(builder.hash()) {
+	ASSERT(computeShader && computeShader->type == Shader::Type::compute, "lyra::vulkan::ComputeProgram::ComputeProgram(): A compute program requires a compute shader!");
+}
 
-		tmpLayouts[i] = (descriptorSetLayouts[i] = vk::DescriptorSetLayout(renderer::globalRenderSystem->device, createInfo)).get();
-	}
+uint64 GraphicsPipeline::Builder::hash() const noexcept {
+	return hashCombine(
+		structuralHash(),
+		reinterpret_cast<uintptr>((m_renderTarget) ? m_renderTarget : renderer::globalRenderSystem->defaultRenderTarget),
+		reinterpret_cast<uintptr>((m_graphicsProgram) ? m_graphicsProgram : renderer::globalRenderSystem->defaultGraphicsProgram)
+	);
+}
 
-	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{
-		VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-		nullptr,
-		0,
-		static_cast<uint32>(setCount),
-		tmpLayouts.data(),
-		static_cast<uint32>(builder.m_pushConstants.size()),
-		builder.m_pushConstants.data()
-	};
+bool GraphicsPipeline::Builder::operator==(const Builder& other) const noexcept {
+	if (m_viewport.index() != other.m_viewport.index() || m_scissor.index() != other.m_scissor.index()) return false;
 
-	pipelineLayout = vk::PipelineLayout(renderer::globalRenderSystem->device, pipelineLayoutCreateInfo);
-}
+	if (std::holds_alternative<VkViewport>(m_viewport) && !equalBytes(std::get<VkViewport>(m_viewport), std::get<VkViewport>(other.m_viewport))) return false;
+	if (std::holds_alternative<VkRect2D>(m_scissor) && !equalBytes(std::get<VkRect2D>(m_scissor), std::get<VkRect2D>(other.m_scissor))) return false;
 
-lsd::String GraphicsPipeline::Builder::hash() const noexcept {
 	return 
-		lsd::toString(std::holds_alternative<bool>(m_viewport)) + 
-		lsd::toString(std::holds_alternative<bool>(m_scissor)) +
-		lsd::toString(m_topology) + 
-		lsd::toString(m_renderMode) + 
-		lsd::toString(m_polyFrontFace) + 
-		lsd::toString(m_sampleCount) + 
-		(
-			std::holds_alternative<bool>(m_sampleShading) ? 
-				lsd::toString(std::get<bool>(m_sampleShading)) : 
-				lsd::toString(std::get<float32>(m_sampleShading))
-		) + 
-		(std::holds_alternative<bool>(m_depthStencil) ? 
-			lsd::toString(std::get<bool>(m_sampleShading)) : 
-			(
-				lsd::toString(std::get<Builder::DepthStencil>(m_depthStencil).write) + 
-					lsd::toString(std::get<Builder::DepthStencil>(m_depthStencil).compare)
-			)
-		) + 
-		lsd::toString(m_blendAttachments.size()) +
-		lsd::toString(reinterpret_cast<uintptr>((m_renderTarget) ? m_renderTarget : renderer::globalRenderSystem->defaultRenderTarget)) + 
-		lsd::toString(reinterpret_cast<uintptr>((m_graphicsProgram) ? m_graphicsProgram : renderer::globalRenderSystem->defaultGraphicsProgram));
+		m_topology == other.m_topology &&
+		m_renderMode == other.m_renderMode &&
+		m_culling == other.m_culling &&
+		m_polyFrontFace == other.m_polyFrontFace &&
+		m_sampleCount == other.m_sampleCount &&
+		m_sampleShading == other.m_sampleShading &&
+		m_depthStencil == other.m_depthStencil &&
+		equalBytes(m_blendAttachments, other.m_blendAttachments) &&
+		((m_renderTarget) ? m_renderTarget : renderer::globalRenderSystem->defaultRenderTarget) == 
+			((other.m_renderTarget) ? other.m_renderTarget : renderer::globalRenderSystem->defaultRenderTarget) &&
+		((m_graphicsProgram) ? m_graphicsProgram : renderer::globalRenderSystem->defaultGraphicsProgram) == 
+			((other.m_graphicsProgram) ? other.m_graphicsProgram : renderer::globalRenderSystem->defaultGraphicsProgram);
 }
 
 GraphicsPipeline::GraphicsPipeline() : 
@@ -1719,8 +2935,8 @@ GraphicsPipeline::GraphicsPipeline() :
 	dynamicViewport(VkViewport()),
 	dynamicScissor(VkRect2D()),
 	program(renderer::globalRenderSystem->defaultGraphicsProgram) {
-	static constexpr VkVertexInputBindingDescription bindingDescription = Mesh::Vertex::bindingDescription();
-	static constexpr lsd::Array<VkVertexInputAttributeDescription, 4> attributeDescriptions = Mesh::Vertex::attributeDescriptions();
+	static constexpr VkVertexInputBindingDescription bindingDescription = Mesh::PackedVertex::bindingDescription();
+	static constexpr lsd::Array<VkVertexInputAttributeDescription, 4> attributeDescriptions = Mesh::PackedVertex::attributeDescriptions();
 	static constexpr VkPipelineVertexInputStateCreateInfo vertexInputInfo {
 		VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
 		nullptr,
@@ -1844,6 +3060,7 @@ GraphicsPipeline::GraphicsPipeline() :
 	};
 
 	pipeline = vk::GraphicsPipeline(renderer::globalRenderSystem->device, renderer::globalRenderSystem->pipelineCache, createInfo);
+	m_compiled = true;
 }
 
 GraphicsPipeline::GraphicsPipeline(const Builder& builder) : 
@@ -1851,9 +3068,51 @@ GraphicsPipeline::GraphicsPipeline(const Builder& builder) :
 		((builder.m_renderTarget) ? builder.m_renderTarget : renderer::globalRenderSystem->defaultRenderTarget),
 		builder.hash()
 	), 
-	program((builder.m_graphicsProgram) ? builder.m_graphicsProgram : renderer::globalRenderSystem->defaultGraphicsProgram) {
-	static constexpr VkVertexInputBindingDescription bindingDescription = Mesh::Vertex::bindingDescription();
-	static constexpr lsd::Array<VkVertexInputAttributeDescription, 4> attributeDescriptions = Mesh::Vertex::attributeDescriptions();
+	dynamicViewport(std::holds_alternative<bool>(builder.m_viewport) ? std::variant<bool, VkViewport>(VkViewport()) : std::variant<bool, VkViewport>(false)),
+	dynamicScissor(std::holds_alternative<bool>(builder.m_scissor) ? std::variant<bool, VkRect2D>(VkRect2D()) : std::variant<bool, VkRect2D>(false)),
+	program((builder.m_graphicsProgram) ? builder.m_graphicsProgram : renderer::globalRenderSystem->defaultGraphicsProgram),
+	builder(builder) {
+	compile();
+	m_compiled = true;
+}
+
+GraphicsPipeline::GraphicsPipeline(const Builder& builder, ThreadPool& workers, const GraphicsPipeline* fallback) : 
+	Pipeline(
+		((builder.m_renderTarget) ? builder.m_renderTarget : renderer::globalRenderSystem->defaultRenderTarget),
+		builder.hash()
+	), 
+	dynamicViewport(std::holds_alternative<bool>(builder.m_viewport) ? std::variant<bool, VkViewport>(VkViewport()) : std::variant<bool, VkViewport>(false)),
+	dynamicScissor(std::holds_alternative<bool>(builder.m_scissor) ? std::variant<bool, VkRect2D>(VkRect2D()) : std::variant<bool, VkRect2D>(false)),
+	program((builder.m_graphicsProgram) ? builder.m_graphicsProgram : renderer::globalRenderSystem->defaultGraphicsProgram),
+	builder(builder) {
+	// the fallback is bound in place of this pipeline, so it has to share the layout, render pass and dynamic state
+	if (
+		fallback && 
+		fallback->compiled() &&
+		fallback->program == program && 
+		fallback->renderTarget == renderTarget &&
+		fallback->dynamicViewport.index() == dynamicViewport.index() &&
+		fallback->dynamicScissor.index() == dynamicScissor.index()
+	) this->fallback = fallback;
+
+	// compiles from the copy of the builder, since the one passed in usually does not outlive the compilation
+	m_compilation = workers.enqueue([this]() {
+		compile();
+		m_compiled.store(true, std::memory_order_release);
+	});
+}
+
+GraphicsPipeline::~GraphicsPipeline() {
+	wait();
+}
+
+void GraphicsPipeline::wait() const {
+	if (m_compilation.valid()) m_compilation.wait();
+}
+
+void GraphicsPipeline::compile() {
+	static constexpr VkVertexInputBindingDescription bindingDescription = Mesh::PackedVertex::bindingDescription();
+	static constexpr lsd::Array<VkVertexInputAttributeDescription, 4> attributeDescriptions = Mesh::PackedVertex::attributeDescriptions();
 	static constexpr VkPipelineVertexInputStateCreateInfo vertexInputInfo {
 		VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
 		nullptr,
@@ -1969,7 +3228,6 @@ GraphicsPipeline::GraphicsPipeline(const Builder& builder) :
 	// viewport
 	if (std::holds_alternative<bool>(builder.m_viewport)) {
 		dynamicState.pushBack(VK_DYNAMIC_STATE_VIEWPORT);
-		dynamicViewport = VkViewport();
 	} else {
 		viewportState.viewportCount = 1;
 		viewportState.pViewports = &std::get<VkViewport>(builder.m_viewport);
@@ -1977,7 +3235,6 @@ GraphicsPipeline::GraphicsPipeline(const Builder& builder) :
 	// scissor
 	if (std::holds_alternative<bool>(builder.m_scissor)) {
 		dynamicState.pushBack(VK_DYNAMIC_STATE_SCISSOR);
-		dynamicScissor = VkRect2D();
 	} else {
 		viewportState.scissorCount = 1;
 		viewportState.pScissors = &std::get<VkRect2D>(builder.m_scissor);
@@ -2019,18 +3276,47 @@ GraphicsPipeline::GraphicsPipeline(const Builder& builder) :
 }
 
 void GraphicsPipeline::bind() const {
-	renderer::globalRenderSystem->commandQueue->activeCommandBuffer->bindPipeline(static_cast<VkPipelineBindPoint>(bindPoint), pipeline);
+	bind(*renderer::globalRenderSystem->commandQueue->activeCommandBuffer);
 	renderer::globalRenderSystem->commandQueue->pipelineStageFlags.pushBack(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+}
+
+void GraphicsPipeline::bind(const CommandQueue::CommandBuffer& commandBuffer) const {
+	commandBuffer.bindPipeline(static_cast<VkPipelineBindPoint>(bindPoint), compiled() ? pipeline : fallback->pipeline);
 
 	if (std::holds_alternative<VkViewport>(dynamicViewport)) {
-		renderer::globalRenderSystem->commandQueue->activeCommandBuffer->setViewport(std::get<VkViewport>(dynamicViewport));
+		commandBuffer.setViewport(std::get<VkViewport>(dynamicViewport));
 	}
 
 	if (std::holds_alternative<VkRect2D>(dynamicScissor)) {
-		renderer::globalRenderSystem->commandQueue->activeCommandBuffer->setScissor(std::get<VkRect2D>(dynamicScissor));
+		commandBuffer.setScissor(std::get<VkRect2D>(dynamicScissor));
 	}
 }
 
+ComputePipeline::ComputePipeline(const ComputeProgram& program) : 
+	Pipeline(nullptr, program.hash),
+	program(&program) {
+	VkComputePipelineCreateInfo createInfo {
+		VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+		nullptr,
+		0,
+		program.computeShader->stageCreateInfo(),
+		program.pipelineLayout,
+		VK_NULL_HANDLE,
+		0
+	};
+
+	pipeline = vk::ComputePipeline(renderer::globalRenderSystem->device, renderer::globalRenderSystem->pipelineCache, createInfo);
+}
+
+void ComputePipeline::bind() const {
+	bind(*renderer::globalRenderSystem->commandQueue->activeCommandBuffer);
+	renderer::globalRenderSystem->commandQueue->pipelineStageFlags.pushBack(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+}
+
+void ComputePipeline::bind(const CommandQueue::CommandBuffer& commandBuffer) const {
+	commandBuffer.bindPipeline(static_cast<VkPipelineBindPoint>(bindPoint), pipeline);
+}
+
 ImGuiRenderer::ImGuiRenderer() {
 	lsd::Vector<const Image*> swapchainImages;
 	swapchainImages.reserve(renderer::globalRenderSystem->swapchain->images.size());
@@ -2079,21 +3365,29 @@ ImGuiRenderer::ImGuiRenderer() {
 		}
 	});
 
-	lsd::Vector<vulkan::DescriptorPools::Size> poolSizes ({
-		{ vulkan::DescriptorSets::Type::sampler, 512 },
-		{ vulkan::DescriptorSets::Type::imageSampler, 512 },
-		{ vulkan::DescriptorSets::Type::sampledImage, 512 },
-		{ vulkan::DescriptorSets::Type::storageImage, 512 },
-		{ vulkan::DescriptorSets::Type::texelBuffer, 512 },
-		{ vulkan::DescriptorSets::Type::texelStorageBuffer, 512 },
-		{ vulkan::DescriptorSets::Type::uniformBuffer, 512 },
-		{ vulkan::DescriptorSets::Type::storageBuffer, 512 },
-		{ vulkan::DescriptorSets::Type::dynamicUniformBuffer, 512 },
-		{ vulkan::DescriptorSets::Type::dynamicStorageBuffer, 512 },
-		{ vulkan::DescriptorSets::Type::inputAttachment, 512 }
-	});
+	static constexpr lsd::Array<VkDescriptorPoolSize, 11> poolSizes {{
+		{ VK_DESCRIPTOR_TYPE_SAMPLER, 512 },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 512 },
+		{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 512 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 512 },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 512 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 512 },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 512 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 512 },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 512 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 512 },
+		{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 512 }
+	}};
 
-	m_descriptorPools = vulkan::DescriptorPools(poolSizes);
+	// ImGui frees its sets individually, so it gets its own pool
+	m_descriptorPool = vulkan::vk::DescriptorPool(renderer::globalRenderSystem->device, VkDescriptorPoolCreateInfo {
+		VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+		nullptr,
+		VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+		512,
+		static_cast<uint32>(poolSizes.size()),
+		poolSizes.data()
+	});
 
 	ImGui_ImplSDL3_InitForVulkan(renderer::globalWindow->window);
 	ImGui_ImplVulkan_InitInfo initInfo{
@@ -2102,7 +3396,7 @@ ImGuiRenderer::ImGuiRenderer() {
 		renderer::globalRenderSystem->device,
 		renderer::globalRenderSystem->queueFamilies.graphicsFamilyIndex,
 		renderer::globalRenderSystem->graphicsQueue,
-		m_descriptorPools.descriptorPools[0],
+		m_descriptorPool,
 		//m_renderTarget.renderPass,
 		renderer::globalRenderSystem->defaultRenderTarget->renderPass,
 		2,
@@ -0,0 +1,190 @@
+#include <Math/Culling.h>
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+#define LYRA_CULLING_SIMD
+#include <immintrin.h>
+#endif
+
+namespace lyra {
+
+namespace {
+
+#if defined(__AVX__)
+constexpr size_type batchSize = 8;
+#else
+constexpr size_type batchSize = 4;
+#endif
+
+}
+
+BoundingVolume BoundingVolume::fromPoints(const glm::vec3* points, size_type count, size_type stride) {
+	if (count == 0) return { };
+
+	auto point = [points, stride](size_type i) -> const glm::vec3& {
+		return *reinterpret_cast<const glm::vec3*>(reinterpret_cast<const char*>(points) + i * stride);
+	};
+
+	auto min = point(0);
+	auto max = point(0);
+
+	for (size_type i = 1; i < count; i++) {
+		min = glm::min(min, point(i));
+		max = glm::max(max, point(i));
+	}
+
+	BoundingVolume volume;
+	volume.center = (min + max) * 0.5f;
+	volume.extent = (max - min) * 0.5f;
+
+	// the sphere around the center of the box is usually a lot tighter than the sphere enclosing the box
+	float32 radiusSquared = 0.0f;
+	for (size_type i = 0; i < count; i++) {
+		auto offset = point(i) - volume.center;
+		radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+	}
+
+	volume.radius = std::sqrt(radiusSquared);
+
+	return volume;
+}
+
+bool Meshlet::backfacing(const glm::vec3& cameraPosition) const noexcept {
+	auto direction = center - cameraPosition;
+	return glm::dot(direction, coneAxis) >= coneCutoff * glm::length(direction) + radius;
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+	auto row = [&viewProjection](glm::length_t i) {
+		return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+	};
+
+	planes[0] = row(3) + row(0);
+	planes[1] = row(3) - row(0);
+	planes[2] = row(3) + row(1);
+	planes[3] = row(3) - row(1);
+	planes[4] = row(2);
+	planes[5] = row(3) - row(2);
+
+	// normalized, so the distance to a plane can be compared against the radius of a sphere
+	for (auto& plane : planes) plane /= glm::length(glm::vec3(plane));
+}
+
+bool Frustum::intersects(const glm::vec3& center, float32 radius) const noexcept {
+	for (const auto& plane : planes) {
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) return false;
+	}
+
+	return true;
+}
+
+void CullingVolumes::clear() {
+	m_x.clear();
+	m_y.clear();
+	m_z.clear();
+	m_radius.clear();
+
+	m_size = 0;
+}
+
+void CullingVolumes::reserve(size_type count) {
+	count = (count + batchSize - 1) / batchSize * batchSize;
+
+	m_x.reserve(count);
+	m_y.reserve(count);
+	m_z.reserve(count);
+	m_radius.reserve(count);
+}
+
+void CullingVolumes::pushBack(const BoundingVolume& volume, const glm::mat4& transform) {
+	if (m_size == m_x.size()) {
+		// a padding sphere with the lowest possible radius lies behind every plane
+		for (size_type i = 0; i < batchSize; i++) {
+			m_x.pushBack(0.0f);
+			m_y.pushBack(0.0f);
+			m_z.pushBack(0.0f);
+			m_radius.pushBack(std::numeric_limits<float32>::lowest());
+		}
+	}
+
+	auto center = transform * glm::vec4(volume.center, 1.0f);
+	// non uniform scale stretches the sphere along its largest axis
+	auto scale = std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])) });
+
+	m_x[m_size] = center.x;
+	m_y[m_size] = center.y;
+	m_z[m_size] = center.z;
+	m_radius[m_size] = volume.radius * scale;
+
+	m_size++;
+}
+
+void CullingVolumes::cull(const Frustum& frustum, lsd::Vector<uint32>& visible) const {
+#ifdef LYRA_CULLING_SIMD
+	visible.resize(m_size);
+	auto output = visible.data();
+
+	for (size_type i = 0; i < m_x.size(); i += batchSize) {
+#if defined(__AVX__)
+		auto x = _mm256_loadu_ps(m_x.data() + i);
+		auto y = _mm256_loadu_ps(m_y.data() + i);
+		auto z = _mm256_loadu_ps(m_z.data() + i);
+		auto radius = _mm256_loadu_ps(m_radius.data() + i);
+
+		auto inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+		for (const auto& plane : frustum.planes) {
+			auto distance = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane.x)), _mm256_mul_ps(y, _mm256_set1_ps(plane.y))),
+				_mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(plane.z)), _mm256_add_ps(radius, _mm256_set1_ps(plane.w)))
+			);
+
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+		}
+
+		auto mask = static_cast<uint32>(_mm256_movemask_ps(inside));
+#else
+		auto x = _mm_loadu_ps(m_x.data() + i);
+		auto y = _mm_loadu_ps(m_y.data() + i);
+		auto z = _mm_loadu_ps(m_z.data() + i);
+		auto radius = _mm_loadu_ps(m_radius.data() + i);
+
+		auto inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+		for (const auto& plane : frustum.planes) {
+			auto distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+				_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_add_ps(radius, _mm_set1_ps(plane.w)))
+			);
+
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+		}
+
+		auto mask = static_cast<uint32>(_mm_movemask_ps(inside));
+#endif
+
+		// compacts the visible lanes, the padding lanes never pass the test
+		while (mask != 0) {
+			*output++ = static_cast<uint32>(i + std::countr_zero(mask));
+			mask &= mask - 1;
+		}
+	}
+
+	visible.resize(output - visible.data());
+#else
+	cullScalar(frustum, visible);
+#endif
+}
+
+void CullingVolumes::cullScalar(const Frustum& frustum, lsd::Vector<uint32>& visible) const {
+	visible.clear();
+
+	for (size_type i = 0; i < m_size; i++) {
+		if (frustum.intersects({ m_x[i], m_y[i], m_z[i] }, m_radius[i])) visible.pushBack(static_cast<uint32>(i));
+	}
+}
+
+} // namespace lyra
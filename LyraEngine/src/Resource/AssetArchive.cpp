@@ -0,0 +1,53 @@
+#include <Resource/AssetArchive.h>
+
+#include <Common/Hash.h>
+#include <Common/Logger.h>
+
+#include <algorithm>
+
+namespace lyra {
+
+namespace resource {
+
+AssetArchive::AssetArchive(const std::filesystem::path& path) : m_file(path) {
+	if (m_file.size() < sizeof(Header)) return;
+
+	auto header = reinterpret_cast<const Header*>(m_file.data());
+	if (header->magic != magic || header->version != version || header->alignment != alignment) {
+		log::warning("lyra::resource::AssetArchive::AssetArchive(): The archive at path: {} has an invalid header or an unsupported version!", path.string());
+		return;
+	}
+
+	if (header->tocOffset + header->entryCount * sizeof(Entry) > m_file.size() || header->stringsOffset + header->stringsSize > m_file.size()) {
+		log::warning("lyra::resource::AssetArchive::AssetArchive(): The archive at path: {} is truncated!", path.string());
+		return;
+	}
+
+	m_header = header;
+	m_entries = reinterpret_cast<const Entry*>(m_file.data() + header->tocOffset);
+	m_strings = m_file.data() + header->stringsOffset;
+}
+
+const AssetArchive::Entry* AssetArchive::find(std::string_view path) const noexcept {
+	if (!m_header) return nullptr;
+
+	auto hash = hashBytes(path);
+	auto end = m_entries + m_header->entryCount;
+
+	for (auto it = std::lower_bound(m_entries, end, hash, [](const Entry& e, uint64 h) { return e.hash < h; }); it != end && it->hash == hash; it++) {
+		if (std::string_view(m_strings + it->pathOffset, it->pathSize) == path) return it;
+	}
+
+	return nullptr;
+}
+
+MappedFile AssetArchive::entry(std::string_view path) const {
+	auto e = find(path);
+	if (!e) return MappedFile();
+
+	return MappedFile(m_file, e->offset, e->size);
+}
+
+} // namespace resource
+
+} // namespace lyra
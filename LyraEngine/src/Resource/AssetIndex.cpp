@@ -0,0 +1,202 @@
+#include <Resource/AssetIndex.h>
+
+#include <Common/Hash.h>
+#include <Common/Logger.h>
+
+#include <bit>
+#include <cstring>
+
+namespace lyra {
+
+namespace resource {
+
+namespace {
+
+constexpr size_type alignUp(size_type value, size_type alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// for metadata which was added later and may be missing from older project files
+uint32 childOr(const lsd::Json& js, std::string_view name, uint32 fallback) {
+	for (const auto& child : js) {
+		if (name == child->name().cStr()) return child->get<uint32>();
+	}
+
+	return fallback;
+}
+
+}
+
+AssetIndex::AssetIndex(const std::filesystem::path& path) : m_file(path) {
+	setup(m_file.data(), m_file.size());
+}
+
+AssetIndex::AssetIndex(const lsd::Json& projectFile) : m_buffer(build(projectFile)) {
+	setup(m_buffer.data(), m_buffer.size());
+}
+
+lsd::Vector<char> AssetIndex::build(const lsd::Json& projectFile) {
+	lsd::Vector<Record> records;
+	lsd::Vector<uint32> blocks;
+	lsd::Vector<char> strings;
+
+	for (const auto& asset : projectFile) {
+		std::string_view path(asset->name().cStr());
+		const auto& js = *asset;
+
+		Record record { };
+		record.hash = hashBytes(path);
+		record.pathOffset = static_cast<uint32>(strings.size());
+		record.pathSize = static_cast<uint32>(path.size());
+		record.kind = kind(path);
+
+		for (auto c : path) strings.pushBack(c);
+
+		switch (record.kind) {
+			case Kind::texture:
+				record.uncompressed = js.child("Uncompressed").get<uint32>();
+				record.type = js.child("Type").get<uint32>();
+				record.width = js.child("Width").get<uint32>();
+				record.height = js.child("Height").get<uint32>();
+				record.alpha = js.child("Alpha").get<uint32>();
+				record.mipmap = js.child("Mipmap").get<uint32>();
+				record.dimension = js.child("Dimension").get<uint32>();
+				record.wrap = js.child("Wrap").get<uint32>();
+				record.format = childOr(js, "Format", 0);
+
+				break;
+
+			case Kind::mesh:
+				record.uncompressed = js.child("Uncompressed").get<uint32>();
+				record.type = childOr(js, "Type", 0); // the vertex layout the mesh was packed with
+				record.blockOffset = static_cast<uint32>(blocks.size());
+
+				if (record.uncompressed != 0) { // the block arrays only exist after the mesh was built
+					for (const auto& block : js.child("VertexBlocks").get<lsd::Json::array_type>()) blocks.pushBack(block->get<uint32>());
+					for (const auto& block : js.child("IndexBlocks").get<lsd::Json::array_type>()) blocks.pushBack(block->get<uint32>());
+
+					record.vertexBlockCount = static_cast<uint32>(js.child("VertexBlocks").get<lsd::Json::array_type>().size());
+					record.indexBlockCount = static_cast<uint32>(js.child("IndexBlocks").get<lsd::Json::array_type>().size());
+				}
+
+				break;
+
+			case Kind::shader:
+				record.type = js.child("Type").get<uint32>();
+
+				break;
+
+			default:
+				break;
+		}
+
+		records.pushBack(record);
+	}
+
+	// keep the table at most half full, so probe sequences stay short
+	auto bucketCount = static_cast<uint32>(std::bit_ceil(std::max<size_type>(records.size() * 2, 1)));
+	lsd::Vector<uint32> buckets(bucketCount, 0);
+
+	for (uint32 i = 0; i < records.size(); i++) {
+		auto bucket = records[i].hash & (bucketCount - 1);
+		while (buckets[bucket] != 0) bucket = (bucket + 1) & (bucketCount - 1);
+		buckets[bucket] = i + 1;
+	}
+
+	Header header {
+		magic,
+		version,
+		static_cast<uint32>(records.size()),
+		bucketCount,
+		static_cast<uint32>(blocks.size()),
+		static_cast<uint32>(strings.size())
+	};
+
+	auto recordsOffset = alignUp(sizeof(Header) + buckets.size() * sizeof(uint32), alignof(Record));
+	auto blocksOffset = recordsOffset + records.size() * sizeof(Record);
+	auto stringsOffset = blocksOffset + blocks.size() * sizeof(uint32);
+
+	lsd::Vector<char> data(stringsOffset + strings.size(), '\0');
+	std::memcpy(data.data(), &header, sizeof(Header));
+	std::memcpy(data.data() + sizeof(Header), buckets.data(), buckets.size() * sizeof(uint32));
+	std::memcpy(data.data() + recordsOffset, records.data(), records.size() * sizeof(Record));
+	std::memcpy(data.data() + blocksOffset, blocks.data(), blocks.size() * sizeof(uint32));
+	std::memcpy(data.data() + stringsOffset, strings.data(), strings.size());
+
+	return data;
+}
+
+AssetIndex::Kind AssetIndex::kind(const std::filesystem::path& path) {
+	auto ext = path.extension();
+
+	if (ext == ".png" || ext == ".bmp" || ext == ".jpg" || ext == ".jpeg" || ext == ".psd") return Kind::texture;
+	else if (ext == ".glb") return Kind::mesh;
+	else if (ext == ".spv") return Kind::shader;
+	else return Kind::none;
+}
+
+const AssetIndex::Record* AssetIndex::find(std::string_view path) const noexcept {
+	if (!m_header) return nullptr;
+
+	auto hash = hashBytes(path);
+	auto mask = m_header->bucketCount - 1;
+
+	for (auto bucket = hash & mask; m_buckets[bucket] != 0; bucket = (bucket + 1) & mask) {
+		const auto& record = m_records[m_buckets[bucket] - 1];
+		if (record.hash == hash && this->path(record) == path) return &record;
+	}
+
+	return nullptr;
+}
+
+const AssetIndex::Record& AssetIndex::at(std::string_view path) const {
+	auto record = find(path);
+	ASSERT(record, "lyra::resource::AssetIndex::at(): No asset at path: {} was found in the asset index!", path);
+	return *record;
+}
+
+void AssetIndex::setup(const char* data, size_type size) {
+	if (size < sizeof(Header)) return;
+
+	auto header = reinterpret_cast<const Header*>(data);
+	if (header->magic != magic || header->version != version) return;
+
+	// the probe sequences of find() rely on the mask and on reaching an empty bucket
+	if (!std::has_single_bit(header->bucketCount) || header->bucketCount <= header->recordCount) return;
+
+	auto recordsOffset = alignUp(sizeof(Header) + static_cast<size_type>(header->bucketCount) * sizeof(uint32), alignof(Record));
+	auto blocksOffset = recordsOffset + static_cast<size_type>(header->recordCount) * sizeof(Record);
+	auto stringsOffset = blocksOffset + static_cast<size_type>(header->blockCount) * sizeof(uint32);
+
+	if (stringsOffset + header->stringsSize > size) return;
+
+	auto buckets = reinterpret_cast<const uint32*>(data + sizeof(Header));
+	auto records = reinterpret_cast<const Record*>(data + recordsOffset);
+
+	// a corrupt index is treated like a missing one, so the caller rebuilds it from the project file
+	bool emptyBucket = false;
+
+	for (uint32 i = 0; i < header->bucketCount; i++) {
+		if (buckets[i] > header->recordCount) return;
+		emptyBucket |= (buckets[i] == 0);
+	}
+
+	if (!emptyBucket) return;
+
+	for (uint32 i = 0; i < header->recordCount; i++) {
+		const auto& record = records[i];
+
+		if (static_cast<size_type>(record.pathOffset) + record.pathSize > header->stringsSize) return;
+		if (static_cast<size_type>(record.blockOffset) + record.vertexBlockCount + record.indexBlockCount > header->blockCount) return;
+	}
+
+	m_header = header;
+	m_buckets = buckets;
+	m_records = records;
+	m_blocks = reinterpret_cast<const uint32*>(data + blocksOffset);
+	m_strings = data + stringsOffset;
+}
+
+} // namespace resource
+
+} // namespace lyra
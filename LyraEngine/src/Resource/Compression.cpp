@@ -0,0 +1,132 @@
+#include <Resource/Compression.h>
+
+#include <Common/Logger.h>
+#include <Common/ThreadPool.h>
+
+#include <lz4.h>
+#include <lz4hc.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace lyra {
+
+namespace resource {
+
+namespace {
+
+void forEachBlock(uint32 blockCount, ThreadPool* workers, const std::function<void(size_type)>& func) {
+	if (workers && blockCount > 1) workers->parallelFor(blockCount, func);
+	else for (uint32 i = 0; i < blockCount; i++) func(i);
+}
+
+}
+
+lsd::Vector<char> compress(const void* data, size_type size, uint32 level, uint32 blockSize, ThreadPool* workers) {
+	level = std::min(level, maxCompressionLevel);
+	blockSize = std::max(blockSize, minBlockSize);
+
+	auto blockCount = static_cast<uint32>((size + blockSize - 1) / blockSize);
+	auto source = static_cast<const char*>(data);
+
+	lsd::Vector<lsd::Vector<char>> blocks(blockCount);
+
+	forEachBlock(blockCount, workers, [&](size_type i) {
+		auto offset = i * blockSize;
+		auto blockUncompressed = static_cast<int>(std::min<size_type>(blockSize, size - offset));
+
+		auto& block = blocks[i];
+		block.resize(LZ4_compressBound(blockUncompressed));
+
+		auto compressed = (level == 0) ?
+			LZ4_compress_default(source + offset, block.data(), blockUncompressed, static_cast<int>(block.size())) :
+			LZ4_compress_HC(source + offset, block.data(), blockUncompressed, static_cast<int>(block.size()), static_cast<int>(level));
+
+		block.resize(compressed);
+	});
+
+	size_type totalSize = sizeof(CompressionHeader) + blockCount * sizeof(uint32);
+	for (const auto& block : blocks) totalSize += block.size();
+
+	lsd::Vector<char> result(totalSize);
+
+	CompressionHeader header { CompressionHeader::magic, CompressionHeader::version, level, blockSize, size, blockCount, 0 };
+	std::memcpy(result.data(), &header, sizeof(CompressionHeader));
+
+	auto blockSizes = result.data() + sizeof(CompressionHeader);
+	auto blockData = blockSizes + blockCount * sizeof(uint32);
+
+	for (const auto& block : blocks) {
+		auto blockCompressed = static_cast<uint32>(block.size());
+
+		std::memcpy(blockSizes, &blockCompressed, sizeof(uint32));
+		std::memcpy(blockData, block.data(), block.size());
+
+		blockSizes += sizeof(uint32);
+		blockData += block.size();
+	}
+
+	return result;
+}
+
+bool decompress(const MappedFile& compressedFile, void* dst, size_type size, ThreadPool* workers) {
+	auto destination = static_cast<char*>(dst);
+
+	CompressionHeader header { };
+	if (compressedFile.size() >= sizeof(CompressionHeader)) std::memcpy(&header, compressedFile.data(), sizeof(CompressionHeader));
+
+	if (header.fileMagic != CompressionHeader::magic) {
+		return LZ4_decompress_safe(compressedFile.data(), destination, static_cast<int>(compressedFile.size()), static_cast<int>(size)) == static_cast<int>(size);
+	}
+
+	if (
+		header.fileVersion != CompressionHeader::version || 
+		header.uncompressed != size || 
+		header.blockSize == 0 || 
+		header.blockCount != (size + header.blockSize - 1) / header.blockSize
+	) {
+		log::error("lyra::resource::decompress(): The compressed file at path: {} has an unsupported version or does not match the asset metadata!", compressedFile.path().string());
+		return false;
+	}
+
+	auto blockSizes = reinterpret_cast<const uint32*>(compressedFile.data() + sizeof(CompressionHeader));
+
+	// prefix sum over the block sizes, so every block knows where it starts before any of them is decompressed
+	lsd::Vector<size_type> blockOffsets(header.blockCount + 1);
+	blockOffsets[0] = sizeof(CompressionHeader) + header.blockCount * sizeof(uint32);
+
+	if (blockOffsets[0] > compressedFile.size()) {
+		log::error("lyra::resource::decompress(): The compressed file at path: {} is truncated!", compressedFile.path().string());
+		return false;
+	}
+
+	for (uint32 i = 0; i < header.blockCount; i++) blockOffsets[i + 1] = blockOffsets[i] + blockSizes[i];
+
+	if (blockOffsets.back() > compressedFile.size()) {
+		log::error("lyra::resource::decompress(): The compressed file at path: {} is truncated!", compressedFile.path().string());
+		return false;
+	}
+
+	std::atomic<bool> failed = false;
+
+	forEachBlock(header.blockCount, workers, [&](size_type i) {
+		auto offset = i * header.blockSize;
+		auto blockUncompressed = static_cast<int>(std::min<size_type>(header.blockSize, size - offset));
+
+		if (LZ4_decompress_safe(
+			compressedFile.data() + blockOffsets[i],
+			destination + offset,
+			static_cast<int>(blockOffsets[i + 1] - blockOffsets[i]),
+			blockUncompressed
+		) != blockUncompressed) failed = true;
+	});
+
+	if (failed) log::error("lyra::resource::decompress(): Failed to decompress the file at path: {}!", compressedFile.path().string());
+
+	return !failed;
+}
+
+} // namespace resource
+
+} // namespace lyra
@@ -1,9 +1,12 @@
 #include <Resource/LoadMeshFile.h>
 
+#include <Common/Config.h>
 #include <Common/Logger.h>
 #include <Common/FileSystem.h>
 
-#include <lz4.h>
+#include <Resource/Compression.h>
+
+#include <Graphics/Mesh.h>
 
 using namespace lsd::enum_operators;
 
@@ -11,40 +14,111 @@ namespace lyra {
 
 namespace resource {
 
-MeshFile loadMeshFile(std::filesystem::path path, uint32 uncompressed, const lsd::Json::array_type& vertexBlocks, const lsd::Json::array_type& indexBlocks) {
-	ByteFile compressedFile(path.concat(".dat"), OpenMode::read | OpenMode::binary, false);
-	lsd::Vector<char> fileData(compressedFile.size());
-	compressedFile.read(fileData.data(), fileData.size());
+MeshFile loadMeshFile(const MappedFile& compressedFile, uint32 uncompressed, uint32 vertexLayout, std::span<const uint32> vertexBlocks, std::span<const uint32> indexBlocks, ThreadPool* workers) {
+	if (vertexLayout != Mesh::PackedVertex::layout) {
+		log::error("lyra::resource::loadMeshFile(): Vertex layout: {} of mesh at path: {} does not match the layout of the engine: {}, the mesh has to be rebuilt!", vertexLayout, compressedFile.path().string(), Mesh::PackedVertex::layout);
+		return { };
+	}
 
 	lsd::Vector<char> file(uncompressed);
-	LZ4_decompress_safe(fileData.data(), file.data(), static_cast<uint32>(fileData.size()), static_cast<uint32>(file.size()));
+	if (!decompress(compressedFile, file.data(), file.size(), workers)) {
+		log::error("lyra::resource::loadMeshFile(): Failed to load mesh at path: {}!", compressedFile.path().string());
+		return { };
+	}
 
 	MeshFile meshes { };
 
+	meshes.bounds.resize(vertexBlocks.size());
+	meshes.lods.resize(vertexBlocks.size());
 	meshes.vertexData.resize(vertexBlocks.size());
 	meshes.indexData.resize(indexBlocks.size());
+	meshes.meshletData.resize(indexBlocks.size());
 
 	meshes.vertexBlocks.resize(vertexBlocks.size());
 	meshes.indexBlocks.resize(indexBlocks.size());
 
-	uint32 currentOffset = 0;
+	size_type currentOffset = 0;
+	uint32 indexBlock = 0;
+
+	// a stale or corrupt file may contain sizes which reach past the end of the decompressed data
+	auto fits = [&file, &currentOffset](size_type size) {
+		return size <= file.size() && currentOffset <= file.size() - size;
+	};
+	auto read = [&file, &currentOffset, &fits](void* data, size_type size) {
+		if (!fits(size)) return false;
+
+		std::memcpy(data, &file[currentOffset], size);
+		currentOffset += size;
+
+		return true;
+	};
+	auto corrupt = [&compressedFile, &file, &currentOffset]() {
+		log::error("lyra::resource::loadMeshFile(): Data of mesh at path: {} ends at byte {} of {}, the mesh has to be rebuilt!", compressedFile.path().string(), currentOffset, file.size());
+		return MeshFile { };
+	};
+
+	// the index blocks inherit the index size of the vertex block they belong to
+	lsd::Vector<uint32> indexSizes;
+	indexSizes.reserve(indexBlocks.size());
 
 	for (uint32 i = 0; i < vertexBlocks.size(); i++) {
-		const auto& size = vertexBlocks[i]->get<uint32>();
+		const auto& size = vertexBlocks[i];
 		meshes.vertexBlocks[i] = size;
 
-		meshes.vertexData[i].resize(size * 3 * 4);
-		std::memcpy(meshes.vertexData[i].data(), &file[currentOffset], size * sizeof(float32) * 3 * 4);
-		currentOffset += size * sizeof(float32) * 3 * 4;
+		uint32 lodCount;
+		if (!read(&meshes.bounds[i], sizeof(BoundingVolume)) || !read(&lodCount, sizeof(uint32))) return corrupt();
+
+		if (lodCount == 0 || lodCount > config::maxMeshLods || lodCount > indexBlocks.size() - indexBlock) {
+			log::error("lyra::resource::loadMeshFile(): Vertex block: {} of mesh at path: {} has {} levels of detail, but only {} index blocks are left!", i, compressedFile.path().string(), lodCount, indexBlocks.size() - indexBlock);
+			return { };
+		}
+
+		auto& lods = meshes.lods[i];
+		lods.firstIndexBlock = indexBlock;
+		lods.errors.resize(lodCount);
+		if (!read(lods.errors.data(), lodCount * sizeof(float32))) return corrupt();
+
+		indexBlock += lodCount;
+		for (uint32 j = 0; j < lodCount; j++) indexSizes.pushBack(Mesh::indexSize(Mesh::selectIndexType(size)));
+
+		auto vertexSize = static_cast<size_type>(size) * sizeof(Mesh::PackedVertex);
+		if (!fits(vertexSize)) return corrupt();
+
+		meshes.vertexData[i].resize(vertexSize);
+		read(meshes.vertexData[i].data(), vertexSize);
+	}
+
+	if (indexBlock != indexBlocks.size()) {
+		log::error("lyra::resource::loadMeshFile(): Levels of detail of mesh at path: {} reference {} index blocks, but the mesh has {}!", compressedFile.path().string(), indexBlock, indexBlocks.size());
+		return { };
 	}
 
 	for (uint32 i = 0; i < indexBlocks.size(); i++) {
-		const auto& size = indexBlocks[i]->get<uint32>();
+		const auto& size = indexBlocks[i];
 		meshes.indexBlocks[i] = size;
 
-		meshes.indexData[i].resize(size);
-		std::memcpy(meshes.indexData[i].data(), &file[currentOffset], size * sizeof(uint32));
-		currentOffset += size * sizeof(uint32);
+		auto indexSize = static_cast<size_type>(size) * indexSizes[i];
+		if (!fits(indexSize)) return corrupt();
+
+		meshes.indexData[i].resize(indexSize);
+		read(meshes.indexData[i].data(), indexSize);
+	}
+
+	for (uint32 i = 0; i < indexBlocks.size(); i++) {
+		uint32 meshletCount;
+		if (!read(&meshletCount, sizeof(uint32))) return corrupt();
+
+		// every meshlet holds at least one triangle of its index block
+		if (meshletCount > indexBlocks[i] / 3) {
+			log::error("lyra::resource::loadMeshFile(): Index block: {} of mesh at path: {} has {} meshlets, but only {} triangles!", i, compressedFile.path().string(), meshletCount, indexBlocks[i] / 3);
+			return { };
+		}
+
+		auto meshletSize = static_cast<size_type>(meshletCount) * sizeof(Meshlet);
+		if (!fits(meshletSize)) return corrupt();
+
+		meshes.meshletData[i].resize(meshletCount);
+		read(meshes.meshletData[i].data(), meshletSize);
 	}
 	
 	return meshes;
@@ -5,7 +5,7 @@
 
 #include <Common/Benchmark.h>
 
-#include <lz4.h>
+#include <Resource/Compression.h>
 
 using namespace lsd::enum_operators;
 
@@ -14,7 +14,7 @@ namespace lyra {
 namespace resource {
 
 TextureFile loadTextureFile(
-	std::filesystem::path path,
+	const MappedFile& compressedFile,
 	uint32 uncompressed,
 	uint32 width,
 	uint32 height,
@@ -22,12 +22,10 @@ TextureFile loadTextureFile(
 	uint32 alpha,
 	uint32 mipmap,
 	uint32 dimension,
-	uint32 wrap
+	uint32 wrap,
+	TextureFormat format,
+	ThreadPool* workers
 ) {
-	ByteFile compressedFile(path.concat(".dat"), OpenMode::read | OpenMode::binary, false);
-	lsd::Vector<char> fileData(compressedFile.size());
-	compressedFile.read(fileData.data(), fileData.size());
-
 	TextureFile data {
 		width,
 		height,
@@ -36,11 +34,15 @@ TextureFile loadTextureFile(
 		mipmap,
 		dimension,
 		wrap,
+		format,
 		{ }
 	};
 	
 	data.data.resize(uncompressed);
-	LZ4_decompress_safe(fileData.data(), data.data.data(), static_cast<uint32>(fileData.size()), static_cast<uint32>(data.data.size()));
+	if (!decompress(compressedFile, data.data.data(), data.data.size(), workers)) {
+		log::error("lyra::resource::loadTextureFile(): Failed to load texture at path: {}!", compressedFile.path().string());
+		return { };
+	}
 
 	return data;
 }
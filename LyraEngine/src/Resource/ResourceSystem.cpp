@@ -2,7 +2,10 @@
 
 #include <Common/Logger.h>
 #include <Common/FileSystem.h>
+#include <Common/ThreadPool.h>
 
+#include <Resource/AssetArchive.h>
+#include <Resource/AssetIndex.h>
 #include <Resource/LoadTextureFile.h>
 #include <Resource/LoadMaterialFile.h>
 #include <Resource/LoadMeshFile.h>
@@ -11,6 +14,8 @@
 #include <LSD/UnorderedSparseMap.h>
 #include <LSD/JSON.h>
 
+#include <algorithm>
+#include <functional>
 #include <utility>
 
 using namespace lsd::enum_operators;
@@ -19,10 +24,199 @@ namespace lyra {
 
 namespace {
 
+template <class Ty, class Data> struct PendingLoad {
+	std::string path;
+	std::future<Data> data;
+	std::promise<const Ty*> promise;
+	std::shared_future<const Ty*> result;
+};
+
+struct ShaderFile {
+	vulkan::Shader::Type type;
+	lsd::Vector<char> data;
+};
+
+// a single white texel
+resource::TextureFile defaultTextureFile() {
+	return {
+		1,
+		1,
+		0,
+		1,
+		1,
+		1,
+		0,
+		resource::TextureFormat::rgba8,
+		{ '\xff', '\xff', '\xff', '\xff' }
+	};
+}
+
 class ResourceSystem {
 public:
-	ResourceSystem() : assetsFile(lsd::Json::parse(StringStream(assetsFilePath(), OpenMode::read, false).data())) {
-		
+	ResourceSystem() {
+		auto indexPath = assetsFilePath().replace_extension(resource::AssetIndex::extension);
+
+		if (std::filesystem::exists(indexPath) && std::filesystem::last_write_time(indexPath) >= std::filesystem::last_write_time(assetsFilePath())) {
+			index = resource::AssetIndex(indexPath);
+		}
+
+		if (!index.valid()) {
+			log::warning("lyra::ResourceSystem::ResourceSystem(): No up to date asset index was found next to the project file, building it from the project file instead!");
+			index = resource::AssetIndex(lsd::Json::parse(StringStream(assetsFilePath(), OpenMode::read, false).data()));
+		}
+
+		auto archivePath = assetsFilePath().replace_extension(resource::AssetArchive::extension);
+
+		if (std::filesystem::exists(archivePath) && std::filesystem::last_write_time(archivePath) >= std::filesystem::last_write_time(assetsFilePath())) {
+			archive = resource::AssetArchive(archivePath);
+		}
+	}
+
+	// reads from the packed archive if it contains the asset, otherwise falls back to the loose built file
+	NODISCARD MappedFile compressedFile(const std::filesystem::path& path) const {
+		if (auto entry = archive.entry(path.generic_string()); entry) return entry;
+		return MappedFile(absolutePath(std::filesystem::path("data")/(path)).concat(".dat"));
+	}
+
+	NODISCARD std::function<ShaderFile()> shaderLoader(const std::filesystem::path& path) const {
+		const auto& record = index.at(path.generic_string());
+
+		return [path = absolutePath(std::filesystem::path("data")/(path)), type = record.type]() {
+			MappedFile file(path);
+			return ShaderFile { static_cast<vulkan::Shader::Type>(type), lsd::Vector<char>(file.begin(), file.end()) };
+		};
+	}
+
+	NODISCARD std::function<resource::TextureFile()> textureLoader(const std::filesystem::path& path) {
+		const auto& record = index.at(path.generic_string());
+
+		return [path, &record, this]() {
+			return resource::loadTextureFile(
+				compressedFile(path), 
+				record.uncompressed, 
+				record.width, 
+				record.height, 
+				record.type, 
+				record.alpha, 
+				record.mipmap, 
+				record.dimension, 
+				record.wrap,
+				static_cast<resource::TextureFormat>(record.format),
+				&workers
+			);
+		};
+	}
+
+	NODISCARD std::function<resource::MeshFile()> meshLoader(const std::filesystem::path& path) {
+		const auto& record = index.at(path.generic_string());
+
+		// the index is never modified after construction, so referencing its contents from another thread is safe
+		return [path, &record, this]() {
+			return resource::loadMeshFile(compressedFile(path), record.uncompressed, record.type, index.vertexBlocks(record), index.indexBlocks(record), &workers);
+		};
+	}
+
+	const vulkan::Shader* createShader(const std::string& path, ShaderFile&& file) {
+		return shaders.emplace(
+			path,
+			lsd::UniquePointer<vulkan::Shader>::create(file.type, std::move(file.data))
+		).first->second.get();
+	}
+
+	// the loaders return empty files if the built file could not be read, these are replaced by the default texture and an empty mesh
+	const Texture* createTexture(const std::string& path, resource::TextureFile&& file) {
+		if (file.data.empty()) {
+			log::warning("lyra::ResourceSystem::createTexture(): Texture at path: {} could not be loaded, using the default texture instead!", path);
+			file = defaultTextureFile();
+		}
+
+		return textures.emplace(path, lsd::UniquePointer<Texture>::create(file)).first->second.get();
+	}
+
+	const lsd::Vector<Mesh>* createMeshes(const std::string& path, resource::MeshFile&& file) {
+		auto vec = meshes.emplace(path, lsd::UniquePointer<lsd::Vector<Mesh>>::create()).first->second.get();
+
+		// a single mesh without any triangles, so the first mesh of the path stays valid but draws nothing
+		if (file.vertexBlocks.empty()) {
+			log::warning("lyra::ResourceSystem::createMeshes(): Mesh at path: {} could not be loaded, using an empty mesh instead!", path);
+			vec->emplaceBack(lsd::Vector<Mesh::Vertex> { }, lsd::Vector<uint32> { });
+
+			return vec;
+		}
+
+		vec->reserve(file.vertexBlocks.size());
+
+		for (uint32 i = 0; i < file.vertexBlocks.size(); i++) {
+			vec->emplaceBack(file, i);
+		}
+
+		return vec;
+	}
+
+	// helper functions shared by all resource types
+
+	template <class Ty, class Data, class Loader, class Create> const Ty& load(
+		const std::filesystem::path& path,
+		lsd::UnorderedSparseMap<std::string, lsd::UniquePointer<Ty>>& loaded,
+		lsd::Vector<PendingLoad<Ty, Data>>& pending,
+		Loader loader,
+		Create create
+	) {
+		auto key = path.string();
+
+		if (!loaded.contains(key)) {
+			auto it = std::find_if(pending.begin(), pending.end(), [&key](const auto& p) { return p.path == key; });
+
+			if (it != pending.end()) { // already loading in the background, wait for it instead of reading the file again
+				it->promise.set_value((this->*create)(key, it->data.get()));
+				pending.erase(it);
+			} else {
+				(this->*create)(key, (this->*loader)(path)());
+			}
+		}
+
+		return *loaded.at(key);
+	}
+
+	template <class Ty, class Data, class Loader> std::shared_future<const Ty*> loadAsync(
+		const std::filesystem::path& path,
+		const lsd::UnorderedSparseMap<std::string, lsd::UniquePointer<Ty>>& loaded,
+		lsd::Vector<PendingLoad<Ty, Data>>& pending,
+		Loader loader
+	) {
+		auto key = path.string();
+
+		if (loaded.contains(key)) {
+			std::promise<const Ty*> promise;
+			promise.set_value(loaded.at(key).get());
+			return promise.get_future().share();
+		}
+
+		auto it = std::find_if(pending.begin(), pending.end(), [&key](const auto& p) { return p.path == key; });
+		if (it != pending.end()) return it->result;
+
+		auto& load = pending.emplaceBack(PendingLoad<Ty, Data> { key, workers.enqueue((this->*loader)(path)), { }, { } });
+		load.result = load.promise.get_future().share();
+
+		return load.result;
+	}
+
+	template <class Ty, class Data, class Create> void finalize(
+		lsd::Vector<PendingLoad<Ty, Data>>& pending,
+		Create create,
+		uint32& remaining
+	) {
+		for (size_type i = 0; i < pending.size() && remaining > 0;) {
+			auto& load = pending[i];
+
+			if (load.data.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+				load.promise.set_value((this->*create)(load.path, load.data.get()));
+				pending.erase(pending.begin() + i);
+				remaining--;
+			} else {
+				i++;
+			}
+		}
 	}
 
 	lsd::UnorderedSparseMap<std::string, lsd::UniquePointer<vulkan::Shader>> shaders;
@@ -30,7 +224,14 @@ public:
 	lsd::UnorderedSparseMap<std::string, lsd::UniquePointer<lsd::Vector<Mesh>>> meshes;
 	lsd::UnorderedSparseMap<std::string, lsd::UniquePointer<Material>> materials;
 
-	lsd::Json assetsFile;
+	lsd::Vector<PendingLoad<vulkan::Shader, ShaderFile>> pendingShaders;
+	lsd::Vector<PendingLoad<Texture, resource::TextureFile>> pendingTextures;
+	lsd::Vector<PendingLoad<lsd::Vector<Mesh>, resource::MeshFile>> pendingMeshes;
+
+	resource::AssetIndex index;
+	resource::AssetArchive archive;
+
+	ThreadPool workers;
 };
 
 static ResourceSystem* globalResourceSystem = nullptr;
@@ -44,70 +245,79 @@ void initResourceSystem() {
 		globalResourceSystem = new ResourceSystem();
 }
 
+void quitResourceSystem() {
+	if (globalResourceSystem) globalResourceSystem->workers.wait();
+}
+
 namespace resource {
 
 const vulkan::Shader& shader(std::filesystem::path path) {
-	if (!globalResourceSystem->shaders.contains(path.string())) {
-		const auto& js = globalResourceSystem->assetsFile.child(path.generic_string().c_str());
-
-		ByteFile compressedFile(absolutePath(std::filesystem::path("data")/(path)), OpenMode::read | OpenMode::binary, false);
-		lsd::Vector<char> data(compressedFile.size());
-		compressedFile.read(data.data(), data.size());
-
-		globalResourceSystem->shaders.emplace(
-			path.string(),
-			lsd::UniquePointer<vulkan::Shader>::create(
-				static_cast<vulkan::Shader::Type>(js.child("Type").get<uint32>()), 
-				data
-			)
-		);
-	}
-
-	return *globalResourceSystem->shaders.at(path.string());
+	return globalResourceSystem->load(
+		path,
+		globalResourceSystem->shaders,
+		globalResourceSystem->pendingShaders,
+		&ResourceSystem::shaderLoader,
+		&ResourceSystem::createShader
+	);
 }
 
 const Texture& texture(std::filesystem::path path) {
-	if (!globalResourceSystem->textures.contains(path.string())) {
-		const auto& js = globalResourceSystem->assetsFile.child(path.generic_string().c_str());
-		globalResourceSystem->textures.emplace(
-			path.string(), 
-			lsd::UniquePointer<Texture>::create(loadTextureFile(
-				absolutePath(std::filesystem::path("data")/(path)),
-				js.child("Uncompressed").get<uint32>(),
-				js.child("Width").get<uint32>(),
-				js.child("Height").get<uint32>(),
-				js.child("Type").get<uint32>(),
-				js.child("Alpha").get<uint32>(),
-				js.child("Mipmap").get<uint32>(),
-				js.child("Dimension").get<uint32>(),
-				js.child("Wrap").get<uint32>()
-		)));
-	}
-
-	return *globalResourceSystem->textures.at(path.string());
+	return globalResourceSystem->load(
+		path,
+		globalResourceSystem->textures,
+		globalResourceSystem->pendingTextures,
+		&ResourceSystem::textureLoader,
+		&ResourceSystem::createTexture
+	);
 }
 
 const lsd::Vector<Mesh>& mesh(std::filesystem::path path) {
-	if (!globalResourceSystem->meshes.contains(path.string())) {
-		const auto& js = globalResourceSystem->assetsFile.child(path.generic_string().c_str());
-		const auto& vertexBlocks = js.child("VertexBlocks").get<lsd::Json::array_type>();
-		const auto& indexBlocks = js.child("IndexBlocks").get<lsd::Json::array_type>();
-
-		auto meshData = loadMeshFile(
-			absolutePath(std::filesystem::path("data")/(path)),
-			js.child("Uncompressed").get<uint32>(),
-			vertexBlocks,
-			indexBlocks
-		);
-		auto vec = globalResourceSystem->meshes.emplace(path.string(), lsd::UniquePointer<lsd::Vector<Mesh>>::create()).first->second.get();
-		vec->reserve(vertexBlocks.size());
-
-		for (uint32 i = 0; i < vertexBlocks.size(); i++) {
-			vec->emplaceBack(meshData, i);
-		}
-	}
+	return globalResourceSystem->load(
+		path,
+		globalResourceSystem->meshes,
+		globalResourceSystem->pendingMeshes,
+		&ResourceSystem::meshLoader,
+		&ResourceSystem::createMeshes
+	);
+}
+
+Future<vulkan::Shader> shaderAsync(std::filesystem::path path) {
+	return globalResourceSystem->loadAsync(
+		path,
+		globalResourceSystem->shaders,
+		globalResourceSystem->pendingShaders,
+		&ResourceSystem::shaderLoader
+	);
+}
 
-	return *globalResourceSystem->meshes.at(path.string());
+Future<Texture> textureAsync(std::filesystem::path path) {
+	return globalResourceSystem->loadAsync(
+		path,
+		globalResourceSystem->textures,
+		globalResourceSystem->pendingTextures,
+		&ResourceSystem::textureLoader
+	);
+}
+
+Future<lsd::Vector<Mesh>> meshAsync(std::filesystem::path path) {
+	return globalResourceSystem->loadAsync(
+		path,
+		globalResourceSystem->meshes,
+		globalResourceSystem->pendingMeshes,
+		&ResourceSystem::meshLoader
+	);
+}
+
+void finalizeLoads(uint32 maxCount) {
+	globalResourceSystem->finalize(globalResourceSystem->pendingShaders, &ResourceSystem::createShader, maxCount);
+	globalResourceSystem->finalize(globalResourceSystem->pendingTextures, &ResourceSystem::createTexture, maxCount);
+	globalResourceSystem->finalize(globalResourceSystem->pendingMeshes, &ResourceSystem::createMeshes, maxCount);
+}
+
+bool loadsPending() {
+	return !globalResourceSystem->pendingShaders.empty() || 
+		!globalResourceSystem->pendingTextures.empty() || 
+		!globalResourceSystem->pendingMeshes.empty();
 }
 
 const Material& material(std::filesystem::path path) {
@@ -121,16 +331,7 @@ const Material& material(std::filesystem::path path) {
 
 const Texture& defaultTexture() {
 	if (!globalResourceSystem->textures.contains("defaultTexture")) {
-		globalResourceSystem->textures.emplace("defaultTexture", lsd::UniquePointer<Texture>::create(TextureFile{
-			1,
-			1,
-			0,
-			1,
-			1,
-			1,
-			0,
-			{ '\xff', '\xff', '\xff' }
-		}));
+		globalResourceSystem->textures.emplace("defaultTexture", lsd::UniquePointer<Texture>::create(defaultTextureFile()));
 	}
 
 	return *globalResourceSystem->textures.at("defaultTexture");
@@ -146,7 +347,8 @@ const Texture& defaultNormal() {
 			1,
 			1,
 			0,
-			{ '\x80', '\x80', '\xff' }
+			TextureFormat::rgba8,
+			{ '\x80', '\x80', '\xff', '\xff' }
 		}));
 	}
 
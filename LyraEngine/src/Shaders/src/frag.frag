@@ -1,31 +1,41 @@
 #version 450
 #extension GL_EXT_nonuniform_qualifier : enable
 
-layout(set = 0, binding = 2) uniform sampler2D metallic;
-layout(set = 0, binding = 2) uniform sampler2D specular;
-layout(set = 0, binding = 4) uniform sampler2D emission;
-layout(set = 0, binding = 5) uniform sampler2D occlusionMap;
-
-layout(set = 0, binding = 6) uniform MaterialDataFrag {
+struct MaterialData {
 	vec4 albedoColor;
 	vec4 emissionColor;
-	uint metallic;
-	uint roughness;
-	uint specular;
-	bool emissionEnabled;
-	uint emissionEnergy;
-	uint occlusionMapValue;
-} matDatF;
+	vec4 specularColor;
+	vec4 occlusionColor;
+	float metallic;
+	float roughness;
+	uint albedoTexture;
+	uint albedoTextureCount;
+	uint normalMapTexture;
+	uint displacementMapTexture;
+	uint metallicTexture;
+	uint specularTexture;
+	uint emissionTexture;
+	uint occlusionMapTexture;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Materials {
+	MaterialData materials[];
+};
 
-layout(set = 0, binding = 7) uniform sampler2D albedo[];
+layout(set = 0, binding = 1) uniform sampler2D textures[];
 
 layout(location = 0) in vec3 inColor;
 layout(location = 1) in vec3 inUVWCoord;
+layout(location = 2) flat in uint inMaterial;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-	outColor = texture(albedo[uint(inUVWCoord.z)], inUVWCoord.xy);
-	// outColor = texture(albedo[0], inUVWCoord.xy);
-	// outColor = vec4(inUVWCoord, 1.0);
+	MaterialData material = materials[inMaterial];
+
+	// the third texture coordinate selects one of the albedo textures of the material
+	uint albedo = material.albedoTexture + min(uint(inUVWCoord.z), material.albedoTextureCount - 1);
+
+	// instances of different materials may be drawn by the same draw call
+	outColor = texture(textures[nonuniformEXT(albedo)], inUVWCoord.xy);
 }
@@ -0,0 +1,57 @@
+/*************************
+ * @file MeshGrid.h
+ *
+ * @brief Flat grids of quads the tests of the asset pipeline are run on
+ *************************/
+
+#pragma once
+
+#include <Common/Common.h>
+
+#include <Graphics/Mesh.h>
+
+#include <LSD/Vector.h>
+
+#include <glm/glm.hpp>
+
+namespace test {
+
+/**
+ * @brief appends an indexed grid of counter clockwise quads, facing along the cross product of its axes
+ *
+ * @param vertices vertices to append the grid corners to
+ * @param indices indices to append the triangles to, they reference the appended vertices
+ * @param size quads per side
+ * @param origin position of the first corner
+ * @param right edge of a quad along the rows of the grid
+ * @param up edge of a quad along the columns of the grid
+ */
+inline void buildGrid(
+	lsd::Vector<lyra::Mesh::Vertex>& vertices,
+	lsd::Vector<lyra::uint32>& indices,
+	lyra::uint32 size,
+	const glm::vec3& origin = glm::vec3(0.0f),
+	const glm::vec3& right = glm::vec3(1.0f, 0.0f, 0.0f),
+	const glm::vec3& up = glm::vec3(0.0f, 1.0f, 0.0f)
+) {
+	auto first = static_cast<lyra::uint32>(vertices.size());
+	auto normal = glm::normalize(glm::cross(right, up));
+
+	for (lyra::uint32 y = 0; y <= size; y++) {
+		for (lyra::uint32 x = 0; x <= size; x++) {
+			// the texture coordinates span the grid once, so two grids meeting at an edge form a seam there
+			glm::vec3 uvw(static_cast<lyra::float32>(x) / size, static_cast<lyra::float32>(y) / size, 0.0f);
+			vertices.emplaceBack(origin + right * static_cast<lyra::float32>(x) + up * static_cast<lyra::float32>(y), normal, glm::vec3(1.0f), uvw);
+		}
+	}
+
+	for (lyra::uint32 y = 0; y < size; y++) {
+		for (lyra::uint32 x = 0; x < size; x++) {
+			auto index = [&](lyra::uint32 dx, lyra::uint32 dy) { return first + (y + dy) * (size + 1) + x + dx; };
+
+			for (auto corner : { index(0, 0), index(1, 0), index(1, 1), index(0, 0), index(1, 1), index(0, 1) }) indices.pushBack(corner);
+		}
+	}
+}
+
+} // namespace test
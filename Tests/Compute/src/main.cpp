@@ -1,82 +1,353 @@
-#define SDL_MAIN_HANDLED
-#define LYRA_LOG_FILE
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include <Lyra/Lyra.h>
+#include <Common/Common.h>
+#include <Common/Logger.h>
+
+#include <Graphics/VulkanRenderSystem.h>
+#include <Graphics/Renderer.h>
+#include <Graphics/CullingPass.h>
+
+#include <Math/Culling.h>
+
+#include <LSD/Vector.h>
 
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
-#include <Common/Common.h>
+#include <algorithm>
+#include <limits>
+#include <random>
+
+namespace lyra {
+
+namespace renderer {
+
+extern vulkan::RenderSystem* globalRenderSystem;
+
+}
 
-#include <Math/LyraMath.h>
-#include <Math/ComputePipeline.h>
+}
+
+namespace {
+
+constexpr lyra::uint32 candidateCount = 16384;
+constexpr lyra::uint32 drawCount = 16;
+constexpr lyra::uint32 batchCount = 4;
+constexpr lyra::uint32 drawsPerBatch = drawCount / batchCount;
 
-#include <Resource/Shader.h>
-#include <Graphics/VulkanImpl/GPUBuffer.h>
-#include <Graphics/VulkanImpl/DescriptorSystem.h>
+// extent of the synthetic depth buffer, deliberately not a power of two
+constexpr glm::uvec2 depthExtent = { 320, 240 };
+// the left half of the depth buffer is covered by an occluder at this depth, the right half is empty
+constexpr lyra::float32 occluderDepth = 0.9f;
 
-#include <Application/Application.h>
+// spheres which touch a plane within this distance may be classified differently by the CPU and the GPU
+constexpr lyra::float32 tolerance = 1e-3f;
+
+struct Readback {
+	Readback(VkDeviceSize size) : buffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU) { }
+
+	void copy(const lyra::vulkan::CommandQueue::CommandBuffer& commandBuffer, const lyra::vulkan::GPUBuffer& source) const {
+		commandBuffer.copyBuffer(source.buffer, buffer.buffer, VkBufferCopy { 0, 0, std::min(source.size, buffer.size) });
+	}
+
+	template <class Ty> const Ty* map() {
+		VULKAN_ASSERT(lyra::renderer::globalRenderSystem->mapMemory(buffer.memory, reinterpret_cast<void**>(&data)), "map readback buffer memory");
+		VULKAN_ASSERT(lyra::renderer::globalRenderSystem->invalidateAllocation(buffer.memory, 0, VK_WHOLE_SIZE), "invalidate readback buffer memory");
+
+		return static_cast<const Ty*>(data);
+	}
+
+	~Readback() {
+		if (data) lyra::renderer::globalRenderSystem->unmapMemory(buffer.memory);
+	}
 
-struct Sphere {
-	glm::vec3 pos;
-	lyra::float32 rad;
+	lyra::vulkan::GPUBuffer buffer;
+	void* data = nullptr;
 };
 
-struct Camera {
-	lyra::float32 fov;
-	lyra::float32 aspect;
-	lyra::float32 near;
-	lyra::float32 far;
+struct Result {
+	lsd::Vector<lyra::uint32> visible; // candidate indices
+	bool valid = true;
 };
 
-int main() {
-	// create the compute pipeline
-	lyra::ComputePipeline computePipeline;
-
-	{ // build the compute pipeline
-		// create the builder for the compute pipeline
-		lyra::ComputePipeline::Builder builder;
-		builder.add_shader_info({  // shader information
-			lyra::vulkan::Shader::Type::COMPUTE, "data/shaders/compute.spv", "main"
-		});
-		builder.add_binding_infos({ // descriptor information
-			{ lyra::vulkan::Shader::Type::COMPUTE, 0, lyra::vulkan::DescriptorSystem::DescriptorSet::Type::uniformBuffer, 1 },
-			{ lyra::vulkan::Shader::Type::COMPUTE, 0, lyra::vulkan::DescriptorSystem::DescriptorSet::Type::storageBuffer, 1 }
-		});
-		computePipeline = lyra::ComputePipeline(builder);
+// checks the compacted draws against the instance counts and collects the visible candidates
+Result runPass(
+	const lyra::vulkan::CullingPass& pass,
+	const glm::mat4& viewProjection,
+	bool occlusion,
+	const lyra::vulkan::DepthPyramid* depthPyramid = nullptr
+) {
+	using namespace lyra;
+	using namespace lyra::vulkan;
+
+	auto renderSystem = renderer::globalRenderSystem;
+
+	Readback visibleInstances(pass.visibleInstanceBuffer.size);
+	Readback visibleCounts(pass.visibleCountBuffer.size);
+	Readback outputDraws(pass.outputDrawBuffer.size);
+	Readback drawCounts(pass.drawCountBuffer.size);
+
+	renderSystem->commandQueue->oneTimeBegin();
+	const auto& commandBuffer = *renderSystem->commandQueue->activeCommandBuffer;
+
+	if (depthPyramid) depthPyramid->build(commandBuffer);
+
+	pass.record(commandBuffer, viewProjection, candidateCount, drawCount, batchCount, occlusion);
+
+	visibleInstances.copy(commandBuffer, pass.visibleInstanceBuffer);
+	visibleCounts.copy(commandBuffer, pass.visibleCountBuffer);
+	outputDraws.copy(commandBuffer, pass.outputDrawBuffer);
+	drawCounts.copy(commandBuffer, pass.drawCountBuffer);
+
+	commandBuffer.pipelineBarrier(
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT,
+		0,
+		{ VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT }
+	);
+
+	renderSystem->commandQueue->oneTimeSubmit();
+
+	auto instances = visibleInstances.map<InstanceBuffer::InstanceData>();
+	auto counts = visibleCounts.map<uint32>();
+	auto draws = outputDraws.map<VkDrawIndexedIndirectCommand>();
+	auto batches = drawCounts.map<uint32>();
+
+	Result result;
+
+	for (uint32 batch = 0; batch < batchCount; batch++) {
+		uint32 expected = 0;
+		for (uint32 draw = batch * drawsPerBatch; draw < (batch + 1) * drawsPerBatch; draw++) {
+			if (counts[draw] != 0) expected++;
+		}
+
+		if (batches[batch] != expected) {
+			log::error("Batch {} has {} draws, expected {}!", batch, batches[batch], expected);
+			result.valid = false;
+		}
+
+		// every output draw has to match the visible instances of its source draw
+		for (uint32 i = 0; i < std::min(batches[batch], drawsPerBatch); i++) {
+			const auto& output = draws[pass.draws[batch * drawsPerBatch].firstOutput + i];
+
+			auto source = std::find_if(pass.draws, pass.draws + drawCount, [&output](const CullingPass::Draw& draw) {
+				return draw.command.firstInstance == output.firstInstance;
+			});
+
+			if (
+				source == pass.draws + drawCount ||
+				source->batch != batch ||
+				output.indexCount != source->command.indexCount ||
+				output.firstIndex != source->command.firstIndex ||
+				output.vertexOffset != source->command.vertexOffset ||
+				output.instanceCount != counts[source - pass.draws]
+			) {
+				log::error("Output draw {} of batch {} does not match its source draw!", i, batch);
+				result.valid = false;
+			}
+		}
 	}
-	
-	// create the buffer and descriptor to store the camera to send to the compute shader
-	lyra::vulkan::GPUBuffer cameraBuffer(sizeof(Camera), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
-	auto cameraDescriptorSet = computePipeline.descriptorSystem(0).get_unused_set();
 
-	// create the buffer and descriptor to store the spheres to send to the compute shader
-	lyra::vulkan::GPUBuffer sphereBuffer(sizeof(Sphere) * 1024, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
-	auto sphereDescriptorSet = computePipeline.descriptorSystem(1).get_unused_set();
+	for (uint32 draw = 0; draw < drawCount; draw++) {
+		for (uint32 i = 0; i < counts[draw]; i++) {
+			// the candidate index is stored in an otherwise unused element of the transform
+			result.visible.pushBack(static_cast<uint32>(instances[pass.draws[draw].command.firstInstance + i].transform[0][3]));
+		}
+	}
 
-	// write the buffers
+	std::sort(result.visible.begin(), result.visible.end());
 
-	// camera, represents the values passed into glm::perspective
-	Camera camera { 90.0f, 4.0f/3.0f, 0.1f, 20.0f };
-	lyra::vulkan::GPUBuffer cameraStagingBuffer(sizeof(Camera), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
-	cameraStagingBuffer.copy_data(&camera);
-	cameraBuffer.copy(cameraStagingBuffer);
+	return result;
+}
 
-	// spheres, represents "hitboxes" around objects that the frustum cull-er will use
+// distance of the sphere to the nearest plane it could be classified differently by
+lyra::float32 frustumMargin(const lyra::Frustum& frustum, const glm::vec4& sphere) {
+	auto margin = std::numeric_limits<lyra::float32>::max();
 
+	for (const auto& plane : frustum.planes) {
+		margin = std::min(margin, std::abs(glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w + sphere.w));
+	}
+
+	return margin;
+}
+
+enum class Occlusion {
+	hidden,
+	visible,
+	ambiguous
+};
 
-	const auto& cmdBuff = lyra::Application::renderSystem.frames[0].commandBuffer();
+// classifies the sphere against the occluder with the same projection as the shader
+Occlusion occlusion(const glm::mat4& viewProjection, const glm::vec4& sphere) {
+	auto result = Occlusion::hidden;
 
-	// begin recording the command buffer
-	cmdQueue.activeCommandBuffer->begin();
+	for (lyra::uint32 i = 0; i < 8; i++) {
+		auto corner = viewProjection * glm::vec4(
+			glm::vec3(sphere) + glm::vec3((i & 1) ? sphere.w : -sphere.w, (i & 2) ? sphere.w : -sphere.w, (i & 4) ? sphere.w : -sphere.w),
+			1.0f
+		);
 
-	// record the commands
-	cmdQueue.activeCommandBuffer->bindPipeline(computePipeline.bindPoint(), computePipeline.pipeline());
-	cmdQueue.activeCommandBuffer->bindDescriptorSet(computePipeline.bindPoint(), computePipeline.layout(), 0, *cameraDescriptorSet);
-	cmdQueue.activeCommandBuffer->bindDescriptorSet(computePipeline.bindPoint(), computePipeline.layout(), 1, *sphereDescriptorSet);
-	// cmdQueue.activeCommandBuffer->dispatch(); I'm too lazy to finish these tests, so I'll just hope it works
+		if (corner.w <= 0.0f) return Occlusion::visible;
+
+		// reaching into the empty right half or in front of the occluder makes the sphere visible
+		auto x = corner.x / corner.w;
+		auto depth = corner.z / corner.w;
+		if (x > tolerance || depth < occluderDepth - tolerance) return Occlusion::visible;
+		if (x > -tolerance || depth < occluderDepth + tolerance) result = Occlusion::ambiguous;
+	}
+
+	return result;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	using namespace lyra;
+	using namespace lyra::vulkan;
+
+	lyra::init(lyra::InitFlags::all, { argc, argv });
+
+	auto viewProjection =
+		glm::perspective(glm::radians(90.0f), static_cast<float32>(depthExtent.x) / depthExtent.y, 0.1f, 100.0f) *
+		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum(viewProjection);
+
+	CullingPass pass(candidateCount, drawCount, batchCount);
+
+	lsd::Vector<glm::vec4> spheres;
+
+	{ // scatter spheres around the camera and distribute them over the draws in order
+		std::mt19937 generator(1234);
+		std::uniform_real_distribution<float32> position(-60.0f, 60.0f);
+		std::uniform_real_distribution<float32> radius(0.1f, 3.0f);
+
+		for (uint32 i = 0; i < candidateCount; i++) spheres.pushBack({ position(generator), position(generator), position(generator), radius(generator) });
+
+		constexpr uint32 instancesPerDraw = candidateCount / drawCount;
+
+		for (uint32 draw = 0; draw < drawCount; draw++) {
+			auto batch = draw / drawsPerBatch;
+
+			pass.draws[draw] = {
+				{ 36, 0, draw * 36, 0, draw * instancesPerDraw },
+				batch,
+				batch * drawsPerBatch,
+				0
+			};
+		}
+
+		for (uint32 i = 0; i < candidateCount; i++) {
+			pass.candidates[i] = { spheres[i], i, i / instancesPerDraw, { 0, 0 } };
+
+			pass.instances[i].transform = glm::translate(glm::mat4(1.0f), glm::vec3(spheres[i]));
+			pass.instances[i].transform[0][3] = static_cast<float32>(i);
+		}
+	}
+
+	bool passed = true;
+
+	{ // frustum culling against the CPU implementation
+		CullingVolumes volumes;
+		volumes.reserve(candidateCount);
+		for (const auto& sphere : spheres) {
+			BoundingVolume volume;
+			volume.radius = sphere.w;
+
+			volumes.pushBack(volume, glm::translate(glm::mat4(1.0f), glm::vec3(sphere)));
+		}
+
+		lsd::Vector<uint32> expected;
+		volumes.cull(frustum, expected);
+
+		auto result = runPass(pass, viewProjection, false);
+		passed &= result.valid;
+
+		uint32 mismatches = 0;
+		for (uint32 i = 0; i < candidateCount; i++) {
+			bool cpu = std::binary_search(expected.begin(), expected.end(), i);
+			bool gpu = std::binary_search(result.visible.begin(), result.visible.end(), i);
+
+			if (cpu != gpu && frustumMargin(frustum, spheres[i]) > tolerance) mismatches++;
+		}
+
+		log::info("Frustum culling: {} visible on the CPU, {} visible on the GPU, {} mismatches", expected.size(), result.visible.size(), mismatches);
+		passed &= (mismatches == 0);
+	}
+
+	{ // occlusion culling against a synthetic depth buffer
+		vma::Allocation depthMemory;
+		Image depthImage(
+			Image::imageCreateInfo(Image::Format::r32SFloat, { depthExtent.x, depthExtent.y, 1 }, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT),
+			GPUMemory::getAllocCreateInfo(VMA_MEMORY_USAGE_GPU_ONLY),
+			depthMemory
+		);
+		Image::Resource depthResource(depthImage, { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 });
+
+		{ // upload the depth
+			lsd::Vector<float32> depth(depthExtent.x * depthExtent.y);
+			for (uint32 y = 0; y < depthExtent.y; y++) {
+				for (uint32 x = 0; x < depthExtent.x; x++) depth[y * depthExtent.x + x] = (x < depthExtent.x / 2) ? occluderDepth : 1.0f;
+			}
+
+			GPUBuffer stagingBuffer(depth.size() * sizeof(float32), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+			stagingBuffer.copyData(depth.data());
+
+			renderer::globalRenderSystem->commandQueue->oneTimeBegin();
+			const auto& commandBuffer = *renderer::globalRenderSystem->commandQueue->activeCommandBuffer;
+
+			commandBuffer.pipelineBarrier(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, { }, { },
+				depthImage.imageMemoryBarrier(GPUMemory::Access::none, GPUMemory::Access::transferWrite, Image::Layout::undefined, Image::Layout::transferDst)
+			);
+			commandBuffer.copyBufferToImage(stagingBuffer.buffer, depthImage.image, Image::Layout::transferDst, VkBufferImageCopy {
+				0, 0, 0, { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 }, { 0, 0, 0 }, { depthExtent.x, depthExtent.y, 1 }
+			});
+			commandBuffer.pipelineBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, { }, { },
+				depthImage.imageMemoryBarrier(GPUMemory::Access::transferWrite, GPUMemory::Access::shaderRead, Image::Layout::transferDst, Image::Layout::shaderReadOnly)
+			);
+
+			renderer::globalRenderSystem->commandQueue->oneTimeSubmit();
+		}
+
+		DepthPyramid depthPyramid(depthExtent);
+		depthPyramid.setSource(depthResource.view, depthExtent);
+		pass.setDepthPyramid(depthPyramid);
+
+		auto frustumResult = runPass(pass, viewProjection, false);
+		auto occlusionResult = runPass(pass, viewProjection, true, &depthPyramid);
+		passed &= frustumResult.valid && occlusionResult.valid;
+
+		// occlusion culling may only remove instances and never one which can be seen
+		uint32 wronglyCulled = 0;
+		uint32 wronglyKept = 0;
+		uint32 hidden = 0;
+
+		for (auto i : frustumResult.visible) {
+			bool kept = std::binary_search(occlusionResult.visible.begin(), occlusionResult.visible.end(), i);
+			auto classification = occlusion(viewProjection, spheres[i]);
+
+			if (classification == Occlusion::hidden) hidden++;
+			if (!kept && classification == Occlusion::visible) wronglyCulled++;
+		}
+
+		for (auto i : occlusionResult.visible) {
+			if (!std::binary_search(frustumResult.visible.begin(), frustumResult.visible.end(), i)) wronglyKept++;
+		}
+
+		log::info(
+			"Occlusion culling: {} visible without and {} with the depth pyramid, {} certainly hidden, {} wrongly culled, {} not frustum visible",
+			frustumResult.visible.size(),
+			occlusionResult.visible.size(),
+			hidden,
+			wronglyCulled,
+			wronglyKept
+		);
+
+		// the test is conservative, but the hidden spheres far from the edge of the occluder have to be culled
+		passed &= (wronglyCulled == 0 && wronglyKept == 0 && hidden > 0 && occlusionResult.visible.size() < frustumResult.visible.size());
+	}
 
-	// end recording the command buffer
-	cmdQueue.activeCommandBuffer->end();
-	// submit the compute queue
-	cmdQueue.activeCommandBuffer->submitQueue(lyra::Application::renderSystem.device.computeQueue());
+	log::info("GPU culling {}\n", passed ? "passed" : "failed");
 
-	return 0;
+	return passed ? 0 : 1;
 }
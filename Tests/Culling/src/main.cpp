@@ -0,0 +1,122 @@
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include <Common/Logger.h>
+#include <Common/Benchmark.h>
+
+#include <Math/Culling.h>
+
+#include <LSD/Vector.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace {
+
+constexpr lyra::uint32 volumeCount = 1000 * 1000;
+// the SIMD batches may contract the plane distances into fused multiply adds, so spheres this close to a plane can be classified differently
+constexpr lyra::float32 tolerance = 1e-3f;
+
+// distance of the sphere to the nearest plane it could be classified differently by
+lyra::float32 frustumMargin(const lyra::Frustum& frustum, const glm::vec4& sphere) {
+	auto margin = std::numeric_limits<lyra::float32>::max();
+
+	for (const auto& plane : frustum.planes) {
+		margin = std::min(margin, std::abs(glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w + sphere.w));
+	}
+
+	return margin;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	lyra::initLoggingSystem();
+
+	lyra::CullingVolumes volumes;
+	volumes.reserve(volumeCount);
+
+	{ // scatter spheres of different sizes in a cube around the camera
+		std::mt19937 generator(1234);
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> radius(0.1f, 4.0f);
+
+		for (lyra::uint32 i = 0; i < volumeCount; i++) {
+			lyra::BoundingVolume volume;
+			volume.radius = radius(generator);
+
+			volumes.pushBack(volume, glm::translate(glm::mat4(1.0f), glm::vec3(position(generator), position(generator), position(generator))));
+		}
+	}
+
+	lyra::Frustum frustum(
+		glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f) * 
+		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.5f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f))
+	);
+
+	lsd::Vector<lyra::uint32> scalarVisible;
+	lsd::Vector<lyra::uint32> simdVisible;
+
+	// first pass warms up the caches and the output vectors
+	volumes.cullScalar(frustum, scalarVisible);
+	volumes.cull(frustum, simdVisible);
+
+	{ // scalar reference
+		lyra::log::info("Culling {} volumes one at a time:", volumes.size());
+		lyra::Benchmark b;
+
+		volumes.cullScalar(frustum, scalarVisible);
+	}
+
+	{ // SIMD batches
+		lyra::log::info("Culling {} volumes in SIMD batches:", volumes.size());
+		lyra::Benchmark b;
+
+		volumes.cull(frustum, simdVisible);
+	}
+
+	// both results are in ascending order, so the volumes only one of them contains are found by walking them together
+	lyra::uint32 mismatches = 0;
+	lyra::uint32 borderline = 0;
+
+	auto compare = [&](lyra::uint32 index) {
+		if (frustumMargin(frustum, volumes.sphere(index)) > tolerance) mismatches++;
+		else borderline++;
+	};
+
+	lyra::uint32 scalar = 0, simd = 0;
+	while (scalar < scalarVisible.size() || simd < simdVisible.size()) {
+		if (simd == simdVisible.size() || (scalar < scalarVisible.size() && scalarVisible[scalar] < simdVisible[simd])) compare(scalarVisible[scalar++]);
+		else if (scalar == scalarVisible.size() || simdVisible[simd] < scalarVisible[scalar]) compare(simdVisible[simd++]);
+		else {
+			scalar++;
+			simd++;
+		}
+	}
+
+	lyra::log::info("Visible volumes: {} scalar, {} SIMD, {} mismatches, {} within the tolerance", scalarVisible.size(), simdVisible.size(), mismatches, borderline);
+
+	bool passed = (mismatches == 0);
+
+	{ // a camera outside of the cube looking away from it, both paths have to clear the results of the previous frustum
+		lyra::Frustum away(
+			glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f) * 
+			glm::lookAt(glm::vec3(200.0f, 0.0f, 0.0f), glm::vec3(300.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f))
+		);
+
+		volumes.cullScalar(away, scalarVisible);
+		volumes.cull(away, simdVisible);
+
+		lyra::log::info("Visible volumes while looking away: {} scalar, {} SIMD", scalarVisible.size(), simdVisible.size());
+
+		passed &= scalarVisible.empty() && simdVisible.empty();
+	}
+
+	lyra::log::info("Culling {}\n", passed ? "passed" : "failed");
+
+	return passed ? 0 : 1;
+}
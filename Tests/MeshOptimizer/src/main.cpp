@@ -0,0 +1,219 @@
+#include <Common/Logger.h>
+
+#include <Graphics/Mesh.h>
+
+#include <MeshOptimizer.h>
+#include <MeshGrid.h>
+
+#include <LSD/Vector.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+constexpr lyra::uint32 gridSize = 64; // quads per side
+
+// the grid with every triangle unindexed into its own three vertices, in a random order
+void buildShuffledGrid(lsd::Vector<lyra::Mesh::Vertex>& vertices, lsd::Vector<lyra::uint32>& indices) {
+	lsd::Vector<lyra::Mesh::Vertex> corners;
+	lsd::Vector<lyra::uint32> triangles;
+	test::buildGrid(corners, triangles, gridSize);
+
+	// only the order of the triangles is shuffled, not the order of the corners inside of them
+	lsd::Vector<lyra::uint32> order(triangles.size() / 3);
+	for (lyra::uint32 i = 0; i < order.size(); i++) order[i] = i;
+	std::shuffle(order.begin(), order.end(), std::mt19937(1234));
+
+	for (auto triangle : order) {
+		for (lyra::uint32 j = 0; j < 3; j++) {
+			indices.pushBack(static_cast<lyra::uint32>(vertices.size()));
+			vertices.pushBack(corners[triangles[triangle * 3 + j]]);
+		}
+	}
+}
+
+// a box of six grids around the origin, facing inwards or outwards
+void buildBox(lsd::Vector<lyra::Mesh::Vertex>& vertices, lsd::Vector<lyra::uint32>& indices, lyra::float32 halfExtent, bool inwards) {
+	// the outward normal and the two axes of every side, their cross product is the normal
+	const glm::vec3 sides[6][3] = {
+		{ { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } },
+		{ { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },
+		{ { 0, 1, 0 }, { 0, 0, 1 }, { 1, 0, 0 } },
+		{ { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } },
+		{ { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 } },
+		{ { 0, 0, -1 }, { 0, 1, 0 }, { 1, 0, 0 } }
+	};
+
+	constexpr lyra::uint32 sideSize = 8;
+	auto step = 2.0f * halfExtent / sideSize;
+
+	for (const auto& [normal, right, up] : sides) {
+		auto origin = (normal - right - up) * halfExtent;
+
+		// swapping the axes flips the winding and with it the facing of the side
+		if (inwards) test::buildGrid(vertices, indices, sideSize, origin, up * step, right * step);
+		else test::buildGrid(vertices, indices, sideSize, origin, right * step, up * step);
+	}
+}
+
+// if the triangle faces away from the center of the mesh
+bool facesOutwards(const lsd::Vector<lyra::Mesh::Vertex>& vertices, const lyra::uint32* triangle) {
+	const auto& p0 = vertices[triangle[0]].pos;
+	const auto& p1 = vertices[triangle[1]].pos;
+	const auto& p2 = vertices[triangle[2]].pos;
+
+	return glm::dot(p0 + p1 + p2, glm::cross(p1 - p0, p2 - p0)) > 0.0f;
+}
+
+// the sorted triangles by their indices, rotated to start at their smallest index, so the winding is kept
+lsd::Vector<lyra::uint64> indexedTriangleSet(const lsd::Vector<lyra::uint32>& indices) {
+	lsd::Vector<lyra::uint64> triangles;
+
+	for (lyra::uint32 i = 0; i + 2 < indices.size(); i += 3) {
+		lyra::uint64 corners[3] = { indices[i], indices[i + 1], indices[i + 2] };
+
+		std::rotate(corners, std::min_element(corners, corners + 3), corners + 3);
+		triangles.pushBack((corners[0] << 42) | (corners[1] << 21) | corners[2]);
+	}
+
+	std::sort(triangles.begin(), triangles.end());
+
+	return triangles;
+}
+
+// if the statistics agree on the number of transformed vertices
+bool consistent(const mesh::Statistics& statistics, lyra::uint32 triangleCount, lyra::uint32 vertexCount) {
+	return std::abs(statistics.acmr * triangleCount - statistics.atvr * vertexCount) < 0.5f;
+}
+
+// the sorted triangles by the grid corners they reference, rotated to start at their smallest corner, so the winding is kept
+lsd::Vector<lyra::uint64> triangleSet(const lsd::Vector<lyra::Mesh::Vertex>& vertices, const lsd::Vector<lyra::uint32>& indices) {
+	lsd::Vector<lyra::uint64> triangles;
+
+	for (lyra::uint32 i = 0; i + 2 < indices.size(); i += 3) {
+		lyra::uint64 corners[3];
+		for (lyra::uint32 j = 0; j < 3; j++) {
+			const auto& pos = vertices[indices[i + j]].pos;
+			corners[j] = static_cast<lyra::uint64>(pos.y) * (gridSize + 1) + static_cast<lyra::uint64>(pos.x);
+		}
+
+		std::rotate(corners, std::min_element(corners, corners + 3), corners + 3);
+		triangles.pushBack((corners[0] << 42) | (corners[1] << 21) | corners[2]);
+	}
+
+	std::sort(triangles.begin(), triangles.end());
+
+	return triangles;
+}
+
+bool sameTriangles(const lsd::Vector<lyra::uint64>& first, const lsd::Vector<lyra::uint64>& second) {
+	return first.size() == second.size() && std::equal(first.begin(), first.end(), second.begin());
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	lyra::initLoggingSystem();
+
+	lsd::Vector<lyra::Mesh::Vertex> vertices;
+	lsd::Vector<lyra::uint32> indices;
+	buildShuffledGrid(vertices, indices);
+
+	auto reference = triangleSet(vertices, indices);
+	bool passed = true;
+
+	mesh::deduplicate(vertices, indices);
+
+	passed &= (vertices.size() == (gridSize + 1) * (gridSize + 1));
+	passed &= sameTriangles(triangleSet(vertices, indices), reference);
+
+	auto vertexCount = static_cast<lyra::uint32>(vertices.size());
+	auto triangleCount = static_cast<lyra::uint32>(indices.size() / 3);
+
+	// every vertex of a single triangle is transformed exactly once
+	lsd::Vector<lyra::uint32> triangle;
+	for (lyra::uint32 i = 0; i < 3; i++) triangle.pushBack(i);
+
+	auto single = mesh::analyzeVertexCache(triangle, 3);
+	passed &= (single.acmr == 3.0f && single.atvr == 1.0f);
+
+	auto shuffled = mesh::analyzeVertexCache(indices, vertexCount);
+	lyra::log::info("Deduplicated to {} vertices, ACMR of the shuffled triangles: {}, ATVR: {}", vertexCount, shuffled.acmr, shuffled.atvr);
+
+	passed &= consistent(shuffled, triangleCount, vertexCount);
+
+	mesh::optimizeVertexCache(indices, vertexCount);
+
+	auto optimized = mesh::analyzeVertexCache(indices, vertexCount);
+	lyra::log::info("ACMR after the vertex cache optimization: {}, ATVR: {}", optimized.acmr, optimized.atvr);
+
+	// every vertex is referenced after the deduplication, so each one is transformed at least once
+	passed &= (optimized.acmr < shuffled.acmr);
+	passed &= (optimized.atvr < shuffled.atvr && optimized.atvr >= 1.0f);
+	passed &= consistent(optimized, triangleCount, vertexCount);
+	passed &= sameTriangles(triangleSet(vertices, indices), reference);
+
+	mesh::optimizeOverdraw(indices, vertices);
+
+	auto sorted = mesh::analyzeVertexCache(indices, vertexCount);
+	lyra::log::info("ACMR after the overdraw optimization: {}, ATVR: {}", sorted.acmr, sorted.atvr);
+
+	passed &= (sorted.acmr < shuffled.acmr);
+	passed &= sameTriangles(triangleSet(vertices, indices), reference);
+
+	// one vertex nothing references, which has to be removed
+	vertices.emplaceBack(glm::vec3(-1.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f), glm::vec3(0.0f));
+
+	mesh::optimizeVertexFetch(vertices, indices);
+
+	lsd::Vector<lyra::uint8> referenced(vertices.size(), 0);
+	for (auto index : indices) {
+		if (index < vertices.size()) referenced[index] = 1;
+		else passed = false;
+	}
+
+	passed &= std::all_of(referenced.begin(), referenced.end(), [](lyra::uint8 value) { return value != 0; });
+	passed &= sameTriangles(triangleSet(vertices, indices), reference);
+
+	// renaming the vertices does not change which of them are in the cache
+	auto fetched = mesh::analyzeVertexCache(indices, static_cast<lyra::uint32>(vertices.size()));
+	passed &= (vertices.size() == vertexCount && fetched.acmr == sorted.acmr && fetched.atvr == sorted.atvr);
+
+	// a box facing inwards inside of a box facing outwards, the inner one is listed first so the overdraw optimization has to move it
+	lsd::Vector<lyra::Mesh::Vertex> boxVertices;
+	lsd::Vector<lyra::uint32> boxIndices;
+	buildBox(boxVertices, boxIndices, 1.0f, true);
+	buildBox(boxVertices, boxIndices, 2.0f, false);
+
+	auto boxVertexCount = static_cast<lyra::uint32>(boxVertices.size());
+	auto boxReference = indexedTriangleSet(boxIndices);
+
+	mesh::optimizeVertexCache(boxIndices, boxVertexCount);
+	mesh::optimizeOverdraw(boxIndices, boxVertices);
+
+	passed &= sameTriangles(indexedTriangleSet(boxIndices), boxReference);
+
+	// the sides of the boxes share no vertices, so no cluster contains both, and every outwards facing one has to come first
+	lyra::uint32 outwardTriangles = 0;
+	bool inwardSeen = false;
+
+	for (lyra::uint32 i = 0; i + 2 < boxIndices.size(); i += 3) {
+		if (facesOutwards(boxVertices, &boxIndices[i])) {
+			passed &= !inwardSeen;
+			outwardTriangles++;
+		} else inwardSeen = true;
+	}
+
+	passed &= (outwardTriangles * 2 == boxIndices.size() / 3);
+
+	auto box = mesh::analyzeVertexCache(boxIndices, boxVertexCount);
+	lyra::log::info("Sorted {} outwards facing triangles of the boxes first, ACMR: {}, ATVR: {}", outwardTriangles, box.acmr, box.atvr);
+
+	lyra::log::info("Mesh optimizer {}\n", passed ? "passed" : "failed");
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+#include <Common/Logger.h>
+#include <Common/Config.h>
+
+#include <Graphics/Mesh.h>
+
+#include <MeshSimplifier.h>
+#include <MeshGrid.h>
+
+#include <LSD/Vector.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr lyra::uint32 gridSize = 32; // quads per side of each half
+
+// two halves of a gently curved height field next to each other, their texture coordinates differ where they meet, so they form a seam
+void buildTerrain(lsd::Vector<lyra::Mesh::Vertex>& vertices, lsd::Vector<lyra::uint32>& indices) {
+	test::buildGrid(vertices, indices, gridSize);
+	test::buildGrid(vertices, indices, gridSize, glm::vec3(gridSize, 0.0f, 0.0f));
+
+	// the height only depends on the position, so the vertices of the seam keep sharing theirs
+	for (auto& vertex : vertices) vertex.pos.z = 1.5f * std::sin(vertex.pos.x * 0.15f) * std::cos(vertex.pos.y * 0.15f);
+}
+
+// vertices on the outline of the terrain or on the seam between its halves
+bool pinned(const lyra::Mesh::Vertex& vertex) {
+	return vertex.pos.x == 0.0f || vertex.pos.x == gridSize || vertex.pos.x == 2.0f * gridSize || vertex.pos.y == 0.0f || vertex.pos.y == gridSize;
+}
+
+// if every triangle still faces upwards like the height field it was simplified from
+bool facesUpwards(const lsd::Vector<lyra::Mesh::Vertex>& vertices, const lsd::Vector<lyra::uint32>& indices) {
+	for (lyra::uint32 i = 0; i + 2 < indices.size(); i += 3) {
+		const auto& p0 = vertices[indices[i]].pos;
+		const auto& p1 = vertices[indices[i + 1]].pos;
+		const auto& p2 = vertices[indices[i + 2]].pos;
+
+		if (glm::cross(p1 - p0, p2 - p0).z <= 0.0f) return false;
+	}
+
+	return true;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	lyra::initLoggingSystem();
+
+	bool passed = true;
+
+	// collapses inside of a flat patch do not change its surface, so it simplifies without any error
+	{
+		lsd::Vector<lyra::Mesh::Vertex> vertices;
+		lsd::Vector<lyra::uint32> indices;
+		test::buildGrid(vertices, indices, gridSize);
+
+		lyra::float32 error;
+		auto simplified = mesh::simplify(vertices, indices, static_cast<lyra::uint32>(indices.size() / 4), 0.0f, error);
+
+		lyra::log::info("Simplified a flat patch from {} to {} triangles", indices.size() / 3, simplified.size() / 3);
+
+		passed &= (error == 0.0f);
+		passed &= (simplified.size() < indices.size() && simplified.size() % 3 == 0);
+		passed &= facesUpwards(vertices, simplified);
+	}
+
+	lsd::Vector<lyra::Mesh::Vertex> vertices;
+	lsd::Vector<lyra::uint32> indices;
+	buildTerrain(vertices, indices);
+
+	auto lods = mesh::generateLods(vertices, indices, lyra::config::maxMeshLods);
+
+	passed &= (lods.size() > 1 && lods.size() <= lyra::config::maxMeshLods);
+	passed &= (lods[0].indices.size() == indices.size() && lods[0].error == 0.0f);
+
+	lsd::Vector<lyra::uint8> referenced(vertices.size());
+
+	for (lyra::uint32 level = 0; level < lods.size(); level++) {
+		const auto& lod = lods[level];
+
+		lyra::log::info("Level of detail {}: {} triangles, error {}", level, lod.indices.size() / 3, lod.error);
+
+		passed &= (lod.indices.size() % 3 == 0);
+		passed &= (lod.error <= mesh::maxLodError);
+		passed &= facesUpwards(vertices, lod.indices);
+
+		if (level > 0) {
+			passed &= (lod.indices.size() < lods[level - 1].indices.size());
+			passed &= (lod.error >= lods[level - 1].error);
+		}
+
+		std::fill(referenced.begin(), referenced.end(), 0);
+		for (auto index : lod.indices) {
+			if (index < vertices.size()) referenced[index] = 1;
+			else passed = false;
+		}
+
+		// vertices are never moved, so the outline and the seam only stay put if none of their vertices were collapsed away
+		for (lyra::uint32 i = 0; i < vertices.size(); i++) {
+			if (pinned(vertices[i])) passed &= (referenced[i] != 0);
+		}
+	}
+
+	lyra::log::info("Mesh simplifier {}\n", passed ? "passed" : "failed");
+
+	return passed ? 0 : 1;
+}
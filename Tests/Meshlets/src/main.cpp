@@ -0,0 +1,74 @@
+#include <Common/Logger.h>
+#include <Common/Config.h>
+
+#include <Graphics/Mesh.h>
+
+#include <Math/Culling.h>
+
+#include <MeshletBuilder.h>
+#include <MeshGrid.h>
+
+#include <LSD/Vector.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+
+namespace {
+
+constexpr lyra::uint32 gridSize = 64; // quads per side
+
+}
+
+int main(int argc, char* argv[]) {
+	lyra::initLoggingSystem();
+
+	lsd::Vector<lyra::Mesh::Vertex> vertices;
+	lsd::Vector<lyra::uint32> indices;
+	// a flat patch in the xy plane, facing towards positive z
+	test::buildGrid(vertices, indices, gridSize);
+
+	auto meshlets = mesh::buildMeshlets(vertices, indices);
+
+	bool passed = !meshlets.empty();
+
+	glm::vec3 front(gridSize / 2.0f, gridSize / 2.0f, 10.0f);
+	glm::vec3 behind(gridSize / 2.0f, gridSize / 2.0f, -1000.0f);
+
+	lyra::uint32 nextIndex = 0;
+	lyra::uint32 largestVertexCount = 0;
+	lsd::Vector<lyra::uint32> unique;
+
+	for (const auto& meshlet : meshlets) {
+		// the meshlets have to follow each other without gaps or overlaps
+		passed &= (meshlet.firstIndex == nextIndex);
+		passed &= (meshlet.indexCount > 0 && meshlet.indexCount % 3 == 0);
+		nextIndex = meshlet.firstIndex + meshlet.indexCount;
+
+		if (nextIndex > indices.size()) {
+			passed = false;
+			break;
+		}
+
+		unique.clear();
+		for (auto i = meshlet.firstIndex; i < nextIndex; i++) unique.pushBack(indices[i]);
+		std::sort(unique.begin(), unique.end());
+		auto vertexCount = static_cast<lyra::uint32>(std::unique(unique.begin(), unique.end()) - unique.begin());
+
+		largestVertexCount = std::max(largestVertexCount, vertexCount);
+
+		passed &= (vertexCount <= lyra::config::maxMeshletVertices);
+		passed &= (meshlet.indexCount / 3 <= lyra::config::maxMeshletTriangles);
+
+		// every triangle of the patch faces the camera in front of it, the one far behind it sees none of them
+		passed &= !meshlet.backfacing(front);
+		passed &= meshlet.backfacing(behind);
+	}
+
+	passed &= (nextIndex == indices.size());
+
+	lyra::log::info("Split {} triangles into {} meshlets, at most {} vertices per meshlet", indices.size() / 3, meshlets.size(), largestVertexCount);
+	lyra::log::info("Meshlet builder {}\n", passed ? "passed" : "failed");
+
+	return passed ? 0 : 1;
+}
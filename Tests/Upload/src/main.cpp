@@ -0,0 +1,86 @@
+#include <Lyra/Lyra.h>
+#include <Common/Common.h>
+#include <Common/Logger.h>
+
+#include <Graphics/VulkanRenderSystem.h>
+
+#include <LSD/Vector.h>
+
+#include <cstring>
+
+namespace lyra {
+
+namespace renderer {
+
+extern vulkan::RenderSystem* globalRenderSystem;
+
+}
+
+}
+
+namespace {
+
+// a scaled down version of the default ring, the sizes of the uploads keep the same ratios to it
+constexpr VkDeviceSize stagingSize = 1024 * 1024;
+constexpr VkDeviceSize firstSize = stagingSize / 32 * 10;
+constexpr VkDeviceSize secondSize = stagingSize / 32 * 21;
+
+// uploads a pattern into a host visible buffer and checks it after the upload queue has finished
+bool upload(lyra::vulkan::UploadQueue& uploads, VkDeviceSize size, lyra::uint8 seed) {
+	using namespace lyra;
+	using namespace lyra::vulkan;
+
+	lsd::Vector<uint8> data(size);
+	for (VkDeviceSize i = 0; i < size; i++) data[i] = static_cast<uint8>(i * 31 + seed);
+
+	GPUBuffer buffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
+
+	uploads.copy(buffer, data.data(), size);
+	uploads.commandBuffer().pipelineBarrier(
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT,
+		0,
+		{ VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT }
+	);
+	uploads.wait();
+
+	void* mapped;
+	VULKAN_ASSERT(renderer::globalRenderSystem->mapMemory(buffer.memory, &mapped), "map upload test buffer memory");
+	VULKAN_ASSERT(renderer::globalRenderSystem->invalidateAllocation(buffer.memory, 0, VK_WHOLE_SIZE), "invalidate upload test buffer memory");
+
+	bool valid = std::memcmp(mapped, data.data(), size) == 0;
+
+	renderer::globalRenderSystem->unmapMemory(buffer.memory);
+
+	return valid;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	using namespace lyra;
+	using namespace lyra::vulkan;
+
+	lyra::init(lyra::InitFlags::all, { argc, argv });
+
+	UploadQueue uploads(stagingSize);
+
+	bool passed = true;
+
+	// moves the head of the ring away from the start of the staging buffer
+	passed &= upload(uploads, firstSize, 1);
+	log::info("Uploaded {} bytes, ring head at {} of {} bytes", firstSize, uploads.stagingHead % stagingSize, stagingSize);
+
+	// does not fit behind the head and is larger than it, so it has to start over at the beginning of the drained ring
+	passed &= upload(uploads, secondSize, 2);
+	log::info("Uploaded {} bytes, ring head at {} of {} bytes", secondSize, uploads.stagingHead % stagingSize, stagingSize);
+
+	passed &= (uploads.stagingHead % stagingSize == secondSize);
+
+	// larger than the ring, goes through a temporary staging buffer
+	passed &= upload(uploads, stagingSize * 2, 3);
+
+	log::info("Upload queue {}\n", passed ? "passed" : "failed");
+
+	return passed ? 0 : 1;
+}
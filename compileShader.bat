@@ -7,6 +7,8 @@ C:/VulkanSDK/1.3.280.0/Bin/glslc.exe LyraEngine/src/Shaders/src/cubemap.vert -o
 C:/VulkanSDK/1.3.280.0/Bin/glslc.exe LyraEngine/src/Shaders/src/cubemap.frag -o data/shader/cubemapFrag.spv
 C:/VulkanSDK/1.3.280.0/Bin/glslc.exe LyraEngine/src/Shaders/src/skybox.vert -o data/shader/skyboxVert.spv
 C:/VulkanSDK/1.3.280.0/Bin/glslc.exe LyraEngine/src/Shaders/src/skybox.frag -o data/shader/skyboxFrag.spv
-C:/VulkanSDK/1.3.280.0/Bin/glslc.exe LyraEngine/src/Shaders/src/compute.comp -o data/shader/compute.spv
+C:/VulkanSDK/1.3.280.0/Bin/glslc.exe LyraEngine/src/Shaders/src/cull.comp -o data/shader/cull.spv
+C:/VulkanSDK/1.3.280.0/Bin/glslc.exe LyraEngine/src/Shaders/src/cullCompact.comp -o data/shader/cullCompact.spv
+C:/VulkanSDK/1.3.280.0/Bin/glslc.exe LyraEngine/src/Shaders/src/depthPyramid.comp -o data/shader/depthPyramid.spv
 
 pause
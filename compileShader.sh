@@ -7,4 +7,6 @@
 /usr/local/bin/glslc LyraEngine/src/Shaders/src/cubemap.frag -o data/shader/cubemapFrag.spv
 /usr/local/bin/glslc LyraEngine/src/Shaders/src/skybox.vert -o data/shader/skyboxVert.spv
 /usr/local/bin/glslc LyraEngine/src/Shaders/src/skybox.frag -o data/shader/skyboxFrag.spv
-/usr/local/bin/glslc LyraEngine/src/Shaders/src/compute.comp -o data/shader/compute.spv
+/usr/local/bin/glslc LyraEngine/src/Shaders/src/cull.comp -o data/shader/cull.spv
+/usr/local/bin/glslc LyraEngine/src/Shaders/src/cullCompact.comp -o data/shader/cullCompact.spv
+/usr/local/bin/glslc LyraEngine/src/Shaders/src/depthPyramid.comp -o data/shader/depthPyramid.spv